@@ -0,0 +1,123 @@
+// backtest.c - headless backtest of a moving-average crossover over the
+// portfolio core. Sweeps a grid of fast/slow EMA lengths, one run per
+// parameter set, all cores in parallel, each on the same seeded random walk
+// the app animates, and prints trade stats per run plus total throughput.
+// With a path, the best run's equity curve is written as CSV.
+//
+// build: gcc -O2 bench/backtest.c src/backtest.c src/portfolio.c src/lots.c src/candles.c src/candlestore.c src/money.c src/platform.c -Isrc -o backtest.exe
+// run:   ./backtest.exe [ticks] [equity.csv]   (default 1000000 ticks per run)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "backtest.h"
+
+#define FAST_N 6
+#define SLOW_N 6
+
+typedef struct { int fast, slow; } CrossParams;
+
+typedef struct {
+    double fast[PORTFOLIO_MAX_STOCKS], slow[PORTFOLIO_MAX_STOCKS];
+    bool   primed;
+} CrossState;
+
+// Long when the fast EMA is above the slow one: buy with a third of the cash
+// on the cross up, sell everything on the cross down.
+static void crossover(Backtest* bt, const void* params, void* state) {
+    const CrossParams* cp = (const CrossParams*)params;
+    CrossState* st = (CrossState*)state;
+    const Portfolio* p = backtestPortfolio(bt);
+    double af = 2.0 / (cp->fast + 1), as = 2.0 / (cp->slow + 1);
+    for (int i = 0; i < p->count; ++i) {
+        double px = moneyToDouble(p->pos[i].price);
+        if (!st->primed) { st->fast[i] = st->slow[i] = px; continue; }
+        bool wasAbove = st->fast[i] > st->slow[i];
+        st->fast[i] += af * (px - st->fast[i]);
+        st->slow[i] += as * (px - st->slow[i]);
+        bool above = st->fast[i] > st->slow[i];
+        if (above && !wasAbove) {
+            int qty = (int)(moneyToDouble(p->cash) / 3.0 / px);
+            if (qty > 0) backtestOrder(bt, i, qty);
+        } else if (!above && wasAbove && p->pos[i].qty > 0) {
+            backtestOrder(bt, i, -p->pos[i].qty);
+        }
+    }
+    st->primed = true;
+}
+
+static double wallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    long ticks = (argc > 1) ? atol(argv[1]) : 1000000L;
+    const char* csv = (argc > 2) ? argv[2] : NULL;
+    static const int fastLen[FAST_N] = { 4, 8, 12, 16, 24, 32 };
+    static const int slowLen[SLOW_N] = { 40, 60, 90, 120, 180, 240 };
+
+    BacktestSpec spec = {
+        .stocks = 3,
+        .symbols = { "AAPL", "MSFT", "NVDA" },
+        .openPrices = { MONEY_UNITS(180), MONEY_UNITS(330), MONEY_UNITS(900) },
+        .cash = MONEY_UNITS(10000),
+        .relief = RELIEF_FIFO,
+        .lotCapacity = 4096,
+        .candleDt = 60.0,
+        .tick = randomWalkTick,
+        .strategy = crossover,
+        .stateSize = sizeof(CrossState),
+    };
+
+    enum { RUNS = FAST_N * SLOW_N };
+    static CrossParams params[RUNS];
+    static RandomWalkSource sources[RUNS];
+    static BacktestRun runs[RUNS];
+    for (int k = 0; k < RUNS; ++k) {
+        params[k] = (CrossParams){ fastLen[k / SLOW_N], slowLen[k % SLOW_N] };
+        randomWalkInit(&sources[k], &spec, 12345, ticks, 0.25);
+        runs[k].source = &sources[k];
+        runs[k].params = &params[k];
+    }
+
+    double t0 = wallSeconds();
+    backtestRunAll(&spec, runs, RUNS, 0);
+    double secs = wallSeconds() - t0;
+
+    char eq[32], dd[32], rz[32];
+    int best = -1;
+    long long totalTicks = 0;
+    printf("fast slow   orders  sells  win%%      realized        equity      max dd   return\n");
+    for (int k = 0; k < RUNS; ++k) {
+        const BacktestResult* r = &runs[k].result;
+        if (!runs[k].ok) { printf("%4d %4d   out of memory\n", params[k].fast, params[k].slow); continue; }
+        totalTicks += r->ticks;
+        moneyFormat(eq, sizeof(eq), r->finalEquity);
+        moneyFormat(dd, sizeof(dd), r->maxDrawdown);
+        moneyFormat(rz, sizeof(rz), r->realized);
+        printf("%4d %4d %8ld %6ld %5.1f %13s %13s %11s %7.2f%%\n", params[k].fast, params[k].slow,
+               r->orders, r->sells, r->sells ? 100.0 * r->winningSells / r->sells : 0.0,
+               rz, eq, dd, r->totalReturn * 100.0);
+        if (best < 0 || r->finalEquity > runs[best].result.finalEquity) best = k;
+    }
+    printf("%d runs, %lld ticks in %.2f s: %.1f M ticks/s\n", RUNS, totalTicks, secs, totalTicks / secs / 1e6);
+
+    if (csv && best >= 0) {
+        FILE* f = fopen(csv, "w");
+        if (!f) { fprintf(stderr, "cannot write %s\n", csv); return 1; }
+        CandleStore* st = &runs[best].result.equity;
+        Candle c[CANDLE_BLOCK_SIZE];
+        fprintf(f, "time,open,high,low,close\n");
+        for (long from = 0; from < st->total; from += CANDLE_BLOCK_SIZE) {
+            int n = candleStoreRead(st, from, CANDLE_BLOCK_SIZE, c);
+            for (int k = 0; k < n; ++k)
+                fprintf(f, "%.0f,%.2f,%.2f,%.2f,%.2f\n", c[k].time, c[k].open, c[k].high, c[k].low, c[k].close);
+        }
+        fclose(f);
+        printf("equity curve of fast %d / slow %d: %ld candles -> %s\n",
+               params[best].fast, params[best].slow, st->total, csv);
+    }
+    for (int k = 0; k < RUNS; ++k) if (runs[k].ok) backtestResultFree(&runs[k].result);
+    return 0;
+}
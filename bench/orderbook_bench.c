@@ -0,0 +1,83 @@
+// orderbook_bench.c - headless stress test for the limit order book.
+// Drives one book with a random mix of limit orders, cancels and trade prints
+// around a drifting mid price and reports order events per second.
+//
+// build: gcc -O2 bench/orderbook_bench.c src/orderbook.c -Isrc -o obbench.exe
+// run:   ./obbench.exe [events]   (default 20000000)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "orderbook.h"
+
+#define LEVELS     20000          // $100.00 .. $300.00 in 1 cent ticks
+#define MAX_ORDERS (1 << 20)
+#define LIVE_CAP   (1 << 16)      // resting ids tracked for cancels
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+static inline uint32_t nextRand(void) {       // xorshift64*
+    rng ^= rng >> 12; rng ^= rng << 25; rng ^= rng >> 27;
+    return (uint32_t)((rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static long long fillCount = 0, fillQty = 0;
+static void onFill(const BookFill* f, void* user) {
+    (void)user;
+    fillCount++;
+    fillQty += f->qty;
+}
+
+int main(int argc, char** argv) {
+    long long events = (argc > 1) ? atoll(argv[1]) : 20000000LL;
+    const Money minPrice = MONEY_UNITS(100), tick = MONEY_ONE / 100;
+    OrderBook* b = orderBookCreate(minPrice, tick, LEVELS, MAX_ORDERS);
+    OrderId* live = (OrderId*)malloc(LIVE_CAP * sizeof(OrderId));
+    if (!b || !live) { fprintf(stderr, "out of memory\n"); return 1; }
+    orderBookSetFillHandler(b, onFill, NULL);
+
+    int liveLen = 0;
+    int mid = LEVELS / 2;
+    long long limits = 0, cancels = 0, ticks = 0;
+    clock_t t0 = clock();
+    for (long long e = 0; e < events; ++e) {
+        uint32_t r = nextRand();
+        uint32_t kind = r % 100;
+        if (kind < 55) {
+            // Limit order within 50 ticks of mid; a few cross and fill on entry
+            BookSide side = (r >> 8) & 1 ? BOOK_SELL : BOOK_BUY;
+            int off = (int)((r >> 9) % 50);
+            int level = (side == BOOK_BUY) ? mid - off + 2 : mid + off - 2;
+            OrderId id = orderBookLimit(b, side, minPrice + tick * level, 1 + (int32_t)((r >> 16) % 200), 0, NULL);
+            if (id && liveLen < LIVE_CAP) live[liveLen++] = id;
+            limits++;
+        } else if (kind < 90) {
+            // Cancel a random tracked order (it may already have filled)
+            if (liveLen > 0) {
+                int k = (int)(nextRand() % (uint32_t)liveLen);
+                orderBookCancel(b, live[k]);
+                live[k] = live[--liveLen];
+            }
+            cancels++;
+        } else {
+            // Trade print near mid; the mid drifts by a tick now and then
+            if ((r >> 8) % 4 == 0) mid += ((r >> 10) & 1) ? 1 : -1;
+            if (mid < 100) mid = 100;
+            if (mid > LEVELS - 100) mid = LEVELS - 100;
+            int level = mid + (int)((r >> 11) % 7) - 3;
+            orderBookMatchTick(b, minPrice + tick * level, 1 + (int64_t)((r >> 16) % 500));
+            ticks++;
+        }
+    }
+    double secs = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+    Money bid = 0, ask = 0;
+    bool hasBid = orderBookBestBid(b, &bid), hasAsk = orderBookBestAsk(b, &ask);
+    printf("events:  %lld (%lld limits, %lld cancels, %lld ticks)\n", events, limits, cancels, ticks);
+    printf("fills:   %lld (%lld shares)\n", fillCount, fillQty);
+    printf("resting: %d  bid %.2f  ask %.2f\n", orderBookCount(b),
+           hasBid ? moneyToDouble(bid) : 0.0, hasAsk ? moneyToDouble(ask) : 0.0);
+    printf("time:    %.3f s  ->  %.2f M events/s\n", secs, secs > 0 ? events / secs / 1e6 : 0.0);
+
+    free(live);
+    orderBookFree(b);
+    return 0;
+}
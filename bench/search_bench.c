@@ -0,0 +1,108 @@
+// search_bench.c - headless timing of the symbol search index.
+// Builds a synthetic universe of random tickers and made-up company names and
+// reports build time and the mean latency of a mix of top-10 queries. Given a
+// master path it first writes the universe as a symbol master, maps it back
+// and indexes the strings in the mapping, as the app does at startup.
+//
+// build: gcc -O2 bench/search_bench.c src/symbolindex.c src/symbolmaster.c src/platform.c -Isrc -o searchbench.exe
+// run:   ./searchbench.exe [symbols] [master]   (default 100000, no master)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "symbolindex.h"
+#include "symbolmaster.h"
+
+#define TOP_K   10
+#define REPEAT  200
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+static inline uint32_t nextRand(void) {       // xorshift64*
+    rng ^= rng >> 12; rng ^= rng << 25; rng ^= rng >> 27;
+    return (uint32_t)((rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static const char* const SYLLABLES[] = {
+    "al", "ben", "cor", "dyn", "el", "fin", "gen", "hal", "in", "jet", "kor", "lum",
+    "mar", "nov", "or", "pax", "quin", "ra", "sol", "tek", "ul", "ver", "wex", "zen",
+};
+static const char* const SUFFIXES[] = {
+    " Inc.", " Corp.", " Holdings", " Group", " Systems", " Energy", " Bank", " Pharma", " Capital", " Ltd.",
+};
+static const char* const SECTORS[] = {
+    "Technology", "Financials", "Health Care", "Energy", "Industrials", "Utilities", "Materials",
+};
+static const char* const EXCHANGES[] = { "NASDAQ", "NYSE", "LSE", "XETRA" };
+#define COUNT(a) (int)(sizeof(a) / sizeof((a)[0]))
+
+int main(int argc, char** argv) {
+    int n = (argc > 1) ? atoi(argv[1]) : 100000;
+    if (n <= 0) n = 100000;
+    char (*symBuf)[8]   = malloc((size_t)n * sizeof(*symBuf));
+    char (*nameBuf)[48] = malloc((size_t)n * sizeof(*nameBuf));
+    const char** symbols = malloc((size_t)n * sizeof(char*));
+    const char** names   = malloc((size_t)n * sizeof(char*));
+    uint32_t out[TOP_K];
+    if (!symBuf || !nameBuf || !symbols || !names) { fprintf(stderr, "out of memory\n"); return 1; }
+
+    for (int i = 0; i < n; ++i) {
+        int len = 1 + (int)(nextRand() % 5);
+        for (int k = 0; k < len; ++k) symBuf[i][k] = (char)('A' + nextRand() % 26);
+        symBuf[i][len] = '\0';
+        char* s = nameBuf[i];
+        int words = 2 + (int)(nextRand() % 3);
+        s[0] = '\0';
+        for (int w = 0; w < words; ++w) strcat(s, SYLLABLES[nextRand() % COUNT(SYLLABLES)]);
+        s[0] = (char)(s[0] - 'a' + 'A');
+        strcat(s, SUFFIXES[nextRand() % COUNT(SUFFIXES)]);
+        symbols[i] = symBuf[i];
+        names[i] = nameBuf[i];
+    }
+
+    clock_t t0;
+    SymbolMaster* master = NULL;
+    if (argc > 2) {
+        SymbolInfo* infos = malloc((size_t)n * sizeof(SymbolInfo));
+        if (!infos) { fprintf(stderr, "out of memory\n"); return 1; }
+        for (int i = 0; i < n; ++i)
+            infos[i] = (SymbolInfo){ symbols[i], names[i], SECTORS[nextRand() % COUNT(SECTORS)],
+                                     EXCHANGES[nextRand() % COUNT(EXCHANGES)], 1 + (int)(nextRand() % 2) * 99 };
+        t0 = clock();
+        bool written = symbolMasterWrite(argv[2], infos, n);
+        double writeMs = (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC;
+        free(infos);
+        t0 = clock();
+        master = written ? symbolMasterOpen(argv[2]) : NULL;
+        double openMs = (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC;
+        if (!master) { fprintf(stderr, "could not write or map %s\n", argv[2]); return 1; }
+        n = symbolMasterCount(master);          // duplicates kept, order now by symbol
+        for (int i = 0; i < n; ++i) {
+            symbols[i] = symbolMasterSymbol(master, i);
+            names[i]   = symbolMasterName(master, i);
+        }
+        printf("master: %s  write %.1f ms  open %.3f ms\n", argv[2], writeMs, openMs);
+    }
+
+    t0 = clock();
+    SymbolIndex* ix = symbolIndexBuild(symbols, names, n);
+    double buildMs = (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC;
+    if (!ix) { fprintf(stderr, "out of memory\n"); return 1; }
+    printf("symbols: %d  build %.1f ms\n", n, buildMs);
+
+    static const char* const QUERIES[] = {
+        "A", "M", "AB", "MSF", "ZQX", "nov", "tek", "Solmar", "corp", "pharma", "benkor", "zzzz",
+        "phrama", "solmra", "holdigns",                         // typos: fuzzy matches
+    };
+    for (int q = 0; q < COUNT(QUERIES); ++q) {
+        int total = 0, got = 0;
+        t0 = clock();
+        for (int r = 0; r < REPEAT; ++r) got = symbolIndexQuery(ix, QUERIES[q], NULL, 0, out, TOP_K, &total, NULL);
+        double us = (double)(clock() - t0) * 1e6 / CLOCKS_PER_SEC / REPEAT;
+        printf("%-8s %7d matches  top %-6s %8.1f us\n", QUERIES[q], total, got ? symbols[out[0]] : "-", us);
+    }
+
+    symbolIndexFree(ix);
+    symbolMasterClose(master);
+    free(symBuf); free(nameBuf); free(symbols); free(names);
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "backtest.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Backtest {
+    const BacktestSpec* spec;
+    Portfolio      portfolio;
+    CandleSeries   candles[PORTFOLIO_MAX_STOCKS];
+    CandleSeries   equity;
+    double         time;
+    BacktestResult* result;
+};
+
+const Portfolio* backtestPortfolio(const Backtest* bt) { return &bt->portfolio; }
+const CandleSeries* backtestCandles(const Backtest* bt, int stock) { return &bt->candles[stock]; }
+double backtestTime(const Backtest* bt) { return bt->time; }
+
+bool backtestOrder(Backtest* bt, int stock, int qty) {
+    Portfolio* p = &bt->portfolio;
+    BacktestResult* r = bt->result;
+    if (stock < 0 || stock >= p->count || qty == 0 || !portfolioCanFill(p, stock, qty, 0) ||
+        (qty > 0 && moneyMulInt(p->pos[stock].price, qty) > p->cash)) {
+        r->rejected++;
+        return false;
+    }
+    Money before = p->realized;
+    portfolioFill(p, stock, qty, p->pos[stock].price);
+    r->orders++;
+    if (qty < 0) {
+        Money gain = p->realized - before;
+        r->sells++;
+        if (gain > 0) { r->winningSells++; r->grossProfit += gain; }
+        else          r->grossLoss -= gain;
+    }
+    return true;
+}
+
+// One run start to finish on the calling thread.
+static bool runOne(const BacktestSpec* spec, BacktestRun* run) {
+    BacktestResult* r = &run->result;
+    memset(r, 0, sizeof(*r));
+    candleStoreInit(&r->equity);
+
+    Backtest* bt = (Backtest*)calloc(1, sizeof(Backtest));
+    void* state = calloc(1, spec->stateSize ? spec->stateSize : 1);
+    if (!bt || !state ||
+        !portfolioInit(&bt->portfolio, spec->stocks, spec->symbols, spec->openPrices, spec->cash, spec->lotCapacity)) {
+        free(bt); free(state);
+        return false;
+    }
+    bt->spec   = spec;
+    bt->result = r;
+    bt->portfolio.relief = spec->relief;
+
+    Money prices[PORTFOLIO_MAX_STOCKS];
+    double t;
+    r->startEquity = r->peakEquity = portfolioEquity(&bt->portfolio);
+    bool first = true;
+    while (spec->tick(run->source, &t, prices)) {
+        Portfolio* p = &bt->portfolio;
+        bt->time = t;
+        for (int i = 0; i < p->count; ++i) {
+            portfolioSetPrice(p, i, prices[i]);
+            if (first) candleSeriesInit(&bt->candles[i], moneyToFloat(prices[i]), t, spec->candleDt);
+            else       candleSeriesUpdate(&bt->candles[i], t, moneyToFloat(prices[i]), 0.0f);
+        }
+        spec->strategy(bt, run->params, state);
+
+        Money eq = portfolioEquity(p);
+        if (first) {
+            candleSeriesInit(&bt->equity, moneyToFloat(eq), t, spec->candleDt);
+            bt->equity.archive = &r->equity;
+        } else {
+            candleSeriesUpdate(&bt->equity, t, moneyToFloat(eq), 0.0f);
+        }
+        if (eq > r->peakEquity) r->peakEquity = eq;
+        if (r->peakEquity - eq > r->maxDrawdown) r->maxDrawdown = r->peakEquity - eq;
+        r->ticks++;
+        first = false;
+    }
+    if (bt->equity.current >= 0) candleStoreAppend(&r->equity, &bt->equity.candles[bt->equity.current]);
+
+    r->finalEquity = portfolioEquity(&bt->portfolio);
+    r->realized    = bt->portfolio.realized;
+    r->totalReturn = (r->startEquity != 0) ? (double)r->finalEquity / (double)r->startEquity - 1.0 : 0.0;
+#ifndef NDEBUG
+    if (!portfolioCheck(&bt->portfolio)) fprintf(stderr, "[backtest] aggregates out of sync\n");
+#endif
+    portfolioFree(&bt->portfolio);
+    free(bt);
+    free(state);
+    return true;
+}
+
+typedef struct {
+    const BacktestSpec* spec;
+    BacktestRun*  runs;
+    int           count, next;
+    PlatformMutex lock;
+} RunQueue;
+
+static void runWorker(void* arg) {
+    RunQueue* q = (RunQueue*)arg;
+    for (;;) {
+        platformMutexLock(&q->lock);
+        int k = q->next++;
+        platformMutexUnlock(&q->lock);
+        if (k >= q->count) return;
+        q->runs[k].ok = runOne(q->spec, &q->runs[k]);
+    }
+}
+
+void backtestRunAll(const BacktestSpec* spec, BacktestRun* runs, int count, int workers) {
+    if (count <= 0) return;
+    if (workers <= 0) workers = platformCpuCount();
+    if (workers > count) workers = count;
+    if (workers > 64) workers = 64;
+
+    RunQueue q = { .spec = spec, .runs = runs, .count = count };
+    platformMutexInit(&q.lock);
+    PlatformThread threads[64];
+    int started = 0;
+    while (started < workers - 1 && platformThreadStart(&threads[started], runWorker, &q)) started++;
+    runWorker(&q);                        // the caller works too
+    for (int k = 0; k < started; ++k) platformThreadJoin(threads[k]);
+    platformMutexDestroy(&q.lock);
+}
+
+void backtestResultFree(BacktestResult* r) {
+    candleStoreFree(&r->equity);
+}
+
+// ---- Random walk ----
+void randomWalkInit(RandomWalkSource* s, const BacktestSpec* spec, uint64_t seed, long ticks, double dt) {
+    memset(s, 0, sizeof(*s));
+    s->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    s->stocks = spec->stocks;
+    for (int i = 0; i < spec->stocks; ++i) s->price[i] = spec->openPrices[i];
+    s->dt = dt;
+    s->ticksLeft = ticks;
+}
+
+static inline uint32_t walkRand(RandomWalkSource* s) {     // xorshift64*
+    s->rng ^= s->rng >> 12; s->rng ^= s->rng << 25; s->rng ^= s->rng >> 27;
+    return (uint32_t)((s->rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Same steps as the app's updatePricesRandomWalk
+bool randomWalkTick(void* source, double* time, Money* prices) {
+    RandomWalkSource* s = (RandomWalkSource*)source;
+    if (s->ticksLeft <= 0) return false;
+    s->ticksLeft--;
+    s->time += s->dt;
+    for (int i = 0; i < s->stocks; ++i) {
+        Money p = s->price[i];
+        int permille = (int)(walkRand(s) % 11) + 1;
+        int dir = (walkRand(s) & 1) ? +1 : -1;
+        p += moneyDivInt(moneyMulInt(p, permille), 1000) * dir;
+        if (p < MONEY_ONE) p = MONEY_ONE;
+        s->price[i] = prices[i] = p;
+    }
+    *time = s->time;
+    return true;
+}
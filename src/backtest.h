@@ -0,0 +1,88 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "money.h"
+#include "portfolio.h"
+#include "candles.h"
+#include "candlestore.h"
+
+// Headless backtests over the portfolio core, no window or GL involved.
+// A run feeds a tick source into its own Portfolio (the same fill and tax-lot
+// accounting the app uses), folds prices and equity into candle series like
+// the app's charts, and calls the strategy after every tick. Runs share
+// nothing but the spec, so backtestRunAll spreads a batch of parameter sets
+// across threads.
+
+// Next tick: its time in seconds and one price per stock. False when exhausted.
+typedef bool (*TickSourceFn)(void* source, double* time, Money* prices);
+
+typedef struct Backtest Backtest;
+
+// Called after every tick, once the portfolio is marked to the new prices.
+// 'state' is the run's own zeroed scratch of spec.stateSize bytes.
+typedef void (*StrategyFn)(Backtest* bt, const void* params, void* state);
+
+typedef struct {
+    int          stocks;                            // 1..PORTFOLIO_MAX_STOCKS
+    const char*  symbols[PORTFOLIO_MAX_STOCKS];
+    Money        openPrices[PORTFOLIO_MAX_STOCKS];
+    Money        cash;
+    ReliefMethod relief;
+    uint32_t     lotCapacity;                       // per run
+    double       candleDt;                          // price and equity candle period
+    TickSourceFn tick;
+    StrategyFn   strategy;
+    size_t       stateSize;
+} BacktestSpec;
+
+typedef struct {
+    long   ticks;
+    long   orders, rejected;        // market orders filled / refused
+    long   sells, winningSells;     // sales, and those that realized a gain
+    Money  startEquity, finalEquity;
+    Money  realized, grossProfit, grossLoss;
+    Money  peakEquity, maxDrawdown;
+    double totalReturn;             // finalEquity / startEquity - 1
+    CandleStore equity;             // equity curve, one candle per candleDt
+} BacktestResult;
+
+typedef struct {
+    void*          source;          // this run's tick source state, never shared
+    const void*    params;          // strategy parameters
+    bool           ok;              // false if the run could not start (out of memory)
+    BacktestResult result;          // release with backtestResultFree
+} BacktestRun;
+
+// Run every entry to the end of its source on up to 'workers' threads
+// (<= 0: one per CPU). Returns when all are done.
+void backtestRunAll(const BacktestSpec* spec, BacktestRun* runs, int count, int workers);
+
+void backtestResultFree(BacktestResult* r);
+
+// ---- Strategy side ----
+const Portfolio*    backtestPortfolio(const Backtest* bt);
+// Price candles of one stock, the newest MAX_CANDLES.
+const CandleSeries* backtestCandles(const Backtest* bt, int stock);
+double              backtestTime(const Backtest* bt);
+
+// Market order at the current price (buy > 0, sell < 0). False, changing
+// nothing, if the cash or the position cannot cover it.
+bool backtestOrder(Backtest* bt, int stock, int qty);
+
+// ---- Built-in tick source: the app's random walk, reproducible from a seed ----
+typedef struct {
+    uint64_t rng;
+    int      stocks;
+    Money    price[PORTFOLIO_MAX_STOCKS];
+    double   time, dt;
+    long     ticksLeft;
+} RandomWalkSource;
+
+// 'ticks' moves of 1-11 permille per stock, 'dt' seconds apart, from the spec's opening prices.
+void randomWalkInit(RandomWalkSource* s, const BacktestSpec* spec, uint64_t seed, long ticks, double dt);
+bool randomWalkTick(void* source, double* time, Money* prices);
+
+#endif // BACKTEST_H
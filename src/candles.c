@@ -0,0 +1,132 @@
+#include "candles.h"
+#include "candlestore.h"
+
+Candle candleMerge(Candle a, Candle b) {
+    if (!a.valid) return b;
+    if (!b.valid) return a;
+    Candle r = a;
+    if (b.high > r.high) r.high = b.high;
+    if (b.low  < r.low ) r.low  = b.low;
+    r.close  = b.close;
+    r.volume = a.volume + b.volume;
+    return r;
+}
+
+// Refresh the leaf for ring position i and its ancestors.
+static void candleTreeSet(CandleSeries* s, int i) {
+    int n = CANDLE_TREE_LEAVES + i;
+    s->tree[n] = s->candles[i];
+    for (n >>= 1; n >= 1; n >>= 1) s->tree[n] = candleMerge(s->tree[2*n], s->tree[2*n+1]);
+}
+
+// Ordered aggregate over ring positions [lo, hi] (no wrap).
+static Candle candleTreeQuery(const CandleSeries* s, int lo, int hi) {
+    Candle left = {0}, right = {0};
+    for (int l = lo + CANDLE_TREE_LEAVES, r = hi + CANDLE_TREE_LEAVES + 1; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) left  = candleMerge(left, s->tree[l++]);
+        if (r & 1) right = candleMerge(s->tree[--r], right);
+    }
+    return candleMerge(left, right);
+}
+
+static void candleTreeBuild(CandleSeries* s) {
+    for (int i = 0; i < 2 * CANDLE_TREE_LEAVES; ++i) s->tree[i].valid = false;
+    for (int i = 0; i < MAX_CANDLES; ++i) s->tree[CANDLE_TREE_LEAVES + i] = s->candles[i];
+    for (int n = CANDLE_TREE_LEAVES - 1; n >= 1; --n) s->tree[n] = candleMerge(s->tree[2*n], s->tree[2*n+1]);
+}
+
+void candleSeriesInit(CandleSeries* s, float initialValue, double now, double dt) {
+    for (int i = 0; i < MAX_CANDLES; ++i) {
+        Candle* c = &s->candles[i];
+        c->open = c->high = c->low = c->close = initialValue;
+        c->volume = 0.0f;
+        c->time  = 0.0;
+        c->valid = false;
+    }
+    s->dt       = dt;
+    s->lastTime = now;
+    s->current  = 0;
+    s->count    = 1;
+    s->candles[0].time  = now;
+    s->candles[0].valid = true;
+    candleTreeBuild(s);
+}
+
+void candleSeriesLoad(CandleSeries* s, const Candle* src, int n, double dt) {
+    if (n > MAX_CANDLES) { src += n - MAX_CANDLES; n = MAX_CANDLES; }
+    for (int i = 0; i < MAX_CANDLES; ++i) {
+        if (i < n) s->candles[i] = src[i];
+        else       s->candles[i].valid = false;
+    }
+    s->dt       = dt;
+    s->count    = n;
+    s->current  = n - 1;
+    s->lastTime = (n > 0) ? src[n - 1].time : 0.0;
+    s->archive  = NULL;
+    candleTreeBuild(s);
+}
+
+void candleSeriesUpdate(CandleSeries* s, double now, float v, float volume) {
+    if (s->current < 0) return;
+
+    Candle* c = &s->candles[s->current];
+    if (!c->valid) { c->open = c->high = c->low = c->close = v; c->volume = 0.0f; c->valid = true; }
+    c->close = v;
+    c->volume += volume;
+    if (v > c->high) c->high = v;
+    if (v < c->low ) c->low  = v;
+
+    if (now - s->lastTime >= s->dt) {
+        if (s->archive) candleStoreAppend(s->archive, c);
+        s->lastTime = now;
+        int next = (s->current + 1) % MAX_CANDLES;
+        Candle* n = &s->candles[next];
+        n->open = c->close;
+        n->high = n->low = n->close = n->open;
+        n->volume = 0.0f;
+        n->time = now;
+        n->valid = true;
+        candleTreeSet(s, s->current);
+        s->current = next;
+        if (s->count < MAX_CANDLES) s->count++;
+    }
+    candleTreeSet(s, s->current);
+}
+
+int candleSeriesFirst(const CandleSeries* s) {
+    return (s->count == MAX_CANDLES) ? (s->current + 1) % MAX_CANDLES : 0;
+}
+
+bool candleSeriesRange(const CandleSeries* s, int fromSlot, int toSlot, Candle* out) {
+    if (s->current < 0 || s->count <= 0) return false;
+    if (fromSlot < 0) fromSlot = 0;
+    if (toSlot >= s->count) toSlot = s->count - 1;
+    if (fromSlot > toSlot) return false;
+
+    int lo = candleSeriesIndex(s, fromSlot);
+    int hi = candleSeriesIndex(s, toSlot);
+    Candle r = (lo <= hi) ? candleTreeQuery(s, lo, hi)
+                          : candleMerge(candleTreeQuery(s, lo, MAX_CANDLES - 1), candleTreeQuery(s, 0, hi));
+    if (!r.valid) return false;
+    *out = r;
+    return true;
+}
+
+int candleSeriesSlotAtTime(const CandleSeries* s, double t) {
+    if (s->current < 0 || s->count <= 0) return -1;
+    int lo = 0, hi = s->count - 1, ans = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (s->candles[candleSeriesIndex(s, mid)].time <= t) { ans = mid; lo = mid + 1; }
+        else hi = mid - 1;
+    }
+    return ans;
+}
+
+bool candleSeriesRangeTime(const CandleSeries* s, double t0, double t1, Candle* out) {
+    if (t1 < t0) return false;
+    int from = candleSeriesSlotAtTime(s, t0);
+    if (from < 0 || s->candles[candleSeriesIndex(s, from)].time < t0) from++;
+    int to = candleSeriesSlotAtTime(s, t1);
+    return candleSeriesRange(s, from, to, out);
+}
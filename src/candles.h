@@ -0,0 +1,60 @@
+#ifndef CANDLES_H
+#define CANDLES_H
+
+#include <stdbool.h>
+
+#define MAX_CANDLES 240
+#define CANDLE_TREE_LEAVES 256   // power of two >= MAX_CANDLES
+
+typedef struct { float open, high, low, close, volume; double time; bool valid; } Candle;
+
+struct CandleStore;
+
+// Fixed-size ring of OHLC candles. 'current' is the candle being built,
+// 'count' the number of valid candles (<= MAX_CANDLES).
+// 'tree' is a segment tree over ring positions (leaves at CANDLE_TREE_LEAVES + i)
+// kept in sync on every update, so any range aggregates in O(log n).
+// If 'archive' is set, every candle that closes is also appended to it.
+typedef struct {
+    Candle candles[MAX_CANDLES];
+    Candle tree[2 * CANDLE_TREE_LEAVES];
+    int    count;
+    int    current;          // -1 until initialised
+    double dt;               // candle period in seconds
+    double lastTime;         // open time of the current candle
+    struct CandleStore* archive;   // optional compressed history, not owned
+} CandleSeries;
+
+// Reset the ring and start the first candle at 'initialValue'.
+void candleSeriesInit(CandleSeries* s, float initialValue, double now, double dt);
+
+// Fold a new sample (and the volume traded since the last call) into the current
+// candle; rolls to the next slot every dt seconds.
+void candleSeriesUpdate(CandleSeries* s, double now, float value, float volume);
+
+// Replace the ring with n closed candles (oldest first, n <= MAX_CANDLES), e.g. a
+// window decoded from an archive. The last one becomes 'current'.
+void candleSeriesLoad(CandleSeries* s, const Candle* src, int n, double dt);
+
+// Ring index of the oldest candle (leftmost slot on a chart).
+int candleSeriesFirst(const CandleSeries* s);
+
+// Ring index of the i-th oldest candle (0 <= slot < count).
+static inline int candleSeriesIndex(const CandleSeries* s, int slot) {
+    return (candleSeriesFirst(s) + slot) % MAX_CANDLES;
+}
+
+// Merge two chronologically ordered aggregates (a before b). Invalid sides are ignored.
+Candle candleMerge(Candle a, Candle b);
+
+// Aggregate OHLCV of slots [fromSlot, toSlot] (oldest = 0), clamped to the series.
+// O(log n). Returns false if the range holds no valid candle.
+bool candleSeriesRange(const CandleSeries* s, int fromSlot, int toSlot, Candle* out);
+
+// Aggregate of candles whose open time lies in [t0, t1]. O(log n).
+bool candleSeriesRangeTime(const CandleSeries* s, double t0, double t1, Candle* out);
+
+// Slot of the last candle opened at or before t (-1 if t precedes the series). O(log n).
+int candleSeriesSlotAtTime(const CandleSeries* s, double t);
+
+#endif // CANDLES_H
@@ -0,0 +1,221 @@
+#include "candlestore.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Worst case per candle: 4+64 bits of time, 5 x (2+5+5+32) bits of floats.
+#define CANDLE_MAX_BITS   (68 + 5 * 44)
+#define OPEN_BLOCK_WORDS  ((CANDLE_BLOCK_SIZE * CANDLE_MAX_BITS + 63) / 64 + 1)
+
+// ---- bit stream (MSB first) ----
+static void putBits(CandleBlock* b, uint64_t v, int n) {
+    if (n < 64) v &= (1ULL << n) - 1;
+    while (n > 0) {
+        uint32_t w = b->nbits >> 6;
+        int room = 64 - (int)(b->nbits & 63);
+        int take = (n < room) ? n : room;
+        uint64_t chunk = (take == 64) ? v : (v >> (n - take)) & ((1ULL << take) - 1);
+        b->words[w] |= chunk << (room - take);
+        b->nbits += (uint32_t)take;
+        n -= take;
+    }
+}
+
+typedef struct { const uint64_t* words; uint32_t pos; } BitReader;
+
+static uint64_t getBits(BitReader* r, int n) {
+    uint64_t v = 0;
+    while (n > 0) {
+        uint32_t w = r->pos >> 6;
+        int room = 64 - (int)(r->pos & 63);
+        int take = (n < room) ? n : room;
+        uint64_t chunk = r->words[w] >> (room - take);
+        if (take < 64) chunk &= (1ULL << take) - 1;
+        v = (take == 64) ? chunk : (v << take) | chunk;
+        r->pos += (uint32_t)take;
+        n -= take;
+    }
+    return v;
+}
+
+static uint32_t floatBits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float    bitsFloat(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+static void candleFields(const Candle* c, uint32_t out[5]) {
+    out[0] = floatBits(c->open);  out[1] = floatBits(c->high);
+    out[2] = floatBits(c->low);   out[3] = floatBits(c->close);
+    out[4] = floatBits(c->volume);
+}
+
+// ---- timestamps: delta-of-delta in four buckets ----
+static void putTime(CandleBlock* b, int64_t dod) {
+    if (dod == 0)                          { putBits(b, 0x0, 1); }
+    else if (dod >= -63   && dod <= 64)    { putBits(b, 0x2, 2);  putBits(b, (uint64_t)(dod + 63),   7); }
+    else if (dod >= -255  && dod <= 256)   { putBits(b, 0x6, 3);  putBits(b, (uint64_t)(dod + 255),  9); }
+    else if (dod >= -2047 && dod <= 2048)  { putBits(b, 0xE, 4);  putBits(b, (uint64_t)(dod + 2047), 12); }
+    else                                   { putBits(b, 0xF, 4);  putBits(b, (uint64_t)dod, 64); }
+}
+static int64_t getTime(BitReader* r) {
+    if (!getBits(r, 1)) return 0;
+    if (!getBits(r, 1)) return (int64_t)getBits(r, 7)  - 63;
+    if (!getBits(r, 1)) return (int64_t)getBits(r, 9)  - 255;
+    if (!getBits(r, 1)) return (int64_t)getBits(r, 12) - 2047;
+    return (int64_t)getBits(r, 64);
+}
+
+// ---- floats: XOR with previous, reusing the previous leading/trailing window ----
+static void putXor(CandleBlock* b, uint32_t x, int* prevLead, int* prevTrail) {
+    if (x == 0) { putBits(b, 0, 1); return; }
+    putBits(b, 1, 1);
+    int lead  = __builtin_clz(x);
+    int trail = __builtin_ctz(x);
+    if (lead > 31) lead = 31;
+    if (*prevLead >= 0 && lead >= *prevLead && trail >= *prevTrail) {
+        putBits(b, 0, 1);
+        putBits(b, x >> *prevTrail, 32 - *prevLead - *prevTrail);
+    } else {
+        int len = 32 - lead - trail;
+        putBits(b, 1, 1);
+        putBits(b, (uint64_t)lead, 5);
+        putBits(b, (uint64_t)(len - 1), 5);
+        putBits(b, x >> trail, len);
+        *prevLead = lead; *prevTrail = trail;
+    }
+}
+static uint32_t getXor(BitReader* r, int* lead, int* trail) {
+    if (!getBits(r, 1)) return 0;
+    if (getBits(r, 1)) {
+        *lead = (int)getBits(r, 5);
+        int len = (int)getBits(r, 5) + 1;
+        *trail = 32 - *lead - len;
+    }
+    return (uint32_t)getBits(r, 32 - *lead - *trail) << *trail;
+}
+
+// ---- store ----
+void candleStoreInit(CandleStore* st) {
+    memset(st, 0, sizeof(*st));
+    for (int i = 0; i < CANDLE_STORE_CACHE; ++i) st->cache[i].block = -1;
+}
+
+void candleStoreFree(CandleStore* st) {
+    for (int i = 0; i < st->blockCount; ++i) free(st->blocks[i].words);
+    free(st->blocks);
+    candleStoreInit(st);
+}
+
+static CandleBlock* openBlock(CandleStore* st) {
+    if (st->blockCount > 0 && st->blocks[st->blockCount - 1].count < CANDLE_BLOCK_SIZE)
+        return &st->blocks[st->blockCount - 1];
+
+    // Seal the full block down to its exact size
+    if (st->blockCount > 0) {
+        CandleBlock* last = &st->blocks[st->blockCount - 1];
+        uint64_t* w = (uint64_t*)realloc(last->words, ((last->nbits + 63) / 64 + 1) * sizeof(uint64_t));
+        if (w) last->words = w;
+    }
+    if (st->blockCount == st->blockCap) {
+        int cap = st->blockCap ? st->blockCap * 2 : 16;
+        CandleBlock* nb = (CandleBlock*)realloc(st->blocks, (size_t)cap * sizeof(CandleBlock));
+        if (!nb) return NULL;
+        st->blocks = nb; st->blockCap = cap;
+    }
+    CandleBlock* b = &st->blocks[st->blockCount];
+    b->words = (uint64_t*)calloc(OPEN_BLOCK_WORDS, sizeof(uint64_t));
+    if (!b->words) return NULL;
+    b->nbits = 0;
+    b->count = 0;
+    st->blockCount++;
+    return b;
+}
+
+void candleStoreAppend(CandleStore* st, const Candle* c) {
+    CandleBlock* b = openBlock(st);
+    if (!b) return;
+
+    int64_t t = (int64_t)llround(c->time * 1000.0);
+    uint32_t f[5]; candleFields(c, f);
+
+    if (b->count == 0) {
+        putBits(b, (uint64_t)t, 64);
+        for (int k = 0; k < 5; ++k) {
+            putBits(b, f[k], 32);
+            st->prevLead[k] = -1; st->prevTrail[k] = 0;
+        }
+        st->prevDelta = 0;
+    } else {
+        int64_t delta = t - st->prevTime;
+        putTime(b, delta - st->prevDelta);
+        st->prevDelta = delta;
+        for (int k = 0; k < 5; ++k) putXor(b, f[k] ^ st->prevBits[k], &st->prevLead[k], &st->prevTrail[k]);
+    }
+    st->prevTime = t;
+    memcpy(st->prevBits, f, sizeof(f));
+    b->count++;
+    st->total++;
+}
+
+static void decodeBlock(const CandleBlock* b, Candle* out) {
+    BitReader r = { b->words, 0 };
+    int64_t t = 0, delta = 0;
+    uint32_t f[5] = {0};
+    int lead[5] = {0}, trail[5] = {0};
+    for (int i = 0; i < b->count; ++i) {
+        if (i == 0) {
+            t = (int64_t)getBits(&r, 64);
+            for (int k = 0; k < 5; ++k) f[k] = (uint32_t)getBits(&r, 32);
+        } else {
+            delta += getTime(&r);
+            t += delta;
+            for (int k = 0; k < 5; ++k) f[k] ^= getXor(&r, &lead[k], &trail[k]);
+        }
+        Candle* c = &out[i];
+        c->open  = bitsFloat(f[0]); c->high   = bitsFloat(f[1]);
+        c->low   = bitsFloat(f[2]); c->close  = bitsFloat(f[3]);
+        c->volume = bitsFloat(f[4]);
+        c->time  = (double)t / 1000.0;
+        c->valid = true;
+    }
+}
+
+// Decoded block from the cache, evicting the least recently used entry on a miss.
+// The open block is re-decoded when it has grown since it was cached.
+static const Candle* cachedBlock(CandleStore* st, int block) {
+    int slot = 0;
+    for (int i = 0; i < CANDLE_STORE_CACHE; ++i) {
+        if (st->cache[i].block == block) { slot = i; break; }
+        if (st->cache[i].stamp < st->cache[slot].stamp) slot = i;
+    }
+    const CandleBlock* b = &st->blocks[block];
+    if (st->cache[slot].block != block || st->cache[slot].count != b->count) {
+        decodeBlock(b, st->cache[slot].c);
+        st->cache[slot].block = block;
+        st->cache[slot].count = b->count;
+    }
+    st->cache[slot].stamp = ++st->clock;
+    return st->cache[slot].c;
+}
+
+int candleStoreRead(CandleStore* st, long from, int n, Candle* out) {
+    if (from < 0) { n += (int)from; from = 0; }
+    if (n <= 0 || from >= st->total) return 0;
+    if (from + n > st->total) n = (int)(st->total - from);
+
+    int done = 0;
+    while (done < n) {
+        long pos   = from + done;
+        int  block = (int)(pos / CANDLE_BLOCK_SIZE);
+        int  off   = (int)(pos % CANDLE_BLOCK_SIZE);
+        int  take  = st->blocks[block].count - off;
+        if (take > n - done) take = n - done;
+        memcpy(out + done, cachedBlock(st, block) + off, (size_t)take * sizeof(Candle));
+        done += take;
+    }
+    return done;
+}
+
+size_t candleStoreBytes(const CandleStore* st) {
+    size_t bytes = 0;
+    for (int i = 0; i < st->blockCount; ++i) bytes += (st->blocks[i].nbits + 7) / 8;
+    return bytes;
+}
@@ -0,0 +1,55 @@
+#ifndef CANDLESTORE_H
+#define CANDLESTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "candles.h"
+
+// Compressed append-only candle history (Gorilla-style).
+// Candles are packed into fixed-size blocks: open times as delta-of-delta
+// milliseconds, each of open/high/low/close/volume XOR-encoded against the
+// previous value of the same field. A regular 1 s series costs one bit per
+// timestamp and typically 2-4 bytes per float field.
+// Blocks are decoded on demand into a small per-store cache.
+
+#define CANDLE_BLOCK_SIZE   256
+#define CANDLE_STORE_CACHE  4
+
+typedef struct {
+    uint64_t* words;        // bit stream, MSB first
+    uint32_t  nbits;
+    int       count;        // candles in the block
+} CandleBlock;
+
+typedef struct CandleStore {
+    CandleBlock* blocks;
+    int   blockCount, blockCap;
+    long  total;            // candles appended
+
+    // encoder state for the open (last) block
+    int64_t  prevTime, prevDelta;
+    uint32_t prevBits[5];
+    int      prevLead[5], prevTrail[5];
+
+    // decoded blocks, LRU by stamp
+    struct { int block, count; unsigned stamp; Candle c[CANDLE_BLOCK_SIZE]; } cache[CANDLE_STORE_CACHE];
+    unsigned clock;
+} CandleStore;
+
+// Start an empty store.
+void candleStoreInit(CandleStore* st);
+
+// Release all blocks.
+void candleStoreFree(CandleStore* st);
+
+// Append one closed candle. Time is kept at millisecond resolution.
+void candleStoreAppend(CandleStore* st, const Candle* c);
+
+// Decode candles [from, from+n) into out; returns the number written.
+// Only the blocks overlapping the range are decoded (and cached).
+int candleStoreRead(CandleStore* st, long from, int n, Candle* out);
+
+// Compressed footprint in bytes (block payloads only).
+size_t candleStoreBytes(const CandleStore* st);
+
+#endif // CANDLESTORE_H
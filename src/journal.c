@@ -0,0 +1,294 @@
+#include "journal.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char JOURNAL_MAGIC[8] = { 'P','F','J','O','U','R','N','1' };
+#define JOURNAL_HEADER_BYTES 16     // magic, then the base seq (last seq compacted away)
+#define REPLAY_CHUNK         65536   // records per read
+
+_Static_assert(sizeof(JournalRecord) == 32, "journal record layout is part of the file format");
+
+struct Journal {
+    FILE* f;
+    char* path;
+    PlatformThread writer;
+    PlatformMutex  lock;
+    PlatformCond   wake;       // records queued or stop requested
+    PlatformCond   durable;    // a batch reached the disk
+
+    JournalRecord* pending;    // filled by appenders
+    int            pendingLen, pendingCap;
+    JournalRecord* batch;      // owned by the writer while it writes
+    int            batchCap;
+
+    uint64_t lastSeq;          // newest queued
+    uint64_t durableSeq;       // newest fsync'd
+    uint64_t baseSeq;          // records up to here are compacted away (writer only)
+    uint64_t compactSeq;       // pending compaction request, 0 = none
+    bool     stop;
+};
+
+static void writeHeader(FILE* f, uint64_t baseSeq) {
+    char hdr[JOURNAL_HEADER_BYTES];
+    memcpy(hdr, JOURNAL_MAGIC, 8);
+    memcpy(hdr + 8, &baseSeq, 8);
+    fwrite(hdr, 1, sizeof(hdr), f);
+}
+
+static uint16_t recordCheck(const JournalRecord* r) {
+    uint64_t w[4];
+    memcpy(w, r, sizeof(w));
+    w[3] &= 0x0000FFFFFFFFFFFFULL;   // exclude the check field itself
+    uint64_t h = w[0] * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ w[1]) * 0xC2B2AE3D27D4EB4FULL;
+    h = (h ^ w[2]) * 0x165667B19E3779F9ULL;
+    h = (h ^ w[3]) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+// Copy the records after 'through' into a fresh file and swap it in.
+// Runs on the writer thread, which is the only one touching j->f.
+static void compactFile(Journal* j, uint64_t through) {
+    if (!j->f || through <= j->baseSeq) return;
+    size_t plen = strlen(j->path);
+    char* tmpPath = (char*)malloc(plen + 5);
+    if (!tmpPath) return;
+    memcpy(tmpPath, j->path, plen);
+    memcpy(tmpPath + plen, ".tmp", 5);
+
+    FILE* out = fopen(tmpPath, "wb");
+    JournalRecord* buf = (JournalRecord*)malloc(REPLAY_CHUNK * sizeof(JournalRecord));
+    if (!out || !buf) {
+        if (out) { fclose(out); remove(tmpPath); }
+        free(buf); free(tmpPath);
+        return;
+    }
+    writeHeader(out, through);
+    fflush(j->f);
+    fseek(j->f, JOURNAL_HEADER_BYTES, SEEK_SET);
+    size_t n;
+    while ((n = fread(buf, sizeof(JournalRecord), REPLAY_CHUNK, j->f)) > 0) {
+        size_t i = 0;
+        while (i < n && buf[i].seq <= through) ++i;
+        fwrite(buf + i, sizeof(JournalRecord), n - i, out);
+    }
+    free(buf);
+    platformFileSync(out);
+    fclose(out);
+
+    // The file must be closed before it can be replaced on Windows
+    fclose(j->f);
+    if (platformReplaceFile(tmpPath, j->path)) j->baseSeq = through;
+    else remove(tmpPath);
+    free(tmpPath);
+    j->f = fopen(j->path, "r+b");
+    if (j->f) fseek(j->f, 0, SEEK_END);
+    else fprintf(stderr, "Journal: cannot reopen %s after compaction\n", j->path);
+}
+
+static void writerMain(void* arg) {
+    Journal* j = (Journal*)arg;
+    platformMutexLock(&j->lock);
+    for (;;) {
+        while (!j->stop && j->pendingLen == 0 && j->compactSeq == 0) platformCondWait(&j->wake, &j->lock);
+        if (j->compactSeq != 0) {
+            uint64_t through = j->compactSeq;
+            j->compactSeq = 0;
+            platformMutexUnlock(&j->lock);
+            compactFile(j, through);
+            platformMutexLock(&j->lock);
+            continue;
+        }
+        if (j->pendingLen == 0) break;   // stop requested and drained
+
+        // Take everything queued so far; appenders continue into the other buffer
+        JournalRecord* tmp = j->batch; j->batch = j->pending; j->pending = tmp;
+        int tcap = j->batchCap; j->batchCap = j->pendingCap; j->pendingCap = tcap;
+        int n = j->pendingLen;
+        j->pendingLen = 0;
+        platformMutexUnlock(&j->lock);
+
+        // Records a snapshot already covers need not reach the file
+        int skip = 0;
+        while (skip < n && j->batch[skip].seq <= j->baseSeq) ++skip;
+        if (j->f && skip < n) {
+            fwrite(j->batch + skip, sizeof(JournalRecord), (size_t)(n - skip), j->f);
+            platformFileSync(j->f);      // one fsync for the whole batch
+        }
+
+        platformMutexLock(&j->lock);
+        j->durableSeq = j->batch[n - 1].seq;
+        platformCondBroadcast(&j->durable);
+    }
+    platformMutexUnlock(&j->lock);
+}
+
+// Replay records after the header; returns the byte length of the valid prefix.
+static int64_t replayFile(FILE* f, Journal* j, uint64_t coveredSeq, JournalApplyFn apply, void* user, long long* replayed) {
+    char hdr[JOURNAL_HEADER_BYTES];
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || memcmp(hdr, JOURNAL_MAGIC, 8) != 0) return -1;
+    memcpy(&j->baseSeq, hdr + 8, 8);
+    j->lastSeq = j->baseSeq;
+    if (j->baseSeq > coveredSeq)
+        fprintf(stderr, "Journal: starts after seq %llu but the loaded state only covers %llu\n",
+                (unsigned long long)j->baseSeq, (unsigned long long)coveredSeq);
+
+    JournalRecord* buf = (JournalRecord*)malloc(REPLAY_CHUNK * sizeof(JournalRecord));
+    if (!buf) return JOURNAL_HEADER_BYTES;
+    // Records of an open group wait here until its last record shows up
+    JournalRecord* group = NULL;
+    int groupLen = 0, groupCap = 0;
+    int64_t pos = JOURNAL_HEADER_BYTES, good = pos;
+    long long count = 0;
+    bool intact = true;
+    while (intact) {
+        size_t n = fread(buf, sizeof(JournalRecord), REPLAY_CHUNK, f);
+        for (size_t i = 0; i < n; ++i) {
+            const JournalRecord* r = &buf[i];
+            if (r->check != recordCheck(r) || r->seq != j->lastSeq + (uint64_t)groupLen + 1) { intact = false; break; }
+            if (groupLen == groupCap) {
+                int cap = groupCap ? groupCap * 2 : 16;
+                JournalRecord* g = (JournalRecord*)realloc(group, (size_t)cap * sizeof(JournalRecord));
+                if (!g) { intact = false; break; }
+                group = g; groupCap = cap;
+            }
+            group[groupLen++] = *r;
+            pos += (int64_t)sizeof(JournalRecord);
+            if (r->flags & JOURNAL_FLAG_MORE) continue;
+
+            for (int k = 0; k < groupLen; ++k)
+                if (apply && group[k].seq > coveredSeq) { apply(&group[k], user); count++; }
+            j->lastSeq = r->seq;
+            groupLen = 0;
+            good = pos;
+        }
+        if (n < REPLAY_CHUNK) break;
+    }
+    free(group);
+    free(buf);
+    if (replayed) *replayed = count;
+    return good;                          // an unfinished group is cut with the torn tail
+}
+
+Journal* journalOpen(const char* path, uint64_t coveredSeq, JournalApplyFn apply, void* user, long long* replayed) {
+    Journal* j = (Journal*)calloc(1, sizeof(Journal));
+    if (!j) return NULL;
+    if (replayed) *replayed = 0;
+    size_t plen = strlen(path);
+    j->path = (char*)malloc(plen + 1);
+    if (!j->path) { free(j); return NULL; }
+    memcpy(j->path, path, plen + 1);
+
+    int64_t good = -1;
+    FILE* f = fopen(path, "r+b");
+    if (f) good = replayFile(f, j, coveredSeq, apply, user, replayed);
+    if (good < 0 || j->lastSeq < coveredSeq) {
+        // Missing or foreign file, or one the snapshot has overtaken entirely:
+        // start a fresh journal numbered after the snapshot
+        if (f) fclose(f);
+        f = fopen(path, "w+b");
+        if (!f) { free(j->path); free(j); return NULL; }
+        j->baseSeq = j->lastSeq = coveredSeq;
+        writeHeader(f, j->baseSeq);
+        good = JOURNAL_HEADER_BYTES;
+    }
+    platformFileTruncate(f, good);      // drop a torn tail, if any
+    fseek(f, 0, SEEK_END);
+    platformFileSync(f);
+
+    j->f = f;
+    j->durableSeq = j->lastSeq;
+    j->pendingCap = j->batchCap = 256;
+    j->pending = (JournalRecord*)malloc((size_t)j->pendingCap * sizeof(JournalRecord));
+    j->batch   = (JournalRecord*)malloc((size_t)j->batchCap * sizeof(JournalRecord));
+    platformMutexInit(&j->lock);
+    platformCondInit(&j->wake);
+    platformCondInit(&j->durable);
+    if (!j->pending || !j->batch || !platformThreadStart(&j->writer, writerMain, j)) {
+        free(j->pending); free(j->batch); fclose(f); free(j->path); free(j);
+        return NULL;
+    }
+    return j;
+}
+
+void journalRecordSet(JournalRecord* r, JournalType type, const char* symbol, int qty, Money amount) {
+    memset(r, 0, sizeof(*r));
+    r->amount = amount;
+    for (size_t i = 0; symbol && i < sizeof(r->symbol) && symbol[i]; ++i) r->symbol[i] = symbol[i];
+    r->qty  = qty;
+    r->type = (uint8_t)type;
+}
+
+uint64_t journalAppend(Journal* j, JournalType type, const char* symbol, int qty, Money amount) {
+    JournalRecord r;
+    journalRecordSet(&r, type, symbol, qty, amount);
+    return journalAppendGroup(j, &r, 1);
+}
+
+uint64_t journalAppendGroup(Journal* j, JournalRecord* recs, int n) {
+    if (!j || n <= 0) return 0;
+    platformMutexLock(&j->lock);
+    if (j->pendingLen + n > j->pendingCap) {
+        int cap = j->pendingCap * 2;
+        while (cap < j->pendingLen + n) cap *= 2;
+        JournalRecord* p = (JournalRecord*)realloc(j->pending, (size_t)cap * sizeof(JournalRecord));
+        if (!p) { platformMutexUnlock(&j->lock); return 0; }
+        j->pending = p; j->pendingCap = cap;
+    }
+    // One lock hold, so the group lands contiguously and in the same batch
+    for (int i = 0; i < n; ++i) {
+        JournalRecord* r = &recs[i];
+        r->seq   = ++j->lastSeq;
+        r->flags = (i + 1 < n) ? JOURNAL_FLAG_MORE : 0;
+        r->check = recordCheck(r);
+        j->pending[j->pendingLen++] = *r;
+    }
+    uint64_t last = j->lastSeq;
+    platformCondSignal(&j->wake);
+    platformMutexUnlock(&j->lock);
+    return last;
+}
+
+void journalFlush(Journal* j) {
+    if (!j) return;
+    platformMutexLock(&j->lock);
+    while (j->durableSeq < j->lastSeq) platformCondWait(&j->durable, &j->lock);
+    platformMutexUnlock(&j->lock);
+}
+
+uint64_t journalLastSeq(Journal* j) {
+    if (!j) return 0;
+    platformMutexLock(&j->lock);
+    uint64_t s = j->lastSeq;
+    platformMutexUnlock(&j->lock);
+    return s;
+}
+
+void journalCompact(Journal* j, uint64_t throughSeq) {
+    if (!j) return;
+    platformMutexLock(&j->lock);
+    if (throughSeq > j->compactSeq) j->compactSeq = throughSeq;
+    platformCondSignal(&j->wake);
+    platformMutexUnlock(&j->lock);
+}
+
+void journalClose(Journal* j) {
+    if (!j) return;
+    platformMutexLock(&j->lock);
+    j->stop = true;
+    platformCondSignal(&j->wake);
+    platformMutexUnlock(&j->lock);
+    platformThreadJoin(j->writer);
+
+    if (j->f) fclose(j->f);
+    platformCondDestroy(&j->durable);
+    platformCondDestroy(&j->wake);
+    platformMutexDestroy(&j->lock);
+    free(j->pending);
+    free(j->batch);
+    free(j->path);
+    free(j);
+}
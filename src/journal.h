@@ -0,0 +1,72 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "money.h"
+
+// Append-only binary journal of trades and deposits.
+// Appends only queue the record in memory; a background writer thread drains
+// the queue, writes every pending record and issues one fsync per batch
+// (group commit), so the UI never waits on the disk.
+// On open the existing file is replayed through a callback and any torn tail
+// (a partially written last record) is cut off.
+// Records appended together (journalAppendGroup) replay all-or-nothing: a
+// group cut short by a crash is dropped as part of the torn tail.
+// Once a snapshot covers every record up to some seq, journalCompact drops
+// that prefix; the file header keeps the base seq so numbering continues.
+
+typedef enum {
+    JOURNAL_BUY     = 1,   // qty shares of symbol at amount per share
+    JOURNAL_SELL    = 2,
+    JOURNAL_DEPOSIT = 3,   // amount added to cash
+    JOURNAL_RELIEF  = 4,   // qty = lot relief method for the sales that follow
+} JournalType;
+
+#define JOURNAL_FLAG_MORE  0x01   // another record of the same group follows
+
+// 32 bytes, little-endian on disk as laid out in memory.
+typedef struct {
+    uint64_t seq;          // 1, 2, 3 ... across the life of the journal, also across compactions
+    int64_t  amount;       // Money
+    char     symbol[8];    // NUL padded
+    int32_t  qty;
+    uint8_t  type;         // JournalType
+    uint8_t  flags;        // JOURNAL_FLAG_*
+    uint16_t check;        // hash of the bytes above, detects torn writes
+} JournalRecord;
+
+typedef struct Journal Journal;
+typedef void (*JournalApplyFn)(const JournalRecord* r, void* user);
+
+// Replay 'path' through apply (may be NULL) and open it for appending.
+// Records with seq <= coveredSeq are already reflected in a loaded snapshot
+// and are skipped; new records are numbered after max(last seq, coveredSeq).
+// Creates the file if missing. Returns NULL if the file cannot be opened.
+// *replayed (optional) receives the number of records applied.
+Journal* journalOpen(const char* path, uint64_t coveredSeq, JournalApplyFn apply, void* user, long long* replayed);
+
+// Queue a record; returns its sequence number. Never blocks on I/O.
+uint64_t journalAppend(Journal* j, JournalType type, const char* symbol, int qty, Money amount);
+
+// Fill a record's payload (type, symbol, qty, amount) for journalAppendGroup.
+void journalRecordSet(JournalRecord* r, JournalType type, const char* symbol, int qty, Money amount);
+
+// Queue n records as one atomic group; seq, flags and check are assigned here.
+// Returns the seq of the last record (0 on failure).
+uint64_t journalAppendGroup(Journal* j, JournalRecord* recs, int n);
+
+// Block until every record appended so far is on stable storage.
+void journalFlush(Journal* j);
+
+// Sequence number of the newest record (durable or queued).
+uint64_t journalLastSeq(Journal* j);
+
+// Drop every record with seq <= throughSeq (a durable snapshot covers them).
+// The rewrite happens on the writer thread; appends keep queueing meanwhile.
+void journalCompact(Journal* j, uint64_t throughSeq);
+
+// Flush, stop the writer and close the file.
+void journalClose(Journal* j);
+
+#endif // JOURNAL_H
@@ -0,0 +1,135 @@
+#include "leaderboard.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One of the two heaps. 'top' keeps its worst item at the root, 'rest' its best.
+typedef struct {
+    uint32_t* ids;
+    int       count;
+    bool      worstFirst;
+} Heap;
+
+struct Leaderboard {
+    int      count, k;
+    int64_t* keys;
+    int32_t* slot;          // id -> index in its heap
+    uint8_t* inTop;         // id -> which heap
+    Heap     top, rest;
+};
+
+static inline bool better(const Leaderboard* lb, uint32_t a, uint32_t b) {
+    return lb->keys[a] > lb->keys[b] || (lb->keys[a] == lb->keys[b] && a < b);
+}
+
+// a belongs above b in heap h
+static inline bool above(const Leaderboard* lb, const Heap* h, uint32_t a, uint32_t b) {
+    return h->worstFirst ? better(lb, b, a) : better(lb, a, b);
+}
+
+static inline void place(Leaderboard* lb, Heap* h, int i, uint32_t id) {
+    h->ids[i] = id;
+    lb->slot[id] = i;
+}
+
+static void siftUp(Leaderboard* lb, Heap* h, int i) {
+    uint32_t id = h->ids[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!above(lb, h, id, h->ids[parent])) break;
+        place(lb, h, i, h->ids[parent]);
+        i = parent;
+    }
+    place(lb, h, i, id);
+}
+
+static void siftDown(Leaderboard* lb, Heap* h, int i) {
+    uint32_t id = h->ids[i];
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= h->count) break;
+        if (c + 1 < h->count && above(lb, h, h->ids[c + 1], h->ids[c])) ++c;
+        if (!above(lb, h, h->ids[c], id)) break;
+        place(lb, h, i, h->ids[c]);
+        i = c;
+    }
+    place(lb, h, i, id);
+}
+
+static void resift(Leaderboard* lb, Heap* h, uint32_t id) {
+    siftUp(lb, h, lb->slot[id]);
+    siftDown(lb, h, lb->slot[id]);
+}
+
+Leaderboard* leaderboardCreate(int count, int k, const int64_t* keys) {
+    if (count < 0 || k < 0) return NULL;
+    if (k > count) k = count;
+    Leaderboard* lb = (Leaderboard*)calloc(1, sizeof(Leaderboard));
+    if (!lb) return NULL;
+    size_t n = (size_t)count + 1;
+    lb->count = count;
+    lb->k     = k;
+    lb->keys  = (int64_t*)malloc(n * sizeof(int64_t));
+    lb->slot  = (int32_t*)malloc(n * sizeof(int32_t));
+    lb->inTop = (uint8_t*)calloc(n, 1);
+    lb->top.ids  = (uint32_t*)malloc(((size_t)k + 1) * sizeof(uint32_t));
+    lb->rest.ids = (uint32_t*)malloc(n * sizeof(uint32_t));
+    if (!lb->keys || !lb->slot || !lb->inTop || !lb->top.ids || !lb->rest.ids) {
+        leaderboardFree(lb);
+        return NULL;
+    }
+    memcpy(lb->keys, keys, (size_t)count * sizeof(int64_t));
+    lb->top.worstFirst = true;
+
+    // Everything into 'rest' (heapified bottom up, O(N)), then pop the best k into 'top'
+    for (int i = 0; i < count; ++i) place(lb, &lb->rest, i, (uint32_t)i);
+    lb->rest.count = count;
+    for (int i = count / 2 - 1; i >= 0; --i) siftDown(lb, &lb->rest, i);
+    for (int j = 0; j < k; ++j) {
+        uint32_t best = lb->rest.ids[0];
+        place(lb, &lb->rest, 0, lb->rest.ids[--lb->rest.count]);
+        if (lb->rest.count > 0) siftDown(lb, &lb->rest, 0);
+        lb->inTop[best] = 1;
+        place(lb, &lb->top, lb->top.count++, best);
+        siftUp(lb, &lb->top, lb->top.count - 1);
+    }
+    return lb;
+}
+
+void leaderboardFree(Leaderboard* lb) {
+    if (!lb) return;
+    free(lb->keys); free(lb->slot); free(lb->inTop);
+    free(lb->top.ids); free(lb->rest.ids);
+    free(lb);
+}
+
+void leaderboardUpdate(Leaderboard* lb, uint32_t id, int64_t key) {
+    if (lb->keys[id] == key) return;
+    lb->keys[id] = key;
+    Heap* h = lb->inTop[id] ? &lb->top : &lb->rest;
+    resift(lb, h, id);
+
+    // Only this item can have crossed the boundary: one root swap restores it
+    if (lb->top.count == 0 || lb->rest.count == 0) return;
+    uint32_t weakest = lb->top.ids[0], strongest = lb->rest.ids[0];
+    if (!better(lb, strongest, weakest)) return;
+    lb->inTop[strongest] = 1;
+    lb->inTop[weakest]   = 0;
+    place(lb, &lb->top, 0, strongest);
+    place(lb, &lb->rest, 0, weakest);
+    siftDown(lb, &lb->top, 0);
+    siftDown(lb, &lb->rest, 0);
+}
+
+int leaderboardTop(const Leaderboard* lb, uint32_t* out, int cap) {
+    // Insertion into a best-first list of at most cap (k is small)
+    int n = 0;
+    for (int i = 0; i < lb->top.count; ++i) {
+        uint32_t x = lb->top.ids[i];
+        if (n == cap && (cap <= 0 || !better(lb, x, out[n - 1]))) continue;
+        int j = (n < cap) ? n++ : n - 1;
+        while (j > 0 && better(lb, x, out[j - 1])) { out[j] = out[j - 1]; --j; }
+        out[j] = x;
+    }
+    return n;
+}
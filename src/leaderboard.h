@@ -0,0 +1,27 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+
+// Top K of a fixed set of items by an int64 key, kept exact as keys change.
+// The items are split between two heaps: the K best in a min-heap whose root
+// is the weakest of them, the rest in a max-heap whose root is the strongest
+// outsider. Every item's heap slot is indexed, so a key change sifts the item
+// in place and, if it now beats the other side's root, swaps the two roots:
+// O(log N) per update, no sorting. Reading the top K sorts only those K.
+// Ties break by id (lower first).
+
+typedef struct Leaderboard Leaderboard;
+
+// Board of the best k of 'count' items with the given initial keys. NULL if
+// out of memory.
+Leaderboard* leaderboardCreate(int count, int k, const int64_t* keys);
+void leaderboardFree(Leaderboard* lb);
+
+// New key for one item.
+void leaderboardUpdate(Leaderboard* lb, uint32_t id, int64_t key);
+
+// The top ids, best first, up to cap; returns how many were written.
+int leaderboardTop(const Leaderboard* lb, uint32_t* out, int cap);
+
+#endif // LEADERBOARD_H
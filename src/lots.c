@@ -0,0 +1,149 @@
+#include "lots.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NIL 0u
+
+_Static_assert(sizeof(Lot) == 48, "keep lots compact");
+
+bool lotPoolInit(LotPool* p, uint32_t capacity) {
+    memset(p, 0, sizeof(*p));
+    p->cap  = capacity + 1;
+    p->lots = (Lot*)calloc(p->cap, sizeof(Lot));
+    if (!p->lots) return false;
+    for (uint32_t i = 1; i < p->cap; ++i) p->lots[i].next = (i + 1 < p->cap) ? i + 1 : NIL;
+    p->freeHead = (p->cap > 1) ? 1 : NIL;
+    return true;
+}
+
+void lotPoolFree(LotPool* p) {
+    free(p->lots);
+    memset(p, 0, sizeof(*p));
+}
+
+bool lotQueueInit(LotQueue* q, const LotPool* p) {
+    memset(q, 0, sizeof(*q));
+    q->heap = (uint32_t*)malloc((size_t)p->cap * sizeof(uint32_t));
+    return q->heap != NULL;
+}
+
+void lotQueueFree(LotQueue* q) {
+    free(q->heap);
+    memset(q, 0, sizeof(*q));
+}
+
+// ---- HIFO heap ----
+static inline bool costlier(const LotPool* p, uint32_t a, uint32_t b) {
+    const Lot* x = &p->lots[a];
+    const Lot* y = &p->lots[b];
+    if (x->unitCost != y->unitCost) return x->unitCost > y->unitCost;
+    return (int32_t)(x->seq - y->seq) < 0;
+}
+
+static inline void heapPlace(LotPool* p, LotQueue* q, uint32_t i, uint32_t slot) {
+    q->heap[i] = slot;
+    p->lots[slot].heapPos = i;
+}
+
+static void siftUp(LotPool* p, LotQueue* q, uint32_t i) {
+    uint32_t slot = q->heap[i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!costlier(p, slot, q->heap[parent])) break;
+        heapPlace(p, q, i, q->heap[parent]);
+        i = parent;
+    }
+    heapPlace(p, q, i, slot);
+}
+
+static void siftDown(LotPool* p, LotQueue* q, uint32_t i) {
+    uint32_t slot = q->heap[i];
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= q->heapLen) break;
+        if (c + 1 < q->heapLen && costlier(p, q->heap[c + 1], q->heap[c])) c++;
+        if (!costlier(p, q->heap[c], slot)) break;
+        heapPlace(p, q, i, q->heap[c]);
+        i = c;
+    }
+    heapPlace(p, q, i, slot);
+}
+
+// ---- lots ----
+uint32_t lotOpen(LotPool* p, LotQueue* q, int32_t qty, Money unitCost, Money basis) {
+    if (p->freeHead == NIL) return NIL;
+    uint32_t slot = p->freeHead;
+    Lot* l = &p->lots[slot];
+    p->freeHead = l->next;
+    p->used++;
+
+    l->basis    = basis;
+    l->unitCost = unitCost;
+    l->realized = 0;
+    l->qty      = qty;
+    l->seq      = p->nextSeq++;
+    l->next     = NIL;
+    l->prev     = q->tail;
+    if (q->tail != NIL) p->lots[q->tail].next = slot; else q->head = slot;
+    q->tail = slot;
+    q->count++;
+
+    heapPlace(p, q, q->heapLen++, slot);
+    siftUp(p, q, l->heapPos);
+    return slot;
+}
+
+bool lotMergeNewest(LotPool* p, LotQueue* q, int32_t qty, Money basis) {
+    if (q->tail == NIL) return false;
+    Lot* l = &p->lots[q->tail];
+    l->qty   += qty;
+    l->basis += basis;
+    return true;
+}
+
+static void closeLot(LotPool* p, LotQueue* q, uint32_t slot) {
+    Lot* l = &p->lots[slot];
+    if (l->prev != NIL) p->lots[l->prev].next = l->next; else q->head = l->next;
+    if (l->next != NIL) p->lots[l->next].prev = l->prev; else q->tail = l->prev;
+    q->count--;
+
+    uint32_t i = l->heapPos;
+    uint32_t last = q->heap[--q->heapLen];
+    if (last != slot) {
+        heapPlace(p, q, i, last);
+        siftDown(p, q, i);
+        siftUp(p, q, p->lots[last].heapPos);
+    }
+
+    l->next = p->freeHead;
+    p->freeHead = slot;
+    p->used--;
+}
+
+Money lotRelieve(LotPool* p, LotQueue* q, int32_t qty, Money price, ReliefMethod method) {
+    Money relieved = 0;
+    while (qty > 0 && q->count > 0) {
+        uint32_t slot = (method == RELIEF_LIFO) ? q->tail
+                      : (method == RELIEF_HIFO) ? q->heap[0]
+                      : q->head;
+        Lot* l = &p->lots[slot];
+        int32_t take = (qty < l->qty) ? qty : l->qty;
+        Money part = (take == l->qty) ? l->basis : moneyMulDiv(l->basis, take, l->qty);
+        l->basis    -= part;
+        l->qty      -= take;
+        l->realized += moneyMulInt(price, take) - part;
+        relieved    += part;
+        qty         -= take;
+        if (l->qty == 0) closeLot(p, q, slot);
+    }
+    return relieved;
+}
+
+const char* reliefMethodName(ReliefMethod m) {
+    switch (m) {
+    case RELIEF_FIFO: return "FIFO";
+    case RELIEF_LIFO: return "LIFO";
+    case RELIEF_HIFO: return "HIFO";
+    default:          return "?";
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef LOTS_H
+#define LOTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "money.h"
+
+// Tax lots. Every buy opens a lot; sells relieve lots in the order picked by
+// the relief method, and the basis relieved is what realized P&L is measured
+// against. Lots come from one fixed pool shared by all symbols (48-byte
+// nodes, free list, allocated once), so the trade path never allocates.
+// Each symbol's queue links its lots in open order (FIFO from the head, LIFO
+// from the tail) and keeps a max-heap on purchase price for HIFO.
+
+typedef enum { RELIEF_FIFO = 0, RELIEF_LIFO = 1, RELIEF_HIFO = 2, RELIEF_METHOD_COUNT } ReliefMethod;
+
+typedef struct {
+    Money    basis;        // cost of the shares still held
+    Money    unitCost;     // purchase price per share (HIFO key)
+    Money    realized;     // P&L booked by partial sales of this lot
+    int32_t  qty;          // shares still held
+    uint32_t seq;          // open order, breaks HIFO ties (older first)
+    uint32_t prev, next;   // queue links; 'next' doubles as the free list
+    uint32_t heapPos;
+    uint32_t pad;
+} Lot;
+
+typedef struct {
+    Lot*     lots;         // slot 0 unused, 0 = none
+    uint32_t cap, used;
+    uint32_t freeHead;
+    uint32_t nextSeq;
+} LotPool;
+
+typedef struct {
+    uint32_t  head, tail;  // oldest, newest
+    uint32_t* heap;        // slots by unitCost, highest first
+    uint32_t  heapLen;
+    int       count;
+} LotQueue;
+
+// Pool of 'capacity' lots, allocated up front. False if out of memory.
+bool lotPoolInit(LotPool* p, uint32_t capacity);
+void lotPoolFree(LotPool* p);
+
+// Lots still free in the pool.
+static inline uint32_t lotPoolAvailable(const LotPool* p) { return p->cap - 1 - p->used; }
+
+// Queue able to hold every lot of the pool.
+bool lotQueueInit(LotQueue* q, const LotPool* p);
+void lotQueueFree(LotQueue* q);
+
+// Open a lot of qty shares at unitCost with the given basis. Returns its slot,
+// 0 if the pool is full.
+uint32_t lotOpen(LotPool* p, LotQueue* q, int32_t qty, Money unitCost, Money basis);
+
+// Fold qty shares and basis into the newest lot (pool full fallback). False if
+// the queue is empty.
+bool lotMergeNewest(LotPool* p, LotQueue* q, int32_t qty, Money basis);
+
+// Relieve qty shares (at most what the queue holds) sold at 'price' per share.
+// Partial relief takes qty/lotQty of a lot's basis; a lot's last share takes
+// the rest. Books each lot's realized P&L and returns the total basis relieved.
+Money lotRelieve(LotPool* p, LotQueue* q, int32_t qty, Money price, ReliefMethod method);
+
+// Lots in open order: for (uint32_t i = q->head; i; i = p->lots[i].next)
+
+// Mark-to-market P&L of what is left of a lot.
+static inline Money lotUnrealized(const Lot* l, Money price) { return moneyMulInt(price, l->qty) - l->basis; }
+
+// "FIFO", "LIFO", "HIFO".
+const char* reliefMethodName(ReliefMethod m);
+
+#endif // LOTS_H
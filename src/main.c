@@ -6,6 +6,7 @@
 #include <time.h>
 #include <math.h>
 #include <ctype.h> // <-- added
+#include <limits.h>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -14,6 +15,22 @@
 #include "stb_easy_font/stb_easy_font.h"
 
 #include "helpers.h"
+#include "candles.h"
+#include "candlestore.h"
+#include "money.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "orderbook.h"
+#include "triggers.h"
+#include "lots.h"
+#include "portfolio.h"
+#include "risk.h"
+#include "symbolindex.h"
+#include "searchworker.h"
+#include "symbolmaster.h"
+#include "widgets.h"
+#include "sortedview.h"
+#include "leaderboard.h"
 
 static int windowWidth = 800;
 static int windowHeight = 600;
@@ -24,37 +41,113 @@ static Tab currentTab = TAB_HOME;
 static bool  searchBarActive = false;
 static char  searchText[256] = {0};
 static int   searchLen = 0;
+static SearchWorker* searchWorker = NULL;   // runs every edit of searchText
+static const SearchResults* searchShown = NULL;   // newest completed, taken once per frame
+static float searchScroll = 0.0f;   // result rows scrolled past, fractional
+static void searchTextEdited(void) { searchSubmit(searchWorker, searchText); searchScroll = 0.0f; }
 
 static unsigned int rectShader = 0, textShader = 0;
 
-static unsigned int searchBarVAO = 0, chartVAO = 0, navBarVAO = 0;
+static unsigned int searchBarVAO = 0, navBarVAO = 0;
 
-typedef struct {
-    const char* symbol;
-    float price;
-    int   qty;
-    float avgCost;
-    float totalCost;
-} Stock;
-
-static Stock stocks[3] = {
-    {"AAPL", 180.0f, 0, 0.0f, 0.0f},
-    {"MSFT", 330.0f, 0, 0.0f, 0.0f},
-    {"NVDA", 900.0f, 0, 0.0f, 0.0f}
-};
+// The one portfolio the app trades; 'stocks' is shorthand for its positions.
+// Prices and fills go through portfolioSetPrice / fillPosition so the
+// aggregates stay in step.
+static const char* const STOCK_SYMBOLS[3] = { "AAPL", "MSFT", "NVDA" };
+static const char* const STOCK_NAMES[3]   = { "Apple Inc.", "Microsoft Corp.", "NVIDIA Corp." };
+static const Money STOCK_OPEN_PRICES[3]   = { MONEY_UNITS(180), MONEY_UNITS(330), MONEY_UNITS(900) };
+static const Money STARTING_CASH          = MONEY_UNITS(10000);
+static Portfolio portfolio;
+static Position* const stocks = portfolio.pos;
+static float tickVolume[3];     // shares traded since the candles last consumed it
 
 static int   selectedStock = 0;
-static float cashBalance   = 10000.0f;
-static float realizedPnL   = 0.0f;
 
-static unsigned int stockVAO[3];
-static const float stockX = -0.75f, stockW = 0.55f, stockH = 0.14f;
-static const float stockY[3] = { 0.70f, 0.48f, 0.26f };
+// Positions table (Stocks tab): every instrument in the symbol master with its
+// quote and, for the traded stocks, the position. A header row of sortable
+// columns over a scrolling list; like the search results, only the rows in
+// view are formatted and drawn, the row backgrounds as one instanced draw.
+// The row order is a SortedView on the sort column's key: ticks and fills
+// update the keys that moved and the view repairs itself once per frame.
+typedef enum { POS_SYMBOL, POS_PRICE, POS_CHANGE, POS_QTY, POS_AVG, POS_VALUE, POS_PNL, POS_COLUMNS } PosColumn;
+static const char* const POS_TITLES[POS_COLUMNS] = { "Symbol", "Price", "Chg %", "Qty", "Avg", "Value", "P&L" };
+static const float POS_COLUMN_AT[POS_COLUMNS]    = { 0.0f, 0.11f, 0.27f, 0.41f, 0.51f, 0.67f, 0.84f };   // fractions of posW
+static const float posX = -0.78f, posY = 0.72f, posW = 0.94f;
+static const float posHeaderH = 0.06f;
+static const float posRowH = 0.055f, posRowStep = 0.065f;
+static const float posListH = 0.54f;   // rows between the header and the ticket
+#define POS_MAX_VISIBLE 10             // rows that can be partly in view at once
+static SortedView* posView = NULL;    // master ids in table order
+static int64_t* posKeys = NULL;        // scratch for re-sorting on a new column
+static PosColumn posSortColumn = POS_SYMBOL;
+static bool  posSortDesc  = false;
+static float posScroll = 0.0f;         // rows scrolled past, fractional
 
 static unsigned int buyBtnVAO = 0, sellBtnVAO = 0;
 static const float buyX = -0.75f, buyY = -0.05f, buyW = 0.28f, buyH = 0.10f;
 static const float sellX = -0.43f, sellY = -0.05f, sellW = 0.28f, sellH = 0.10f;
 
+// Numeric text entry shared by the Add Balance modal and the order ticket
+typedef struct {
+    char text[64];
+    int  len;
+    int  maxLen;        // 0 = buffer size
+    bool allowDot;      // decimal amounts vs whole quantities
+} NumericField;
+
+// Order ticket (Stocks tab): BUY/SELL trade the quantity field (empty = 1) at
+// market, or rest as a limit order when a limit price is typed.
+// Shift+click stages a market leg in a basket that is sent as one atomic order.
+static NumericField qtyInput   = { .maxLen = 7 };
+static NumericField limitInput = { .allowDot = true };
+static NumericField* ticketFocus = NULL;          // field receiving keystrokes
+static unsigned int qtyInputVAO = 0, limitInputVAO = 0;
+static const float qtyX = -0.11f, qtyY = -0.05f, qtyW = 0.22f, qtyH = 0.10f;
+static const float limX = -0.11f, limY = -0.20f, limW = 0.22f, limH = 0.10f;
+
+// Resting limit orders: one book per stock, matched against every price tick.
+// Buys reserve cash and sells reserve shares until they fill or are cancelled.
+#define MAX_OPEN_ORDERS 16
+typedef struct { OrderId id; int stock; } OpenOrder;
+static OrderBook* books[3];
+static OpenOrder openOrders[MAX_OPEN_ORDERS];
+static int   openOrderCount = 0;
+static Money reservedCash = 0;
+static int   reservedQty[3];
+static unsigned int ordersPanelVAO = 0;
+static const float ordersX = -0.75f, ordersY = -0.35f, ordersW = 0.86f, ordersH = 0.45f;
+
+// Price triggers, one set per stock, checked on every tick. The trigger price
+// comes from the Limit field: STOP / TP sell the ticket quantity at market
+// once the price falls / rises to it, ALERT only raises a banner.
+typedef enum { TRIG_STOP_LOSS = 1, TRIG_TAKE_PROFIT = 2, TRIG_ALERT = 3 } TriggerKind;
+static TriggerSet* triggers[3];
+static unsigned int stopBtnVAO = 0, tpBtnVAO = 0, alertBtnVAO = 0;
+static const float stopX = -0.75f, tpX = -0.55f, alertX = -0.35f;
+static const float trigY = -0.20f, trigW = 0.18f, trigH = 0.10f;
+// Banner across the top of the window for fired triggers
+static unsigned int alertBannerVAO = 0;
+static const float bannerX = -1.0f, bannerY = 1.0f, bannerW = 2.0f, bannerH = 0.08f;
+static char   alertText[128] = {0};
+static double alertUntil = 0.0;
+
+#define MAX_BASKET_LEGS 8
+typedef struct { int stock; int qty; } OrderLeg;   // qty > 0 buys, < 0 sells
+static OrderLeg basket[MAX_BASKET_LEGS];
+static int basketLen = 0;
+static unsigned int basketPanelVAO = 0, basketSendVAO = 0, basketClearVAO = 0;
+static const float basketX = 0.20f, basketY = 0.70f, basketW = 0.55f, basketH = 0.60f;
+static const float sendX = 0.20f, sendY = 0.05f, sendW = 0.26f, sendH = 0.10f;
+static const float clearX = 0.49f, clearY = 0.05f, clearW = 0.26f, clearH = 0.10f;
+
+// Tax lots: every buy opens a lot, sells relieve them by portfolio.relief.
+// The pool is allocated once at startup; when it runs out, buys fold into the
+// symbol's newest lot instead of opening one.
+#define LOT_POOL_CAPACITY 65536
+static unsigned int lotsPanelVAO = 0, reliefBtnVAO = 0;
+static const float lotsX = 0.15f, lotsY = -0.10f, lotsW = 0.83f, lotsH = 0.70f;
+static const float reliefX = 0.78f, reliefY = 0.05f, reliefW = 0.20f, reliefH = 0.10f;
+
 static const float navX = -1.0f, navY = -0.85f, navW = 2.0f, navH = 0.15f;
 static unsigned int homeBodyVAO=0, homeRoofVAO=0;
 static unsigned int stockBar1VAO=0, stockBar2VAO=0, stockBar3VAO=0;
@@ -69,8 +162,7 @@ static const float addBtnX = -0.20f, addBtnY = -0.86f, addBtnW = 0.40f, addBtnH
 // NEW: Add-Balance modal UI
 static bool addModalOpen = false;
 static bool addInputActive = false;
-static char addInputText[64] = {0};
-static int  addInputLen = 0;
+static NumericField addInput = { .allowDot = true };
 static unsigned int addPanelVAO = 0, addInputVAO = 0, addConfirmBtnVAO = 0;
 // panel rect: centered box
 static const float panelX = -0.40f, panelY = 0.30f, panelW = 0.80f, panelH = 0.60f;
@@ -87,29 +179,107 @@ static bool   blinkOn   = true;
 static const double PRICE_UPDATE_DT = 0.25;
 static double lastPriceUpdate = 0.0;
 
-typedef struct { float open, high, low, close; bool valid; } Candle;
-#define MAX_CANDLES 240
-static Candle candles[MAX_CANDLES];
-static int    candleCount     = 0;
-static int    currentCandle   = -1;
 static const double CANDLE_DT = 1.0;
-static double lastCandleTime  = 0.0;
-
+static double sessionStart    = 0.0;
+static CandleSeries portfolioSeries = { .current = -1 };   // total return
+static CandleSeries symbolSeries[3] = {                      // price per stock
+    { .current = -1 }, { .current = -1 }, { .current = -1 } };
+// Compressed history of every closed candle, decoded only for scrolled-back panes
+static CandleStore portfolioArchive, symbolArchive[3];
+
+// Monte Carlo risk of the open positions, recomputed in the background every
+// RISK_DT seconds. Volatilities and correlations come from the candle closes
+// on screen, scaled to one trading day.
+#define RISK_PATHS 100000
+static RiskEngine* riskEngine = NULL;
+static const double RISK_DT          = 3.0;
+static const double RISK_DAY_SECONDS = 6.5 * 3600.0;
+static const double RISK_CONFIDENCE  = 0.99;
+static const int    RISK_STEPS       = 13;      // half-hour increments
+static double   lastRiskRun = 0.0;
+static uint64_t riskJob = 0;                    // newest submitted, 0 = none
+
+// Shared chart pipelines: every pane appends into the same buffers in
+// pane-local [-1,1] coordinates and is drawn under its own viewport/scissor.
 static unsigned int candleUpVAO=0, candleUpVBO=0;
 static unsigned int candleDnVAO=0, candleDnVBO=0;
-static unsigned int wickVAO=0, wickVBO=0;
-static int upVertCount = 0, dnVertCount = 0, wickVertCount = 0;
+static unsigned int chartLineVAO=0, chartLineVBO=0;   // wicks + indicator lines
+static unsigned int paneBgVAO = 0;                    // unit quad covering a pane
+// Volume histogram: one unit quad instanced per candle {slot, volume, up}
+static unsigned int volShader = 0;
+static unsigned int volVAO = 0, volQuadVBO = 0, volInstVBO = 0;
 
+// Area the panes tile; the top movers panel sits to its right
 static const float chartLeftNDC   = -0.8f;
 static const float chartTopNDC    =  0.60f;
-static const float chartWidthNDC  =  1.6f;
+static const float chartWidthNDC  =  1.18f;
 static const float chartHeightNDC =  1.20f;
 
 // --- Search results (rendered on Home under the search bar) ---
-static unsigned int searchResVAO[3] = {0,0,0};
+// A scrolling list: row k sits at resYBase - (k - searchScroll) * resYStep and
+// only rows inside the list area are formatted and drawn.
 static const float resX = -0.70f, resW = 1.40f, resH = 0.12f;
 static const float resYBase = 0.80f;   // first row starts just under the search bar
 static const float resYStep = 0.14f;   // spacing between rows
+static const float resListH = 0.84f;   // six rows tall
+#define RES_MAX_VISIBLE 8              // rows that can be partly in view at once
+
+// Flat rects drawn as instances of one unit quad, {x, y, w, h} each (NDC,
+// top-left origin like createRectangle)
+static unsigned int instRectShader = 0;
+static unsigned int instRectVAO = 0, instRectQuadVBO = 0, instRectVBO = 0;
+
+// Many strings tessellated into one buffer and drawn at once; the scale is
+// applied on the CPU so every string can have its own origin.
+typedef struct {
+    float* v;
+    int    floats, cap;
+} TextBatch;
+static TextBatch textBatch;
+
+// Text tessellated once and redrawn from its own VBO until the string moves or changes.
+typedef struct {
+    unsigned int vao, vbo;
+    int   vertCount;
+    float x, y;
+    char  text[256];
+} RetainedText;
+
+// --- Chart panes ---
+typedef enum { PANE_PORTFOLIO = 0, PANE_SYMBOL = 1, PANE_INDICATOR = 2, PANE_VOLUME = 3 } PaneKind;
+typedef struct {
+    PaneKind kind;
+    int   stock;                 // -1 follows selectedStock
+    float x, y, w, h;            // NDC rect, top-left origin like createRectangle
+    // vertex ranges inside the shared chart buffers
+    int   upFirst, upCount, dnFirst, dnCount;
+    int   wickFirst, wickCount, lineFirst, lineCount;
+    int   volFirst, volCount;    // instances in the volume buffer
+    float volMax, step, bodyW;   // volume scale and candle x-layout for the shader
+    int   scrollBack;            // candles behind live; 0 = live ring
+    const CandleStore* viewStore; long viewTotal; int viewScroll;   // what 'view' holds
+    RetainedText label;
+} Pane;
+#define MAX_PANES 16
+static Pane panes[MAX_PANES];
+static CandleSeries paneViews[MAX_PANES];   // archive windows for scrolled panes
+static int  paneCount = 0;
+static const int paneLayouts[] = { 4, 8, 16 };   // F2 cycles
+static int  paneLayout = 0;
+
+// --- Crosshair hover over the chart ---
+// Cursor position comes from the cursor-pos callback; the hovered candle is
+// resolved in O(1) from x using the same slot math as the pane mesh builder.
+static bool  hoverActive = false;
+static float hoverNdcX = 0.0f, hoverNdcY = 0.0f;
+static int   hoverPane = -1;
+static int   hoverCandle = -1;            // ring index under the cursor, -1 if none
+static unsigned int crosshairVAO = 0, crosshairVBO = 0;
+static float crosshairVerts[12];
+
+static RetainedText hoverReadout = {0};
+static int    readoutPane = -1, readoutCandle = -1;   // what the readout was last built for
+static Candle readoutValues, readoutSince;   // hovered candle and hovered..latest aggregate
 
 static const char* rectVS =
 "#version 330 core\n"
@@ -122,6 +292,36 @@ static const char* rectFS =
 "uniform vec3 uColor;\n"
 "void main(){ FragColor = vec4(uColor, 1.0); }\n";
 
+static const char* volVS =
+"#version 330 core\n"
+"layout (location = 0) in vec2 aCorner;\n"   // unit quad, 0..1
+"layout (location = 1) in vec3 aBar;\n"      // slot, volume, up
+"uniform float uStep;\n"
+"uniform float uBodyW;\n"
+"uniform float uMaxVolume;\n"
+"out vec3 vColor;\n"
+"void main(){\n"
+"  float xc = -1.0 + (aBar.x + 0.5) * uStep;\n"
+"  float x  = xc + (aCorner.x - 0.5) * uBodyW;\n"
+"  float y  = -1.0 + aCorner.y * 1.9 * (aBar.y / uMaxVolume);\n"
+"  vColor = mix(vec3(0.90,0.45,0.45), vec3(0.45,0.78,0.52), aBar.z);\n"
+"  gl_Position = vec4(x, y, -0.25, 1.0);\n"
+"}\n";
+
+static const char* volFS =
+"#version 330 core\n"
+"in vec3 vColor;\n"
+"out vec4 FragColor;\n"
+"void main(){ FragColor = vec4(vColor, 1.0); }\n";
+
+static const char* instRectVS =
+"#version 330 core\n"
+"layout (location = 0) in vec2 aCorner;\n"   // unit quad, 0..1
+"layout (location = 1) in vec4 aRect;\n"     // x, y (top-left), w, h
+"void main(){\n"
+"  gl_Position = vec4(aRect.x + aCorner.x * aRect.z, aRect.y - aCorner.y * aRect.w, 0.0, 1.0);\n"
+"}\n";
+
 static const char* textVS =
 "#version 330 core\n"
 "layout (location = 0) in vec2 aPos;\n"
@@ -145,70 +345,744 @@ static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 static void key_callback(GLFWwindow *window, int key, int sc, int action, int mods);
 static void char_callback(GLFWwindow *window, unsigned int codepoint);
+static void cursor_pos_callback(GLFWwindow *window, double xp, double yp);
+static void scroll_callback(GLFWwindow *window, double xoff, double yoff);
 
 static void initTextRendering(void);
 static void renderText(float x, float y, const char *text);
+static void retainedTextSet(RetainedText* rt, float x, float y, const char *text);
+static void retainedTextDraw(const RetainedText* rt);
 static float measureTextWidthRaw(const char *text);
+static void textBatchAdd(TextBatch* b, float x, float y, float scale, const char *text);
+static void textBatchDraw(TextBatch* b);
+static void drawRectInstances(const float* rects, int count, float r, float g, float b);
 static float ndcToPixelX(float ndcX);
 static float ndcToPixelY(float ndcY);
 
-static void initCandleSeries(float initialValue);
-static void updateCandleSeries(double now, float valueToChart);
 static float mapYValue(float val, float vmin, float vmax, float chartBottom, float height);
-static void rebuildCandleMeshes(void);
+static void setPaneLayout(int n);
+static void rebuildChartMeshes(void);
+static void drawPanes(void);
+static int  paneAtNDC(float ndcX, float ndcY);
+static CandleStore* paneArchive(const Pane* p);
+static int  candleIndexAtX(const Pane* p, float ndcX);
+static void updateHover(void);
 static void updatePricesRandomWalk(void);
+static void submitRiskJob(void);
+static void drawWidget(const Widget* w);
+static void posRefreshStock(int i);
+
+// Debug builds: the delta-maintained aggregates must match a full recount exactly.
+static void aggCheckDbg(const char* where) {
+#ifndef NDEBUG
+    if (!portfolioCheck(&portfolio))
+        fprintf(stderr, "[books] %s: aggregates out of sync\n", where);
+#else
+    (void)where;
+#endif
+}
+
+// ---- Trade application: shared by the click handlers and journal replay ----
+static Journal* journal = NULL;
+static const char* JOURNAL_PATH = "portfolio.journal";
+
+// Move a position by qty shares at 'price' (buy > 0, sell < 0).
+// No checks here: applyOrder and placeLimitOrder validate first, replay trusts
+// the journal.
+static void movePosition(int i, int qty, Money price) {
+    portfolioFill(&portfolio, i, qty, price);
+    posRefreshStock(i);
+}
+
+// A live fill: move the position and count the shares toward the current
+// candle's volume.
+static void fillPosition(int i, int qty, Money price) {
+    movePosition(i, qty, price);
+    tickVolume[i] += (float)abs(qty);
+}
 
-static inline float portfolioHoldingsValue(void) {
-    float v = 0.0f;
-    for (int i = 0; i < 3; ++i) v += stocks[i].qty * stocks[i].price;
-    return v;
+// Execute n legs as one all-or-nothing order. Legs on the same symbol are
+// netted; the order must fit the cash (sale proceeds count) and the positions
+// as a whole, net of what open limit orders reserve. Every affected position
+// is then filled in a single pass and journaled as one atomic group.
+// Returns false, changing nothing, otherwise.
+static bool applyOrder(const OrderLeg* legs, int n) {
+    long long net[3] = {0};
+    for (int k = 0; k < n; ++k) {
+        if (legs[k].stock < 0 || legs[k].stock >= 3 || legs[k].qty == 0) return false;
+        net[legs[k].stock] += legs[k].qty;
+    }
+    Money cash = portfolio.cash - reservedCash;
+    for (int i = 0; i < 3; ++i) {
+        if (net[i] != 0 && !portfolioCanFill(&portfolio, i, net[i], reservedQty[i])) return false;
+        cash -= moneyMulInt(stocks[i].price, net[i]);
+    }
+    if (cash < 0) return false;
+
+    JournalRecord recs[3];
+    int nrec = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (net[i] == 0) continue;
+        fillPosition(i, (int)net[i], stocks[i].price);
+        journalRecordSet(&recs[nrec++], (net[i] > 0) ? JOURNAL_BUY : JOURNAL_SELL,
+                         stocks[i].symbol, (int)llabs(net[i]), stocks[i].price);
+    }
+    aggCheckDbg("order");
+    journalAppendGroup(journal, recs, nrec);
+    return nrec > 0;
+}
+
+// Switch the relief method for later sales. Journaled, so replay relieves
+// the same lots as the session did.
+static void setReliefMethod(ReliefMethod m) {
+    if (m == portfolio.relief) return;
+    portfolio.relief = m;
+    journalAppend(journal, JOURNAL_RELIEF, NULL, (int)m, 0);
+}
+
+// Journal replay: trades re-execute at their recorded price.
+static void replayJournalRecord(const JournalRecord* r, void* user) {
+    (void)user;
+    if (r->type == JOURNAL_DEPOSIT) { portfolioDeposit(&portfolio, r->amount); return; }
+    if (r->type == JOURNAL_RELIEF) {
+        if (r->qty >= 0 && r->qty < RELIEF_METHOD_COUNT) portfolio.relief = (ReliefMethod)r->qty;
+        return;
+    }
+    int i = portfolioFind(&portfolio, r->symbol, sizeof(r->symbol));
+    if (i < 0) return;
+    if (r->qty <= 0) return;
+    portfolioSetPrice(&portfolio, i, r->amount);
+    // Historic fills: no candle volume, the first live candle would carry it all
+    if (r->type == JOURNAL_BUY)  movePosition(i, r->qty, r->amount);
+    if (r->type == JOURNAL_SELL && r->qty <= stocks[i].qty) movePosition(i, -r->qty, r->amount);
 }
-static inline float portfolioInvested(void) {
-    float v = 0.0f;
-    for (int i = 0; i < 3; ++i) v += stocks[i].totalCost;
-    return v;
+
+// ---- Limit orders ----
+static const Money BOOK_TICK = MONEY_ONE / 100;
+
+static void removeOpenOrder(int k) {
+    for (int m = k + 1; m < openOrderCount; ++m) openOrders[m - 1] = openOrders[m];
+    openOrderCount--;
 }
-static inline float portfolioUnrealizedPnL(void) {
-    return portfolioHoldingsValue() - portfolioInvested();
+
+// Book fill: release the reservation taken at the limit, then trade at the
+// fill price (a tick can print through the limit, never against it).
+static void onBookFill(const BookFill* f, void* user) {
+    (void)user;
+    int i = (int)f->owner;
+    if (f->order == 0) return;            // own orders never cross, see placeLimitOrder
+    if (f->side == BOOK_BUY) {
+        reservedCash -= moneyMulInt(f->limit, f->qty);
+        fillPosition(i, f->qty, f->price);
+    } else {
+        reservedQty[i] -= f->qty;
+        fillPosition(i, -f->qty, f->price);
+    }
+    aggCheckDbg("limit fill");
+    journalAppend(journal, (f->side == BOOK_BUY) ? JOURNAL_BUY : JOURNAL_SELL, stocks[i].symbol, f->qty, f->price);
+    if (f->remaining > 0) return;
+    for (int k = 0; k < openOrderCount; ++k)
+        if (openOrders[k].id == f->order) { removeOpenOrder(k); break; }
 }
-static inline float portfolioTotalReturn(void) {
-    return realizedPnL + portfolioUnrealizedPnL();
+
+// One cent ladder per stock, from one tick up to four times the opening
+// price (at most 64^3 levels, $2621.44). Limits outside it are rejected.
+static void createBooks(void) {
+    for (int i = 0; i < 3; ++i) {
+        Money levels = moneyMulInt(stocks[i].price, 4) / BOOK_TICK;
+        if (levels > 64 * 64 * 64) levels = 64 * 64 * 64;
+        books[i] = orderBookCreate(BOOK_TICK, BOOK_TICK, (int)levels, MAX_OPEN_ORDERS);
+        if (books[i]) orderBookSetFillHandler(books[i], onBookFill, NULL);
+    }
 }
-static inline bool hasAnyPosition(void) {
-    for (int i = 0; i < 3; ++i) if (stocks[i].qty > 0) return true;
+
+// Banner for a limit order that was not placed; returns false for the caller
+static bool rejectLimitOrder(int i, const char* why) {
+    snprintf(alertText, sizeof(alertText), "LIMIT %s rejected: %s", stocks[i].symbol, why);
+    alertUntil = glfwGetTime() + 4.0;
     return false;
 }
-// Equity = cash + live holdings
-static inline float portfolioEquity(void) {
-    return cashBalance + portfolioHoldingsValue();
+
+// Rest qty shares (buy > 0, sell < 0) at 'limit', snapped to the cent.
+// Fails, with a banner saying why, if it would trade with one of our own
+// resting orders, if the unreserved cash / shares cannot cover it, or if the
+// limit is off the book's ladder.
+static bool placeLimitOrder(int i, int qty, Money limit) {
+    BookSide side = (qty > 0) ? BOOK_BUY : BOOK_SELL;
+    int n = abs(qty);
+    limit = moneyDivInt(limit, BOOK_TICK) * BOOK_TICK;
+    if (!books[i] || n <= 0 || limit <= 0) return rejectLimitOrder(i, "no price or quantity");
+    if (openOrderCount == MAX_OPEN_ORDERS) return rejectLimitOrder(i, "too many open orders");
+    Money best;
+    if (side == BOOK_BUY  && orderBookBestAsk(books[i], &best) && limit >= best)
+        return rejectLimitOrder(i, "would cross your own sell");
+    if (side == BOOK_SELL && orderBookBestBid(books[i], &best) && limit <= best)
+        return rejectLimitOrder(i, "would cross your own buy");
+    Money cost = moneyMulInt(limit, n);
+    if (side == BOOK_BUY && cost > portfolio.cash - reservedCash) return rejectLimitOrder(i, "not enough free cash");
+    if (!portfolioCanFill(&portfolio, i, side == BOOK_BUY ? n : -n, reservedQty[i]))
+        return rejectLimitOrder(i, "not enough free shares");
+
+    OrderId id = orderBookLimit(books[i], side, limit, n, (uint32_t)i, NULL);
+    if (!id) return rejectLimitOrder(i, "price outside the book's range");
+    if (side == BOOK_BUY) reservedCash += cost;
+    else                  reservedQty[i] += n;
+    openOrders[openOrderCount++] = (OpenOrder){ id, i };
+    return true;
 }
 
-// -------- Search helpers --------
-static bool icontains(const char* hay, const char* needle) {
-    if (!hay || !needle || !*needle) return false;
-    size_t nlen = strlen(needle);
-    size_t hlen = strlen(hay);
-    for (size_t i = 0; i + nlen <= hlen; ++i) {
-        bool ok = true;
-        for (size_t j = 0; j < nlen; ++j) {
-            char a = (char)toupper((unsigned char)hay[i+j]);
-            char b = (char)toupper((unsigned char)needle[j]);
-            if (a != b) { ok = false; break; }
+static void cancelOpenOrder(int k) {
+    OpenOrder* o = &openOrders[k];
+    BookSide side; Money limit; int32_t left;
+    if (orderBookOrder(books[o->stock], o->id, &side, &limit, &left, NULL) && orderBookCancel(books[o->stock], o->id)) {
+        if (side == BOOK_BUY) reservedCash -= moneyMulInt(limit, left);
+        else                  reservedQty[o->stock] -= left;
+    }
+    removeOpenOrder(k);
+}
+
+// ---- Numeric fields ----
+static void numericFieldClear(NumericField* f) {
+    f->len = 0;
+    f->text[0] = '\0';
+}
+
+static void numericFieldBackspace(NumericField* f) {
+    if (f->len > 0) f->text[--f->len] = '\0';
+}
+
+// Digits, plus a single '.' when allowDot; anything else is ignored.
+static void numericFieldChar(NumericField* f, unsigned int codepoint) {
+    if (codepoint == 8) { numericFieldBackspace(f); return; }
+    if (!((codepoint >= '0' && codepoint <= '9') || (codepoint == '.' && f->allowDot))) return;
+    if (codepoint == '.') {
+        for (int i = 0; i < f->len; ++i) if (f->text[i] == '.') return;
+    }
+    int cap = (f->maxLen > 0) ? f->maxLen : (int)sizeof(f->text) - 1;
+    if (f->len < cap) {
+        f->text[f->len++] = (char)codepoint;
+        f->text[f->len] = '\0';
+    }
+}
+
+// Ticket quantity: the typed number, 1 when the field is empty.
+static int ticketQty(void) {
+    if (qtyInput.len == 0) return 1;
+    return atoi(qtyInput.text);
+}
+
+// ---- Snapshots: periodic checkpoints of the whole app, the journal holds the tail ----
+static SnapshotWriter* snapshotWriter = NULL;
+static const char* SNAPSHOT_PATH = "portfolio.snapshot";
+static const double SNAPSHOT_DT = 30.0;
+static double lastSnapshot = 0.0;
+
+#define SNAP_STATE_VERSION 2
+
+typedef struct {
+    char    symbol[8];
+    int64_t price, totalCost;
+    int32_t qty, pad;
+} SnapStock;
+
+typedef struct {
+    int32_t count, pad;
+    double  dt;
+    Candle  candles[MAX_CANDLES];   // oldest first
+} SnapSeries;
+
+typedef struct {
+    int64_t basis, unitCost, realized;
+    int32_t stock, qty;
+} SnapLot;
+
+// Flat image of everything worth keeping across runs. Candle times are
+// glfwGetTime() based, so 'clock' lets a restore shift them to the new session.
+// lotCount SnapLots follow the struct, each stock's lots in open order.
+// Resting limit orders (with their cash / share reservations) and price
+// triggers are session-only and not in here: they are not journaled, so a
+// snapshot alone could not restore them consistently; a fill journaled after
+// the snapshot would replay against an order the snapshot still shows resting.
+typedef struct {
+    uint32_t   version;
+    int32_t    stockCount;
+    double     clock;
+    double     sessionStart;
+    int64_t    cash, realized;
+    int32_t    tab, selected, paneLayout, searchLen;
+    int32_t    relief, lotCount;
+    char       searchText[256];
+    SnapStock  stock[3];
+    SnapSeries portfolio, symbol[3];
+} SnapState;
+
+static void captureSeries(const CandleSeries* s, SnapSeries* out) {
+    out->dt = s->dt;
+    if (s->current < 0) return;
+    for (int k = 0; k < s->count; ++k) out->candles[k] = s->candles[candleSeriesIndex(s, k)];
+    out->count = s->count;
+}
+
+// Copy the live state into a private buffer for the writer thread. Only the UI
+// thread mutates this state, so the copy is consistent with journalLastSeq().
+static void takeSnapshot(void) {
+    if (!snapshotWriter) return;
+    int lotCount = 0;
+    for (int i = 0; i < 3; ++i) lotCount += portfolio.queues[i].count;
+    size_t size = sizeof(SnapState) + (size_t)lotCount * sizeof(SnapLot);
+    SnapState* st = (SnapState*)calloc(1, size);   // zeroed: padding is checksummed too
+    if (!st) return;
+    st->version      = SNAP_STATE_VERSION;
+    st->stockCount   = 3;
+    st->clock        = glfwGetTime();
+    st->sessionStart = sessionStart;
+    st->cash         = portfolio.cash;
+    st->realized     = portfolio.realized;
+    st->tab          = (int32_t)currentTab;
+    st->selected     = selectedStock;
+    st->paneLayout   = paneLayout;
+    st->searchLen    = searchLen;
+    memcpy(st->searchText, searchText, sizeof(st->searchText));
+    st->relief       = (int32_t)portfolio.relief;
+    st->lotCount     = lotCount;
+    SnapLot* lot = (SnapLot*)(st + 1);
+    for (int i = 0; i < 3; ++i)
+        for (uint32_t l = portfolio.queues[i].head; l; l = portfolio.lots.lots[l].next, ++lot) {
+            const Lot* src = &portfolio.lots.lots[l];
+            *lot = (SnapLot){ src->basis, src->unitCost, src->realized, i, src->qty };
         }
-        if (ok) return true;
+    for (int i = 0; i < 3; ++i) {
+        SnapStock* o = &st->stock[i];
+        for (size_t k = 0; k < sizeof(o->symbol) && stocks[i].symbol[k]; ++k) o->symbol[k] = stocks[i].symbol[k];
+        o->price     = stocks[i].price;
+        o->totalCost = stocks[i].totalCost;
+        o->qty       = stocks[i].qty;
+        captureSeries(&symbolSeries[i], &st->symbol[i]);
     }
-    return false;
+    captureSeries(&portfolioSeries, &st->portfolio);
+    if (!snapshotSubmit(snapshotWriter, st, size, journalLastSeq(journal))) free(st);
+}
+
+// Reload a ring, shifting its times into this session. Closed candles are also
+// fed to the (empty) archive so scrolling back reaches them.
+static void restoreSeries(CandleSeries* s, const SnapSeries* in, double shift) {
+    int n = (in->count > MAX_CANDLES) ? MAX_CANDLES : in->count;
+    if (n <= 0) return;
+    static Candle tmp[MAX_CANDLES];
+    for (int k = 0; k < n; ++k) { tmp[k] = in->candles[k]; tmp[k].time += shift; }
+    CandleStore* archive = s->archive;
+    candleSeriesLoad(s, tmp, n, in->dt);
+    s->archive = archive;
+    for (int k = 0; archive && k < n - 1; ++k) candleStoreAppend(archive, &tmp[k]);
+}
+
+static bool restoreSnapshot(const void* data, size_t size) {
+    const SnapState* st = (const SnapState*)data;
+    if (size < sizeof(SnapState) || st->version != SNAP_STATE_VERSION || st->lotCount < 0 ||
+        size != sizeof(SnapState) + (size_t)st->lotCount * sizeof(SnapLot)) return false;
+
+    double shift = glfwGetTime() - st->clock;
+    sessionStart = st->sessionStart + shift;
+    portfolio.cash     = st->cash;
+    portfolio.realized = st->realized;
+    for (int k = 0; k < st->stockCount && k < 3; ++k) {
+        const SnapStock* o = &st->stock[k];
+        int i = portfolioFind(&portfolio, o->symbol, sizeof(o->symbol));
+        if (i < 0) continue;
+        portfolioSetPosition(&portfolio, i, o->price, o->qty, o->totalCost);
+        restoreSeries(&symbolSeries[i], &st->symbol[k], shift);
+    }
+    restoreSeries(&portfolioSeries, &st->portfolio, shift);
+    const SnapLot* lot = (const SnapLot*)(st + 1);
+    for (int k = 0; k < st->lotCount; ++k, ++lot) {
+        if (lot->stock < 0 || lot->stock >= st->stockCount || lot->stock >= 3) continue;
+        int i = portfolioFind(&portfolio, st->stock[lot->stock].symbol, sizeof(st->stock[0].symbol));
+        if (i < 0) continue;
+        uint32_t l = lotOpen(&portfolio.lots, &portfolio.queues[i], lot->qty, lot->unitCost, lot->basis);
+        if (l) portfolio.lots.lots[l].realized = lot->realized;
+        else   lotMergeNewest(&portfolio.lots, &portfolio.queues[i], lot->qty, lot->basis);
+    }
+    if (st->relief >= 0 && st->relief < RELIEF_METHOD_COUNT) portfolio.relief = (ReliefMethod)st->relief;
+    aggCheckDbg("snapshot");
+
+    if (st->tab == TAB_HOME || st->tab == TAB_STOCKS) currentTab = (Tab)st->tab;
+    if (st->selected >= 0 && st->selected < 3) selectedStock = st->selected;
+    int layouts = (int)(sizeof(paneLayouts) / sizeof(paneLayouts[0]));
+    if (st->paneLayout >= 0 && st->paneLayout < layouts) paneLayout = st->paneLayout;
+    if (st->searchLen >= 0 && st->searchLen < (int)sizeof(searchText)) {
+        memcpy(searchText, st->searchText, (size_t)st->searchLen);
+        searchText[st->searchLen] = '\0';
+        searchLen = st->searchLen;
+        searchTextEdited();
+    }
+    return true;
 }
-// Fill outIdx with indices of matching stocks; returns match count (0..3)
-static int computeSearchMatches(int* outIdx /* size >= 3 */) {
-    int m = 0;
-    if (searchLen == 0) return 0;
+
+// Formats money for on-screen text; a few rotating buffers so one snprintf can take several.
+static const char* moneyStr(Money m) {
+    static char bufs[4][32];
+    static int  next = 0;
+    char* b = bufs[next++ & 3];
+    moneyFormat(b, 32, m);
+    return b;
+}
+
+// ---- Triggers ----
+static void onTriggerFire(const TriggerFire* f, void* user) {
+    int i = (int)(intptr_t)user;
+    const Position* s = &stocks[i];
+    if (f->tag == TRIG_ALERT) {
+        snprintf(alertText, sizeof(alertText), "ALERT %s %s $%s (now $%s)", s->symbol,
+                 f->dir == TRIGGER_ABOVE ? "rose to" : "fell to", moneyStr(f->threshold), moneyStr(f->price));
+    } else {
+        // Sell what is still free; shares held back by limit sells stay put
+        int qty = f->arg;
+        if (qty > s->qty - reservedQty[i]) qty = s->qty - reservedQty[i];
+        OrderLeg leg = { i, -qty };
+        const char* name = (f->tag == TRIG_STOP_LOSS) ? "STOP" : "TAKE PROFIT";
+        if (qty > 0 && applyOrder(&leg, 1))
+            snprintf(alertText, sizeof(alertText), "%s %s at $%s: sold %d @ $%s",
+                     name, s->symbol, moneyStr(f->threshold), qty, moneyStr(f->price));
+        else
+            snprintf(alertText, sizeof(alertText), "%s %s at $%s: nothing to sell",
+                     name, s->symbol, moneyStr(f->threshold));
+    }
+    alertUntil = glfwGetTime() + 4.0;
+}
+
+static void createTriggers(void) {
     for (int i = 0; i < 3; ++i) {
-        if (icontains(stocks[i].symbol, searchText)) {
-            outIdx[m++] = i;
-        }
+        triggers[i] = triggerSetCreate(1024);
+        if (triggers[i]) triggerSetHandler(triggers[i], onTriggerFire, (void*)(intptr_t)i);
+    }
+}
+
+// Arm a trigger on the selected stock at the Limit price. An alert fires on
+// whichever side of the current price the level lies.
+static void armTrigger(TriggerKind kind) {
+    int i = selectedStock;
+    Money level;
+    if (!triggers[i] || limitInput.len == 0 || !moneyParse(limitInput.text, &level) || level <= 0) return;
+    int qty = ticketQty();
+    if (kind != TRIG_ALERT && qty <= 0) return;
+    TriggerDir dir = (kind == TRIG_STOP_LOSS)   ? TRIGGER_BELOW
+                   : (kind == TRIG_TAKE_PROFIT) ? TRIGGER_ABOVE
+                   : (level > stocks[i].price)  ? TRIGGER_ABOVE : TRIGGER_BELOW;
+    triggerAdd(triggers[i], dir, level, (uint32_t)kind, qty);
+}
+
+// -------- Search helpers --------
+// Every listed instrument comes from the symbol master, mapped at startup; the
+// index and the rows below point straight into the mapping. Entry ids are
+// master record indices; stockMaster maps the traded stocks onto them.
+static SymbolMaster* symbolMaster = NULL;
+static const char* SYMBOL_MASTER_PATH = "symbols.master";
+static SymbolIndex* searchIndex = NULL;
+static int stockMaster[3] = { -1, -1, -1 };
+
+// Seed file for a fresh install: the traded stocks only
+static const char* const STOCK_SECTORS[3]   = { "Technology", "Technology", "Semiconductors" };
+static const char* const STOCK_EXCHANGES[3] = { "NASDAQ", "NASDAQ", "NASDAQ" };
+
+// Map the master (writing the seed if there is none) and index it. A master
+// that exists but does not open is left alone: the app runs without it.
+static bool loadSymbolMaster(void) {
+    symbolMaster = symbolMasterOpen(SYMBOL_MASTER_PATH);
+    if (!symbolMaster) {
+        FILE* existing = fopen(SYMBOL_MASTER_PATH, "rb");
+        if (existing) { fclose(existing); return false; }
+        SymbolInfo seed[3];
+        for (int i = 0; i < 3; ++i)
+            seed[i] = (SymbolInfo){ STOCK_SYMBOLS[i], STOCK_NAMES[i], STOCK_SECTORS[i], STOCK_EXCHANGES[i], 1 };
+        if (symbolMasterWrite(SYMBOL_MASTER_PATH, seed, 3)) symbolMaster = symbolMasterOpen(SYMBOL_MASTER_PATH);
+        if (!symbolMaster) return false;
+    }
+    int n = symbolMasterCount(symbolMaster);
+    const char** cols = (const char**)malloc(2 * ((size_t)n + 1) * sizeof(const char*));
+    if (!cols) return false;
+    for (int i = 0; i < n; ++i) {
+        cols[i]     = symbolMasterSymbol(symbolMaster, i);
+        cols[n + i] = symbolMasterName(symbolMaster, i);
+    }
+    searchIndex = symbolIndexBuild(cols, cols + n, n);
+    free(cols);
+    for (int i = 0; i < 3; ++i) stockMaster[i] = symbolMasterFind(symbolMaster, STOCK_SYMBOLS[i]);
+    return searchIndex != NULL;
+}
+
+// Traded stock behind a master record, -1 if it is only listed
+static int masterStock(uint32_t id) {
+    for (int i = 0; i < 3; ++i) if (stockMaster[i] == (int)id) return i;
+    return -1;
+}
+
+// Held positions rank first among equal search hits: their sizes go to the
+// worker as weights, again whenever one changes
+static int   searchHeld[3];
+
+static void syncSearchWeights(void) {
+    bool changed = false;
+    for (int i = 0; i < 3; ++i)
+        if (stocks[i].qty != searchHeld[i]) { searchHeld[i] = stocks[i].qty; changed = true; }
+    if (!changed) return;
+    SymbolWeight weights[3];
+    int n = 0;
+    for (int i = 0; i < 3; ++i)
+        if (stockMaster[i] >= 0 && searchHeld[i] != 0)
+            weights[n++] = (SymbolWeight){ (uint32_t)stockMaster[i], (uint32_t)abs(searchHeld[i]) };
+    searchSetWeights(searchWorker, weights, n);
+}
+
+// Display name and sector of a traded stock, from the mapping when it lists it
+static const char* stockName(int i) {
+    return (stockMaster[i] >= 0) ? symbolMasterName(symbolMaster, stockMaster[i]) : STOCK_NAMES[i];
+}
+static const char* stockSector(int i) {
+    return (stockMaster[i] >= 0) ? symbolMasterSector(symbolMaster, stockMaster[i]) : STOCK_SECTORS[i];
+}
+
+// Matching master records, best first, as last taken from the worker. They may
+// trail searchText by a keystroke while a query runs; the list shows them
+// meanwhile rather than wait.
+static const uint32_t* searchResults(int* count) {
+    *count = searchShown ? searchShown->count : 0;
+    return searchShown ? searchShown->ids : NULL;
+}
+
+// Keep the list scrolled within its rows
+static void clampSearchScroll(int count) {
+    float maxScroll = (float)count - resListH / resYStep;
+    if (searchScroll > maxScroll) searchScroll = maxScroll;
+    if (searchScroll < 0.0f) searchScroll = 0.0f;
+}
+
+// Result row under an NDC point, -1 if none
+static int searchRowAt(float ndcX, float ndcY, int count) {
+    if (ndcX < resX || ndcX > resX + resW || ndcY > resYBase || ndcY < resYBase - resListH) return -1;
+    float rows = (resYBase - ndcY) / resYStep + searchScroll;
+    int k = (int)floorf(rows);
+    if (k < 0 || k >= count || (rows - (float)k) * resYStep > resH) return -1;   // the gap between rows
+    return k;
+}
+
+// -------- Universe quotes and the positions table --------
+// Last price of every row, and its price when the session opened. Rows are
+// the symbol master's records, then any traded stock it does not list (all
+// three when there is no master), so positions always show. The traded
+// stocks mirror their positions; the rest start from a price derived from
+// the symbol and follow the same random walk.
+static Money* quotes = NULL;
+static Money* quoteOpen = NULL;
+static int    quoteCount = 0;
+static int    stockRow[3] = { -1, -1, -1 };    // each traded stock's row
+
+// Traded stock behind a row, -1 if it is only listed
+static int rowStock(uint32_t m) {
+    for (int i = 0; i < 3; ++i) if (stockRow[i] == (int)m) return i;
+    return -1;
+}
+
+static const char* rowSymbol(uint32_t m) {
+    return ((int)m < symbolMasterCount(symbolMaster)) ? symbolMasterSymbol(symbolMaster, (int)m)
+                                                      : STOCK_SYMBOLS[rowStock(m)];
+}
+
+// Symbol column key. Master rows are in symbol order already; an unlisted
+// stock goes just ahead of the first listed symbol above its own.
+static int64_t rowSymbolKey(uint32_t m) {
+    int listed = symbolMasterCount(symbolMaster), s = rowStock(m);
+    if ((int)m < listed) return (int64_t)m * 4 + 3;
+    int lo = 0, hi = listed;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (strcmp(symbolMasterSymbol(symbolMaster, mid), STOCK_SYMBOLS[s]) < 0) lo = mid + 1; else hi = mid;
+    }
+    return (int64_t)lo * 4 + s;
+}
+
+// Change since the session opened, in millionths
+static int64_t quoteChange(int m) {
+    return moneyMulDiv(quotes[m] - quoteOpen[m], 1000000, quoteOpen[m]);
+}
+
+// Top movers (Home): the best and worst MOVERS_SHOWN by change since the
+// open, kept by two leaderboards updated with every quote tick
+#define MOVERS_SHOWN 5
+static Leaderboard* gainers = NULL;
+static Leaderboard* losers  = NULL;     // keyed by the negated change
+static const float moversX = 0.42f, moversY = 0.60f, moversW = 0.54f, moversH = 0.62f;
+
+// Value of a numeric column for one instrument; untraded ones hold nothing
+static Money posCell(uint32_t m, PosColumn c) {
+    int s = rowStock(m);
+    if (c == POS_PRICE) return quotes[m];
+    if (s < 0) return 0;
+    switch (c) {
+    case POS_QTY:   return MONEY_UNITS(stocks[s].qty);
+    case POS_AVG:   return stocks[s].avgCost;
+    case POS_VALUE: return moneyMulInt(stocks[s].price, stocks[s].qty);
+    case POS_PNL:   return moneyMulInt(stocks[s].price, stocks[s].qty) - stocks[s].totalCost;
+    default:        return 0;
+    }
+}
+
+// Sort key of a row under the current column
+static int64_t posKey(uint32_t m) {
+    int64_t k = (posSortColumn == POS_SYMBOL) ? rowSymbolKey(m)
+              : (posSortColumn == POS_CHANGE) ? quoteChange((int)m)
+              : posCell(m, posSortColumn);
+    return posSortDesc ? -k : k;
+}
+
+// A row's quote or position moved: requeue its key for the next repair
+static void posRefresh(int m) {
+    if (posView && m >= 0) sortedViewSet(posView, (uint32_t)m, posKey((uint32_t)m));
+}
+
+static void posRefreshStock(int i) {
+    posRefresh(stockRow[i]);
+}
+
+// New sort column or direction: every key changes, sort from scratch
+static void posResort(void) {
+    if (!posView) return;
+    for (int m = 0; m < quoteCount; ++m) posKeys[m] = posKey((uint32_t)m);
+    sortedViewReset(posView, posKeys);
+}
+
+static bool initQuotes(void) {
+    quoteCount = symbolMasterCount(symbolMaster);
+    for (int i = 0; i < 3; ++i) stockRow[i] = (stockMaster[i] >= 0) ? stockMaster[i] : quoteCount++;
+    quotes    = (Money*)malloc(((size_t)quoteCount + 1) * sizeof(Money));
+    quoteOpen = (Money*)malloc(((size_t)quoteCount + 1) * sizeof(Money));
+    posKeys   = (int64_t*)malloc(((size_t)quoteCount + 1) * sizeof(int64_t));
+    posView   = sortedViewCreate(quoteCount);
+    if (posKeys) memset(posKeys, 0, ((size_t)quoteCount + 1) * sizeof(int64_t));   // no change yet
+    gainers   = posKeys ? leaderboardCreate(quoteCount, MOVERS_SHOWN, posKeys) : NULL;
+    losers    = posKeys ? leaderboardCreate(quoteCount, MOVERS_SHOWN, posKeys) : NULL;
+    if (!quotes || !quoteOpen || !posKeys || !posView || !gainers || !losers) {
+        sortedViewFree(posView);
+        leaderboardFree(gainers);
+        leaderboardFree(losers);
+        posView = NULL;
+        gainers = losers = NULL;
+        quoteCount = 0;
+        for (int i = 0; i < 3; ++i) stockRow[i] = -1;
+        return false;
+    }
+    for (int m = 0; m < quoteCount; ++m) {
+        uint32_t h = 2166136261u;
+        for (const char* c = rowSymbol((uint32_t)m); *c; ++c) { h ^= (unsigned char)*c; h *= 16777619u; }
+        quotes[m] = MONEY_UNITS(5) + moneyDivInt(MONEY_UNITS(h % 50000), 100);   // $5.00 .. $504.99
     }
-    return m;
+    for (int i = 0; i < 3; ++i) quotes[stockRow[i]] = stocks[i].price;
+    memcpy(quoteOpen, quotes, (size_t)quoteCount * sizeof(Money));
+    posResort();
+    return true;
+}
+
+// Scroll the table just enough to show a row
+static void posScrollTo(int m) {
+    if (!posView || m < 0) return;
+    float k = (float)sortedViewRank(posView, (uint32_t)m), visible = posListH / posRowStep;
+    if (k < posScroll) posScroll = k;
+    else if (k + 1.0f > posScroll + visible) posScroll = k + 1.0f - visible;
+}
+
+// Keep the table scrolled within its rows
+static void clampPosScroll(void) {
+    float maxScroll = (float)quoteCount - posListH / posRowStep;
+    if (posScroll > maxScroll) posScroll = maxScroll;
+    if (posScroll < 0.0f) posScroll = 0.0f;
+}
+
+// Table row under an NDC point, -1 if none (the header included)
+static int posRowAt(float ndcX, float ndcY) {
+    float top = posY - posHeaderH;
+    if (ndcX < posX || ndcX > posX + posW || ndcY > top || ndcY < top - posListH) return -1;
+    float rows = (top - ndcY) / posRowStep + posScroll;
+    int k = (int)floorf(rows);
+    if (k < 0 || k >= quoteCount || (rows - (float)k) * posRowStep > posRowH) return -1;
+    return k;
+}
+
+// Header column under an NDC x
+static PosColumn posColumnAt(float ndcX) {
+    int c = POS_COLUMNS - 1;
+    while (c > 0 && ndcX < posX + POS_COLUMN_AT[c] * posW) --c;
+    return (PosColumn)c;
+}
+
+// -------- Widget tree --------
+// Every drawable or clickable piece of the window, in z-order. The frame
+// paints the shown nodes back to front through drawWidget and clicks go to the
+// topmost hittable node under the cursor, so a modal or a popup list covers
+// what is under it for drawing and clicking alike. Layers are shown and hidden
+// from the app state by uiSync.
+typedef enum {
+    UI_HOME, UI_CHARTS, UI_STATS, UI_MOVERS, UI_SEARCH_BAR, UI_SEARCH_LIST,
+    UI_STOCKS, UI_POSITIONS, UI_BUY, UI_SELL, UI_TICKET_FIELD, UI_TRIGGER,
+    UI_ORDERS, UI_BASKET, UI_BASKET_SEND, UI_BASKET_CLEAR, UI_LOTS, UI_RELIEF,
+    UI_NAVBAR, UI_ADD_BALANCE, UI_BANNER,
+    UI_MODAL_SCRIM, UI_MODAL_PANEL, UI_MODAL_INPUT, UI_MODAL_CONFIRM,
+} UiTag;
+
+static WidgetTree* ui = NULL;
+static int uiHome, uiStocks, uiSearchList, uiBanner, uiModal;
+
+static bool buildUi(void) {
+    ui = widgetTreeCreate();
+    if (!ui) return false;
+    const unsigned HIT = WIDGET_HITTABLE;
+
+    // Home: the background blurs the search bar, the result list floats over the charts
+    uiHome = widgetAdd(ui, WIDGET_NONE, UI_HOME, 0, -1.0f, 1.0f, 2.0f, 2.0f, 0, HIT);
+    widgetAdd(ui, uiHome, UI_CHARTS, 0, chartLeftNDC, chartTopNDC, chartWidthNDC, chartHeightNDC, 0, HIT);
+    widgetAdd(ui, uiHome, UI_STATS, 0, chartLeftNDC, chartTopNDC, chartWidthNDC, 0.30f, 1, 0);
+    widgetAdd(ui, uiHome, UI_MOVERS, 0, moversX, moversY, moversW, moversH, 1, HIT);
+    widgetAdd(ui, uiHome, UI_SEARCH_BAR, 0, -0.7f, 0.95f, 1.4f, 0.12f, 2, HIT);
+    uiSearchList = widgetAdd(ui, uiHome, UI_SEARCH_LIST, 0, resX, resYBase, resW + 0.03f, resListH, 2, HIT);
+
+    // Stocks: the background drops ticket focus
+    uiStocks = widgetAdd(ui, WIDGET_NONE, UI_STOCKS, 0, -1.0f, 1.0f, 2.0f, 2.0f, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_POSITIONS, 0, posX, posY, posW + 0.03f, posHeaderH + posListH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_BUY,  0, buyX,  buyY,  buyW,  buyH,  0, HIT);
+    widgetAdd(ui, uiStocks, UI_SELL, 0, sellX, sellY, sellW, sellH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_TICKET_FIELD, 0, qtyX, qtyY, qtyW, qtyH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_TICKET_FIELD, 1, limX, limY, limW, limH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_TRIGGER, TRIG_STOP_LOSS,   stopX,  trigY, trigW, trigH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_TRIGGER, TRIG_TAKE_PROFIT, tpX,    trigY, trigW, trigH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_TRIGGER, TRIG_ALERT,       alertX, trigY, trigW, trigH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_ORDERS, 0, ordersX, ordersY, ordersW, ordersH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_BASKET, 0, basketX, basketY, basketW, basketH, 0, 0);
+    widgetAdd(ui, uiStocks, UI_BASKET_SEND,  0, sendX,  sendY,  sendW,  sendH,  0, HIT);
+    widgetAdd(ui, uiStocks, UI_BASKET_CLEAR, 0, clearX, clearY, clearW, clearH, 0, HIT);
+    widgetAdd(ui, uiStocks, UI_LOTS, 0, lotsX, lotsY, lotsW, lotsH, 0, 0);
+    widgetAdd(ui, uiStocks, UI_RELIEF, 0, reliefX, reliefY, reliefW, reliefH, 0, HIT);
+
+    // Over both tabs: navbar, trigger banner, then the modal above everything
+    int nav = widgetAdd(ui, WIDGET_NONE, UI_NAVBAR, 0, navX, navY, navW, navH, 1, HIT);
+    widgetAdd(ui, nav, UI_ADD_BALANCE, 0, addBtnX, addBtnY, addBtnW, addBtnH, 0, HIT);
+    uiBanner = widgetAdd(ui, WIDGET_NONE, UI_BANNER, 0, bannerX, bannerY, bannerW, bannerH, 2, 0);
+    uiModal  = widgetAdd(ui, WIDGET_NONE, UI_MODAL_SCRIM, 0, -1.0f, 1.0f, 2.0f, 2.0f, 3, HIT);
+    int panel = widgetAdd(ui, uiModal, UI_MODAL_PANEL, 0, panelX, panelY, panelW, panelH, 0, HIT);
+    widgetAdd(ui, panel, UI_MODAL_INPUT, 0, inX, inY, inW, inH, 0, HIT);
+    return widgetAdd(ui, panel, UI_MODAL_CONFIRM, 0, confX, confY, confW, confH, 0, HIT) != WIDGET_NONE;
+}
+
+// Show the layers the app state calls for. Cheap when nothing changed.
+static void uiSync(void) {
+    widgetSetVisible(ui, uiHome,   currentTab == TAB_HOME);
+    widgetSetVisible(ui, uiStocks, currentTab == TAB_STOCKS);
+    widgetSetVisible(ui, uiSearchList, searchLen > 0);
+    widgetSetVisible(ui, uiBanner, glfwGetTime() < alertUntil);
+    widgetSetVisible(ui, uiModal,  addModalOpen);
+}
+
+// Tag of the node under an NDC point after syncing, -1 if none
+static int uiTagAt(float ndcX, float ndcY) {
+    uiSync();
+    return widgetTagAt(ui, ndcX, ndcY, -1);
 }
 
 int main(void) {
@@ -240,6 +1114,8 @@ int main(void) {
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCharCallback(window, char_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetScrollCallback(window, scroll_callback);
 
     if (!gladLoadGL()) { fprintf(stderr, "Failed to init GLAD\n"); glfwDestroyWindow(window); glfwTerminate(); return -1; }
     glDisable(GL_DEPTH_TEST);
@@ -247,19 +1123,26 @@ int main(void) {
 
     rectShader = buildShader(rectVS, rectFS);
     textShader = buildShader(textVS, textFS);
+    volShader  = buildShader(volVS, volFS);
+    instRectShader = buildShader(instRectVS, rectFS);
 
     searchBarVAO = createRectangle(-0.7f, 0.95f, 1.4f, 0.12f);
-    chartVAO     = createRectangle(chartLeftNDC, chartTopNDC, chartWidthNDC, chartHeightNDC);
+    paneBgVAO    = createRectangle(-1.0f, 1.0f, 2.0f, 2.0f);
 
-    // Prebuild up to 3 result rows below the search bar (Y descends in NDC)
-    for (int i = 0; i < 3; ++i) {
-        float y = resYBase - i * resYStep;
-        searchResVAO[i] = createRectangle(resX, y, resW, resH);
-    }
-
-    for (int i = 0; i < 3; ++i) stockVAO[i] = createRectangle(stockX, stockY[i], stockW, stockH);
     buyBtnVAO  = createRectangle(buyX,  buyY,  buyW,  buyH);
     sellBtnVAO = createRectangle(sellX, sellY, sellW, sellH);
+    qtyInputVAO    = createRectangle(qtyX,    qtyY,    qtyW,    qtyH);
+    limitInputVAO  = createRectangle(limX,    limY,    limW,    limH);
+    ordersPanelVAO = createRectangle(ordersX, ordersY, ordersW, ordersH);
+    stopBtnVAO     = createRectangle(stopX,   trigY,   trigW,   trigH);
+    tpBtnVAO       = createRectangle(tpX,     trigY,   trigW,   trigH);
+    alertBtnVAO    = createRectangle(alertX,  trigY,   trigW,   trigH);
+    alertBannerVAO = createRectangle(bannerX, bannerY, bannerW, bannerH);
+    basketPanelVAO = createRectangle(basketX, basketY, basketW, basketH);
+    basketSendVAO  = createRectangle(sendX,   sendY,   sendW,   sendH);
+    basketClearVAO = createRectangle(clearX,  clearY,  clearW,  clearH);
+    lotsPanelVAO   = createRectangle(lotsX,   lotsY,   lotsW,   lotsH);
+    reliefBtnVAO   = createRectangle(reliefX, reliefY, reliefW, reliefH);
 
     navBarVAO   = createRectangle(navX, navY, navW, navH);
     homeBodyVAO = createRectangle(-0.78f, -0.90f, 0.12f, 0.07f);
@@ -292,18 +1175,102 @@ int main(void) {
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
     glEnableVertexAttribArray(0);
 
-    glGenVertexArrays(1, &wickVAO);      glGenBuffers(1, &wickVBO);
-    glBindVertexArray(wickVAO);          glBindBuffer(GL_ARRAY_BUFFER, wickVBO);
-    glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
-    glEnableVertexAttribArray(0);
+    chartLineVAO = createLineVAO(3, 6, &chartLineVBO);
+
+    {
+        const float corners[12] = { 0,0, 1,0, 1,1,  0,0, 1,1, 0,1 };
+        glGenVertexArrays(1, &volVAO);
+        glGenBuffers(1, &volQuadVBO);
+        glGenBuffers(1, &volInstVBO);
+        glBindVertexArray(volVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, volQuadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, volInstVBO);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+    }
+    {
+        const float corners[12] = { 0,0, 1,0, 1,1,  0,0, 1,1, 0,1 };
+        glGenVertexArrays(1, &instRectVAO);
+        glGenBuffers(1, &instRectQuadVBO);
+        glGenBuffers(1, &instRectVBO);
+        glBindVertexArray(instRectVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instRectQuadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, instRectVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4*sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+    }
     glBindVertexArray(0);
 
+    crosshairVAO = createLineVAO(3, 12, &crosshairVBO);
+
+    candleStoreInit(&portfolioArchive);
+    portfolioSeries.archive = &portfolioArchive;
+    for (int i = 0; i < 3; ++i) {
+        candleStoreInit(&symbolArchive[i]);
+        symbolSeries[i].archive = &symbolArchive[i];
+    }
+    if (!portfolioInit(&portfolio, 3, STOCK_SYMBOLS, STOCK_OPEN_PRICES, STARTING_CASH, LOT_POOL_CAPACITY)) {
+        fprintf(stderr, "Lots: out of memory for %d lots\n", LOT_POOL_CAPACITY);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
+    if (!buildUi()) {
+        fprintf(stderr, "UI: out of memory for the widget tree\n");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
+    if (!loadSymbolMaster()) fprintf(stderr, "Search: could not load %s\n", SYMBOL_MASTER_PATH);
+    searchWorker = searchWorkerStart(searchIndex);
+    if (!searchWorker) fprintf(stderr, "Search: could not build the symbol index or start its worker\n");
+    sessionStart = glfwGetTime();
+
+    // Rebuild everything before anything reads prices or positions: the newest
+    // snapshot (mapped, not read), then only the journal records written after it
+    {
+        double t0 = glfwGetTime();
+        uint64_t covered = 0;
+        size_t size = 0;
+        const void* snap = snapshotMap(SNAPSHOT_PATH, &size, &covered);
+        if (snap && !restoreSnapshot(snap, size)) {
+            fprintf(stderr, "Snapshot: %s has an unknown layout, ignoring it\n", SNAPSHOT_PATH);
+            covered = 0;
+        }
+        snapshotUnmap(snap);
+
+        long long replayed = 0;
+        journal = journalOpen(JOURNAL_PATH, covered, replayJournalRecord, NULL, &replayed);
+        if (!journal) fprintf(stderr, "Journal: cannot open %s, trades will not be persisted\n", JOURNAL_PATH);
+        if (snap || replayed > 0)
+            fprintf(stderr, "Startup: restored snapshot seq %llu + %lld journal records in %.1f ms\n",
+                    (unsigned long long)covered, replayed, (glfwGetTime() - t0) * 1000.0);
+        snapshotWriter = snapshotWriterStart(SNAPSHOT_PATH, journal);
+    }
+    createBooks();
+    createTriggers();
+    if (!initQuotes()) fprintf(stderr, "Quotes: out of memory for %d instruments\n", quoteCount);
+    riskEngine = riskEngineStart(0, RISK_PATHS);
+    if (!riskEngine) fprintf(stderr, "Risk: cannot start workers, risk panel disabled\n");
+
     srand((unsigned)time(NULL));
     lastPriceUpdate = glfwGetTime();
-    lastCandleTime  = lastPriceUpdate;
+    lastSnapshot    = lastPriceUpdate;
 
-    for (int i=0;i<MAX_CANDLES;++i) candles[i].valid = false;
-    candleCount = 0; currentCandle = -1;
+    for (int i = 0; i < 3; ++i)
+        if (symbolSeries[i].current < 0)
+            candleSeriesInit(&symbolSeries[i], moneyToFloat(stocks[i].price), lastPriceUpdate, CANDLE_DT);
+    setPaneLayout(paneLayouts[paneLayout]);
 
     blinkLast = glfwGetTime();
 
@@ -314,377 +1281,532 @@ int main(void) {
             lastPriceUpdate = now;
         }
 
-        if (hasAnyPosition()) {
-            if (candleCount == 0 || currentCandle < 0) {
-                initCandleSeries(realizedPnL + (portfolioHoldingsValue() - portfolioInvested()));
-                lastCandleTime = now;
-            }
-            updateCandleSeries(now, realizedPnL + (portfolioHoldingsValue() - portfolioInvested()));
-            rebuildCandleMeshes();
-        } else {
-            upVertCount = dnVertCount = wickVertCount = 0;
+        for (int i = 0; i < 3; ++i) {
+            candleSeriesUpdate(&symbolSeries[i], now, moneyToFloat(stocks[i].price), tickVolume[i]);
+            tickVolume[i] = 0.0f;
+        }
+        if (portfolioHasPosition(&portfolio)) {
+            float ret = moneyToFloat(portfolioTotalReturn(&portfolio));
+            if (portfolioSeries.current < 0) candleSeriesInit(&portfolioSeries, ret, now, CANDLE_DT);
+            candleSeriesUpdate(&portfolioSeries, now, ret, 0.0f);
+        }
+        if (now - lastSnapshot >= SNAPSHOT_DT) {
+            takeSnapshot();
+            lastSnapshot = now;
         }
+        if (riskEngine && now - lastRiskRun >= RISK_DT) {
+            submitRiskJob();
+            lastRiskRun = now;
+        }
+        if (currentTab == TAB_HOME) rebuildChartMeshes();
+        updateHover();
 
         glClearColor(1,1,1,1);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(rectShader);
-
-        if (currentTab == TAB_HOME) {
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.88f, 0.88f, 0.88f);
-            glBindVertexArray(chartVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            if (wickVertCount > 0 || upVertCount > 0 || dnVertCount > 0) {
-                glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.10f, 0.10f, 0.10f);
-                glBindVertexArray(wickVAO);
-                glDrawArrays(GL_LINES, 0, wickVertCount);
-
-                glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.20f, 0.70f, 0.30f);
-                glBindVertexArray(candleUpVAO);
-                glDrawArrays(GL_TRIANGLES, 0, upVertCount);
-
-                glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.85f, 0.25f, 0.25f);
-                glBindVertexArray(candleDnVAO);
-                glDrawArrays(GL_TRIANGLES, 0, dnVertCount);
-            } else {
-                glUseProgram(textShader);
-                glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                            (float)windowWidth, (float)windowHeight);
-                float px = ndcToPixelX(chartLeftNDC) + 12.0f;
-                float py = ndcToPixelY(chartTopNDC) - 28.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.4f);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-                renderText(px, py, "Buy a stock to start charting return");
-                glUseProgram(rectShader);
-            }
+        syncSearchWeights();
+        searchShown = searchLatest(searchWorker);
+        uiSync();
+        const int* order;
+        int shown = widgetPaintOrder(ui, &order);
+        for (int k = 0; k < shown; ++k) drawWidget(widgetGet(ui, order[k]));
 
-            // Search bar background
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.65f, 0.65f, 0.65f);
-            glBindVertexArray(searchBarVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            // Search text + caret
-            if (searchBarActive || searchLen > 0) {
-                glUseProgram(textShader);
-                glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                            (float)windowWidth, (float)windowHeight);
-                const float sbTopNDC = 0.95f, sbBotNDC = 0.83f;
-                float sbTopPx = ndcToPixelY(sbTopNDC);
-                float sbBotPx = ndcToPixelY(sbBotNDC);
-                float sbMidPx = 0.5f*(sbTopPx + sbBotPx);
-
-                float textX = 120.0f;
-                float textY = sbMidPx - 4.0f;
-                float scale = 1.8f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  scale);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), textX, textY);
-                const char* toShow = (searchLen > 0) ? searchText : "Type to search...";
-                renderText(textX, textY, toShow);
-
-                double n2 = glfwGetTime();
-                if (n2 - blinkLast > 0.5) { blinkOn = !blinkOn; blinkLast = n2; }
-                if (blinkOn) {
-                    float rawW = measureTextWidthRaw(toShow);
-                    renderText(textX + rawW, textY, "|");
-                }
-                glUseProgram(rectShader);
-            }
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
 
-            // Render search results under the search bar
-            if (searchLen > 0) {
-                int idx[3]; int count = computeSearchMatches(idx);
-
-                for (int i = 0; i < count && i < 3; ++i) {
-                    // Row background
-                    glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.92f, 0.92f, 0.95f);
-                    glBindVertexArray(searchResVAO[i]);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-                    // Row text: SYMBOL  $price  xqty  avg $avgCost
-                    glUseProgram(textShader);
-                    glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                                (float)windowWidth, (float)windowHeight);
-                    float topPx  = ndcToPixelY(resYBase - i*resYStep);
-                    float botPx  = ndcToPixelY((resYBase - i*resYStep) - resH);
-                    float midPx  = 0.5f * (topPx + botPx);
-
-                    float tx = ndcToPixelX(resX) + 12.0f;
-                    float ty = midPx - 2.0f;
-                    glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.3f);
-                    glUniform2f(glGetUniformLocation(textShader, "uOrigin"), tx, ty);
-
-                    char line2[128];
-                    int s = idx[i];
-                    snprintf(line2, sizeof(line2), "%s  $%.2f  x%d  avg $%.2f",
-                             stocks[s].symbol, stocks[s].price, stocks[s].qty, stocks[s].avgCost);
-                    renderText(tx, ty, line2);
-                    glUseProgram(rectShader);
-                }
-
-                // No matches message
-                if (count == 0) {
-                    glUseProgram(textShader);
-                    glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                                (float)windowWidth, (float)windowHeight);
-                    float tx = ndcToPixelX(resX) + 12.0f;
-                    float ty = ndcToPixelY(resYBase) + 14.0f;
-                    glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.0f);
-                    glUniform2f(glGetUniformLocation(textShader, "uOrigin"), tx, ty);
-                    renderText(tx, ty, "No matching stocks");
-                    glUseProgram(rectShader);
-                }
-            }
+    // Final checkpoint so the next start replays (almost) nothing. The writer
+    // compacts the journal, so it must stop before the journal closes.
+    snapshotWait(snapshotWriter);       // a periodic one still being written would refuse it
+    takeSnapshot();
+    snapshotWriterStop(snapshotWriter);
+    journalClose(journal);
+    for (int i = 0; i < 3; ++i) { orderBookFree(books[i]); triggerSetFree(triggers[i]); }
+    portfolioFree(&portfolio);
+    searchWorkerStop(searchWorker);
+    symbolIndexFree(searchIndex);
+    symbolMasterClose(symbolMaster);
+    free(textBatch.v);
+    free(quotes);
+    free(quoteOpen);
+    free(posKeys);
+    sortedViewFree(posView);
+    leaderboardFree(gainers);
+    leaderboardFree(losers);
+    widgetTreeFree(ui);
+    riskEngineStop(riskEngine);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
 
-            // Portfolio stats on Home
-            glUseProgram(textShader);
-            glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                        (float)windowWidth, (float)windowHeight);
-            float px = ndcToPixelX(chartLeftNDC) + 10.0f;
-            float py = ndcToPixelY(chartTopNDC)  + 16.0f;
-            char line[160];
-            glUniform1f(glGetUniformLocation(textShader, "uScale"),  1.2f);
+static void glfwErrorCallback(int code, const char *desc) {
+    fprintf(stderr, "GLFW error %d: %s\n", code, desc);
+}
+static void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+    if (width < 1)  width = 1;
+    if (height < 1) height = 1;
+    glViewport(0,0,width,height);
+    windowWidth  = width;
+    windowHeight = height;
+}
 
-            snprintf(line, sizeof(line), "Cash: $%.2f", cashBalance);
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
+static bool pointInRectNDC(float x, float y, float rx, float ry, float rw, float rh) {
+    return (x >= rx && x <= rx+rw && y <= ry && y >= ry-rh);
+}
 
-            py += 16.0f;
-            snprintf(line, sizeof(line), "Holdings: $%.2f", portfolioHoldingsValue());
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
+// ---- Widget drawing: one node at a time, in the tree's paint order ----
+static void drawRect(unsigned int vao, float r, float g, float b) {
+    glUseProgram(rectShader);
+    glUniform3f(glGetUniformLocation(rectShader, "uColor"), r, g, b);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
 
-            py += 16.0f;
-            snprintf(line, sizeof(line), "Invested: $%.2f", portfolioInvested());
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
+// Text at window pixel (x, y), scaled about that point
+static void drawTextAt(float x, float y, float scale, const char* text) {
+    glUseProgram(textShader);
+    glUniform2f(glGetUniformLocation(textShader, "uResolution"), (float)windowWidth, (float)windowHeight);
+    glUniform1f(glGetUniformLocation(textShader, "uScale"), scale);
+    glUniform2f(glGetUniformLocation(textShader, "uOrigin"), x, y);
+    renderText(x, y, text);
+}
 
-            py += 16.0f;
-            snprintf(line, sizeof(line), "Unrealized: $%.2f", portfolioUnrealizedPnL());
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
+// Blinking caret after 'text' drawn at (x, y) with 'scale'
+static void drawCaret(float x, float y, float scale, const char* text) {
+    double now = glfwGetTime();
+    if (now - blinkLast > 0.5) { blinkOn = !blinkOn; blinkLast = now; }
+    if (blinkOn) drawTextAt(x + measureTextWidthRaw(text) * scale, y, scale, "|");
+}
 
-            py += 16.0f;
-            snprintf(line, sizeof(line), "Realized: $%.2f", realizedPnL);
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
+static void drawWidget(const Widget* w) {
+    char line[200];
+    switch ((UiTag)w->tag) {
+    case UI_HOME:
+        break;
 
-            py += 16.0f;
-            snprintf(line, sizeof(line), "Total Return: $%.2f", portfolioTotalReturn());
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px, py);
-            renderText(px, py, line);
-            glUseProgram(rectShader);
+    case UI_CHARTS: {
+        drawPanes();
 
-        } else {
-            for (int i = 0; i < 3; ++i) {
-                if (i == selectedStock) glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.75f, 0.75f, 0.90f);
-                else                    glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.88f, 0.88f, 0.88f);
-                glBindVertexArray(stockVAO[i]);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        // Pane labels, empty-portfolio hint and hover readout (window pixel space)
+        glUseProgram(textShader);
+        glUniform2f(glGetUniformLocation(textShader, "uResolution"),
+                    (float)windowWidth, (float)windowHeight);
+        glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.1f);
+        for (int i = 0; i < paneCount; ++i) {
+            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), panes[i].label.x, panes[i].label.y);
+            retainedTextDraw(&panes[i].label);
+            if (panes[i].kind == PANE_PORTFOLIO && panes[i].upCount + panes[i].dnCount == 0) {
+                float px = ndcToPixelX(panes[i].x) + 12.0f;
+                float py = ndcToPixelY(panes[i].y - panes[i].h) - 16.0f;
+                drawTextAt(px, py, 1.4f, "Buy a stock to start charting return");
+                glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.1f);
             }
+        }
+        if (hoverCandle >= 0) {
+            glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.2f);
+            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), hoverReadout.x, hoverReadout.y);
+            retainedTextDraw(&hoverReadout);
+        }
+        break;
+    }
 
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.60f, 0.85f, 0.60f);
-            glBindVertexArray(buyBtnVAO);  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.90f, 0.60f, 0.60f);
-            glBindVertexArray(sellBtnVAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            glUseProgram(textShader);
-            glUniform2f(glGetUniformLocation(textShader, "uResolution"),
-                        (float)windowWidth, (float)windowHeight);
-
-            for (int i = 0; i < 3; ++i) {
-                float leftPx = ndcToPixelX(stockX) + 12.0f;
-                float topPx  = ndcToPixelY(stockY[i]);
-                float botPx  = ndcToPixelY(stockY[i] - stockH);
-                float midPx  = 0.5f * (topPx + botPx);
-                float px2 = leftPx, py2 = midPx - 2.0f;
-                float scale = 1.3f;
-                char line2[128];
-                snprintf(line2, sizeof(line2), "%s  $%.2f  x%d  avg $%.2f",
-                         stocks[i].symbol, stocks[i].price, stocks[i].qty, stocks[i].avgCost);
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  scale);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px2, py2);
-                renderText(px2, py2, line2);
-            }
+    case UI_STATS: {
+        // Portfolio stats over the top of the charts
+        float px = ndcToPixelX(w->x) + 10.0f;
+        float py = ndcToPixelY(w->y) + 16.0f;
+        const char* labels[6] = { "Cash", "Holdings", "Invested", "Unrealized", "Realized", "Total Return" };
+        const Money values[6] = { portfolio.cash, portfolioHoldingsValue(&portfolio), portfolioInvested(&portfolio),
+                                  portfolioUnrealizedPnL(&portfolio), portfolio.realized, portfolioTotalReturn(&portfolio) };
+        for (int k = 0; k < 6; ++k, py += 16.0f) {
+            snprintf(line, sizeof(line), "%s: $%s", labels[k], moneyStr(values[k]));
+            drawTextAt(px, py, 1.2f, line);
+        }
 
-            {
-                float px2 = ndcToPixelX(buyX) + 20.0f;
-                float py2 = ndcToPixelY(buyY) - 10.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  1.6f);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px2, py2);
-                renderText(px2, py2, "BUY");
-
-                px2 = ndcToPixelX(sellX) + 16.0f;
-                py2 = ndcToPixelY(sellY) - 10.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  1.6f);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px2, py2);
-                renderText(px2, py2, "SELL");
-            }
+        // Risk: newest (possibly partial) Monte Carlo result
+        RiskResult rr;
+        py += 6.0f;
+        if (!riskEngine)
+            snprintf(line, sizeof(line), "Risk: unavailable");
+        else if (!portfolioHasPosition(&portfolio))
+            snprintf(line, sizeof(line), "Risk: no open positions");
+        else if (riskJob == 0)
+            snprintf(line, sizeof(line), "Risk: not enough history");
+        else if (!riskLatest(riskEngine, &rr))
+            snprintf(line, sizeof(line), "Risk: simulating...");
+        else
+            snprintf(line, sizeof(line), "1d VaR %d%%: $%s  CVaR: $%s", (int)(RISK_CONFIDENCE * 100.0 + 0.5),
+                     moneyStr((Money)llround(rr.var * MONEY_SCALE)), moneyStr((Money)llround(rr.cvar * MONEY_SCALE)));
+        drawTextAt(px, py, 1.2f, line);
+        if (riskJob != 0 && riskLatest(riskEngine, &rr)) {
+            py += 16.0f;
+            snprintf(line, sizeof(line), "%d/%d paths, %d threads%s", rr.pathsDone, rr.paths,
+                     riskWorkerCount(riskEngine), rr.job == riskJob ? "" : " (updating)");
+            drawTextAt(px, py, 1.2f, line);
+        }
+        break;
+    }
 
-            {
-                float px2 = ndcToPixelX(buyX);
-                float py2 = ndcToPixelY(buyY) - 40.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.3f);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), px2, py2);
-                char line2[128];
-                snprintf(line2, sizeof(line2), "Cash: $%.2f", cashBalance);
-                renderText(px2, py2, line2);
-                glUseProgram(rectShader);
+    case UI_MOVERS: {
+        // Gainers then losers, one batched text draw over the panel
+        if (!gainers) break;
+        const float panel[4] = { w->x, w->y, w->w, w->h };
+        drawRectInstances(panel, 1, 0.95f, 0.95f, 0.97f);
+        float px = ndcToPixelX(w->x) + 10.0f, py = ndcToPixelY(w->y) + 10.0f;
+        for (int side = 0; side < 2; ++side) {
+            uint32_t ids[MOVERS_SHOWN];
+            int n = leaderboardTop(side == 0 ? gainers : losers, ids, MOVERS_SHOWN);
+            textBatchAdd(&textBatch, px, py, 1.2f, side == 0 ? "Top gainers" : "Top losers");
+            py += 18.0f;
+            for (int k = 0; k < n; ++k, py += 14.0f) {
+                int m = (int)ids[k];
+                snprintf(line, sizeof(line), "%-6s %+7.2f%%  $%s", rowSymbol((uint32_t)m),
+                         (double)quoteChange(m) / 1e4, moneyStr(quotes[m]));
+                textBatchAdd(&textBatch, px, py, 1.0f, line);
             }
+            py += 8.0f;
         }
+        textBatchDraw(&textBatch);
+        break;
+    }
 
-        // NAVBAR BACKGROUND
-        glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.80f, 0.80f, 0.80f);
-        glBindVertexArray(navBarVAO);  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    case UI_SEARCH_BAR: {
+        drawRect(searchBarVAO, 0.65f, 0.65f, 0.65f);
 
-        // NAVBAR ICONS
-        glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.30f, 0.30f, 0.30f);
-        glBindVertexArray(homeBodyVAO);  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(homeRoofVAO);  glDrawArrays(GL_TRIANGLES, 0, 3);
-        glBindVertexArray(stockBar1VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(stockBar2VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(stockBar3VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        // Search text + caret
+        if (searchBarActive || searchLen > 0) {
+            float midPx = 0.5f * (ndcToPixelY(w->y) + ndcToPixelY(w->y - w->h));
+            float textX = 120.0f, textY = midPx - 4.0f, scale = 1.8f;
+            const char* toShow = (searchLen > 0) ? searchText : "Type to search...";
+            drawTextAt(textX, textY, scale, toShow);
+            drawCaret(textX, textY, scale, toShow);
+        }
+        break;
+    }
 
-        // Active tab underline
-        glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.20f, 0.45f, 0.85f);
-        if (currentTab == TAB_HOME) glBindVertexArray(navActiveLeftVAO);
-        else                        glBindVertexArray(navActiveRightVAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    case UI_SEARCH_LIST: {
+        // Only the rows in view
+        int count; const uint32_t* idx = searchResults(&count);
+        clampSearchScroll(count);
+
+        int first = (int)floorf(searchScroll);
+        int last  = (int)ceilf(searchScroll + resListH / resYStep);
+        if (last > count) last = count;
+        float listTopPx = ndcToPixelY(resYBase), listBotPx = ndcToPixelY(resYBase - resListH);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor((int)ndcToPixelX(resX), windowHeight - (int)listBotPx,
+                  (int)(ndcToPixelX(resX + resW) - ndcToPixelX(resX)) + 1, (int)(listBotPx - listTopPx) + 1);
+
+        float rows[4 * RES_MAX_VISIBLE];
+        int nRows = 0;
+        for (int k = first; k < last && nRows < RES_MAX_VISIBLE; ++k) {
+            float y = resYBase - ((float)k - searchScroll) * resYStep;
+            float* r = &rows[4 * nRows++];
+            r[0] = resX; r[1] = y; r[2] = resW; r[3] = resH;
+
+            // Row text: SYMBOL  Name  Sector  Exchange, then $price  xqty  avg $avgCost if traded
+            float midPx = 0.5f * (ndcToPixelY(y) + ndcToPixelY(y - resH));
+            int m = (int)idx[k], s = masterStock(idx[k]);
+            int n = snprintf(line, sizeof(line), "%s  %s  %s  %s", symbolMasterSymbol(symbolMaster, m),
+                             symbolMasterName(symbolMaster, m), symbolMasterSector(symbolMaster, m),
+                             symbolMasterExchange(symbolMaster, m));
+            if (s >= 0 && n > 0 && n < (int)sizeof(line))
+                snprintf(line + n, sizeof(line) - (size_t)n, "  $%s  x%d  avg $%s",
+                         moneyStr(stocks[s].price), stocks[s].qty, moneyStr(stocks[s].avgCost));
+            textBatchAdd(&textBatch, ndcToPixelX(resX) + 12.0f, midPx - 2.0f, 1.3f, line);
+        }
+        drawRectInstances(rows, nRows, 0.92f, 0.92f, 0.95f);
+        textBatchDraw(&textBatch);
+        glDisable(GL_SCISSOR_TEST);
+
+        // Scrollbar thumb when the list overflows
+        float visible = resListH / resYStep;
+        if ((float)count > visible) {
+            float thumbH = resListH * visible / (float)count;
+            if (thumbH < 0.04f) thumbH = 0.04f;
+            float thumb[4] = { resX + resW + 0.01f,
+                               resYBase - (resListH - thumbH) * searchScroll / ((float)count - visible),
+                               0.015f, thumbH };
+            drawRectInstances(thumb, 1, 0.55f, 0.55f, 0.60f);
+        }
+        if (count == 0) drawTextAt(ndcToPixelX(resX) + 12.0f, ndcToPixelY(resYBase) + 14.0f, 1.0f, "No matching stocks");
+        break;
+    }
 
-        // NEW: Center "Add Balance" button on navbar
-        glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.35f, 0.65f, 0.95f);
-        glBindVertexArray(navAddBtnVAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    case UI_STOCKS: {
+        snprintf(line, sizeof(line), "Cash: $%s", moneyStr(portfolio.cash));
+        drawTextAt(ndcToPixelX(buyX), ndcToPixelY(buyY) - 40.0f, 1.3f, line);
+        break;
+    }
 
-        // NAVBAR TEXT (labels + balance + add balance text)
-        glUseProgram(textShader);
-        glUniform2f(glGetUniformLocation(textShader, "uResolution"), (float)windowWidth, (float)windowHeight);
-
-        glUniform1f(glGetUniformLocation(textShader, "uScale"),  1.2f);
-        float npx = ndcToPixelX(-0.82f), npy = ndcToPixelY(-0.86f) + 12.0f;
-        glUniform2f(glGetUniformLocation(textShader, "uOrigin"), npx, npy);
-        renderText(npx, npy, "Home");
-
-        npx = ndcToPixelX(0.62f); npy = ndcToPixelY(-0.86f) + 12.0f;
-        glUniform2f(glGetUniformLocation(textShader, "uOrigin"), npx, npy);
-        renderText(npx, npy, "Stocks");
-
-        // Add Balance text (center button)
-        {
-            float scale = 1.2f;
-            float xPx = ndcToPixelX(addBtnX) + 12.0f;
-            float yPx = ndcToPixelY(addBtnY) + 12.0f;
-            glUniform1f(glGetUniformLocation(textShader, "uScale"),  scale);
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), xPx, yPx);
-            renderText(xPx, yPx, "Add Balance");
+    case UI_POSITIONS: {
+        if (!posView) break;
+        sortedViewRepair(posView);
+        const uint32_t* order = sortedViewOrder(posView);
+        clampPosScroll();
+
+        // Header: column titles, the sorted one marked with its direction
+        float head[4] = { posX, posY, posW, posHeaderH };
+        drawRectInstances(head, 1, 0.80f, 0.80f, 0.86f);
+        float headMidPx = 0.5f * (ndcToPixelY(posY) + ndcToPixelY(posY - posHeaderH));
+        for (int c = 0; c < POS_COLUMNS; ++c) {
+            snprintf(line, sizeof(line), "%s%s", POS_TITLES[c],
+                     c == (int)posSortColumn ? (posSortDesc ? " v" : " ^") : "");
+            textBatchAdd(&textBatch, ndcToPixelX(posX + POS_COLUMN_AT[c] * posW) + 6.0f, headMidPx - 4.0f, 1.1f, line);
+        }
+        textBatchDraw(&textBatch);
+
+        // Rows in view, clipped to the list
+        float top = posY - posHeaderH;
+        int first = (int)floorf(posScroll);
+        int last  = (int)ceilf(posScroll + posListH / posRowStep);
+        if (last > quoteCount) last = quoteCount;
+        float listTopPx = ndcToPixelY(top), listBotPx = ndcToPixelY(top - posListH);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor((int)ndcToPixelX(posX), windowHeight - (int)listBotPx,
+                  (int)(ndcToPixelX(posX + posW) - ndcToPixelX(posX)) + 1, (int)(listBotPx - listTopPx) + 1);
+
+        float rows[4 * POS_MAX_VISIBLE], picked[4];
+        int nRows = 0, nPicked = 0;
+        int selectedId = stockRow[selectedStock];
+        for (int k = first; k < last && nRows < POS_MAX_VISIBLE; ++k) {
+            uint32_t m = order[k];
+            float y = top - ((float)k - posScroll) * posRowStep;
+            float* r = ((int)m == selectedId) ? &picked[4 * nPicked++] : &rows[4 * nRows++];
+            r[0] = posX; r[1] = y; r[2] = posW; r[3] = posRowH;
+
+            float midPx = 0.5f * (ndcToPixelY(y) + ndcToPixelY(y - posRowH));
+            for (int c = 0; c < POS_COLUMNS; ++c) {
+                const char* cell = line;
+                if (c == POS_SYMBOL)   cell = rowSymbol(m);
+                else if (c == POS_QTY) snprintf(line, sizeof(line), "%d", (int)moneyToDouble(posCell(m, POS_QTY)));
+                else if (c == POS_CHANGE) snprintf(line, sizeof(line), "%+.2f%%", (double)quoteChange((int)m) / 1e4);
+                else                   snprintf(line, sizeof(line), "$%s", moneyStr(posCell(m, (PosColumn)c)));
+                textBatchAdd(&textBatch, ndcToPixelX(posX + POS_COLUMN_AT[c] * posW) + 6.0f, midPx - 3.0f, 1.1f, cell);
+            }
+        }
+        drawRectInstances(rows, nRows, 0.90f, 0.90f, 0.90f);
+        drawRectInstances(picked, nPicked, 0.75f, 0.75f, 0.90f);
+        textBatchDraw(&textBatch);
+        glDisable(GL_SCISSOR_TEST);
+
+        // Scrollbar thumb when the table overflows
+        float visible = posListH / posRowStep;
+        if ((float)quoteCount > visible) {
+            float thumbH = posListH * visible / (float)quoteCount;
+            if (thumbH < 0.04f) thumbH = 0.04f;
+            float thumb[4] = { posX + posW + 0.01f,
+                               top - (posListH - thumbH) * posScroll / ((float)quoteCount - visible),
+                               0.015f, thumbH };
+            drawRectInstances(thumb, 1, 0.55f, 0.55f, 0.60f);
         }
 
-        glUseProgram(rectShader);
+        // The selected stock's name and sector under the table
+        snprintf(line, sizeof(line), "%s  %s  %s", STOCK_SYMBOLS[selectedStock],
+                 stockName(selectedStock), stockSector(selectedStock));
+        drawTextAt(ndcToPixelX(posX) + 6.0f, ndcToPixelY(top - posListH) + 8.0f, 1.2f, line);
+        break;
+    }
 
-        // NEW: Add Balance Modal
-        if (addModalOpen) {
-            // Panel
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.94f, 0.94f, 0.96f);
-            glBindVertexArray(addPanelVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            // Input box
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.85f, 0.85f, 0.85f);
-            glBindVertexArray(addInputVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            // Confirm button
-            glUniform3f(glGetUniformLocation(rectShader, "uColor"), 0.40f, 0.80f, 0.50f);
-            glBindVertexArray(addConfirmBtnVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-            // Text on modal
-            glUseProgram(textShader);
-            glUniform2f(glGetUniformLocation(textShader, "uResolution"), (float)windowWidth, (float)windowHeight);
-
-            // Title
-            float tScale = 1.6f;
-            float tx = ndcToPixelX(panelX) + 20.0f;
-            float ty = ndcToPixelY(panelY) - 28.0f;
-            glUniform1f(glGetUniformLocation(textShader, "uScale"),  tScale);
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), tx, ty);
-            renderText(tx, ty, "Add Balance");
-
-            // Label
-            float lScale = 1.2f;
-            float lx = ndcToPixelX(inX);
-            float ly = ndcToPixelY(inY) - 14.0f;
-            glUniform1f(glGetUniformLocation(textShader, "uScale"),  lScale);
-            glUniform2f(glGetUniformLocation(textShader, "uOrigin"), lx, ly);
-            renderText(lx, ly, "Amount (e.g. 250.00):");
-
-            // Input text or placeholder
-            {
-                float scale = 1.4f;
-                float ix = ndcToPixelX(inX) + 10.0f;
-                float iy = ndcToPixelY(inY) + (ndcToPixelY(inY - inH) - ndcToPixelY(inY)) * 0.5f - 6.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  scale);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), ix, iy);
-                const char* toShow = (addInputLen > 0) ? addInputText : "0.00";
-                renderText(ix, iy, toShow);
-
-                double n2 = glfwGetTime();
-                if (n2 - blinkLast > 0.5) { blinkOn = !blinkOn; blinkLast = n2; }
-                if (addInputActive && blinkOn) {
-                    float rawW = measureTextWidthRaw(toShow) * scale;
-                    renderText(ix + rawW, iy, "|");
-                }
-            }
+    case UI_BUY:
+        drawRect(buyBtnVAO, 0.60f, 0.85f, 0.60f);
+        drawTextAt(ndcToPixelX(w->x) + 20.0f, ndcToPixelY(w->y) - 10.0f, 1.6f, "BUY");
+        break;
+    case UI_SELL:
+        drawRect(sellBtnVAO, 0.90f, 0.60f, 0.60f);
+        drawTextAt(ndcToPixelX(w->x) + 16.0f, ndcToPixelY(w->y) - 10.0f, 1.6f, "SELL");
+        break;
+
+    case UI_TICKET_FIELD: {
+        // Label above, value (or placeholder) and caret inside
+        NumericField* f = (w->arg == 0) ? &qtyInput : &limitInput;
+        unsigned int vao = (w->arg == 0) ? qtyInputVAO : limitInputVAO;
+        if (ticketFocus == f) drawRect(vao, 0.78f, 0.78f, 0.85f);
+        else                  drawRect(vao, 0.85f, 0.85f, 0.85f);
+        drawTextAt(ndcToPixelX(w->x), ndcToPixelY(w->y) - 14.0f, 1.2f, (w->arg == 0) ? "Qty:" : "Limit:");
+
+        float scale = 1.4f;
+        float ix = ndcToPixelX(w->x) + 10.0f;
+        float iy = ndcToPixelY(w->y) + (ndcToPixelY(w->y - w->h) - ndcToPixelY(w->y)) * 0.5f - 6.0f;
+        const char* toShow = (f->len > 0) ? f->text : (w->arg == 0) ? "1" : "MKT";
+        drawTextAt(ix, iy, scale, toShow);
+        if (ticketFocus == f) drawCaret(ix, iy, scale, toShow);
+        break;
+    }
 
-            // Confirm button text
-            {
-                float scale = 1.3f;
-                float bx = ndcToPixelX(confX) + 10.0f;
-                float by = ndcToPixelY(confY) + 14.0f;
-                glUniform1f(glGetUniformLocation(textShader, "uScale"),  scale);
-                glUniform2f(glGetUniformLocation(textShader, "uOrigin"), bx, by);
-                renderText(bx, by, "Add Balance");
-            }
+    case UI_TRIGGER: {
+        const char* name = (w->arg == TRIG_STOP_LOSS) ? "STOP" : (w->arg == TRIG_TAKE_PROFIT) ? "TP" : "ALERT";
+        if (w->arg == TRIG_STOP_LOSS)        drawRect(stopBtnVAO,  0.95f, 0.72f, 0.55f);
+        else if (w->arg == TRIG_TAKE_PROFIT) drawRect(tpBtnVAO,    0.60f, 0.80f, 0.92f);
+        else                                 drawRect(alertBtnVAO, 0.95f, 0.90f, 0.55f);
+        drawTextAt(ndcToPixelX(w->x) + 10.0f, ndcToPixelY(w->y) + 12.0f, 1.3f, name);
+        break;
+    }
 
-            glUseProgram(rectShader);
+    case UI_ORDERS: {
+        // Open limit orders, one row each; clicking a row cancels it
+        drawRect(ordersPanelVAO, 0.94f, 0.94f, 0.96f);
+        float px = ndcToPixelX(ordersX) + 12.0f;
+        float py = ndcToPixelY(ordersY) + 12.0f;
+        drawTextAt(px, py, 1.2f, openOrderCount > 0 ? "Open orders (click to cancel)" : "No open orders");
+        py += 20.0f;
+        float bottom = ndcToPixelY(ordersY - ordersH) - 14.0f;
+
+        // Last line: pending triggers and the nearest ones on the selected stock
+        int pending = 0;
+        for (int i = 0; i < 3; ++i) if (triggers[i]) pending += triggerSetCount(triggers[i]);
+        int n = snprintf(line, sizeof(line), "Triggers: %d", pending);
+        Money lv;
+        const TriggerSet* ts = triggers[selectedStock];
+        if (ts && triggerNearest(ts, TRIGGER_BELOW, &lv))
+            n += snprintf(line + n, sizeof(line) - (size_t)n, "  %s <= $%s", stocks[selectedStock].symbol, moneyStr(lv));
+        if (ts && triggerNearest(ts, TRIGGER_ABOVE, &lv) && n < (int)sizeof(line))
+            snprintf(line + n, sizeof(line) - (size_t)n, "  %s >= $%s", stocks[selectedStock].symbol, moneyStr(lv));
+        drawTextAt(px, bottom, 1.2f, line);
+        bottom -= 16.0f;
+
+        for (int k = 0; k < openOrderCount && py <= bottom; ++k, py += 16.0f) {
+            const OpenOrder* o = &openOrders[k];
+            BookSide side; Money limit; int32_t left;
+            if (!orderBookOrder(books[o->stock], o->id, &side, &limit, &left, NULL)) continue;
+            snprintf(line, sizeof(line), "%s %d %s @ $%s", side == BOOK_BUY ? "BUY " : "SELL",
+                     (int)left, stocks[o->stock].symbol, moneyStr(limit));
+            drawTextAt(px, py, 1.2f, line);
         }
+        break;
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    case UI_BASKET: {
+        // Staged legs and their net cash impact
+        drawRect(basketPanelVAO, 0.94f, 0.94f, 0.96f);
+        float px = ndcToPixelX(basketX) + 12.0f;
+        float py = ndcToPixelY(basketY) + 12.0f;
+        drawTextAt(px, py, 1.4f, "Basket");
+        py += 20.0f;
+        if (basketLen == 0) drawTextAt(px, py, 1.1f, "Shift+click BUY/SELL to add legs");
+
+        Money net = 0;
+        for (int k = 0; k < basketLen; ++k, py += 16.0f) {
+            const OrderLeg* leg = &basket[k];
+            Money amt = moneyMulInt(stocks[leg->stock].price, leg->qty);
+            net += amt;
+            snprintf(line, sizeof(line), "%s %d %s  $%s", leg->qty > 0 ? "BUY " : "SELL",
+                     abs(leg->qty), stocks[leg->stock].symbol, moneyStr(amt < 0 ? -amt : amt));
+            drawTextAt(px, py, 1.2f, line);
+        }
+        if (basketLen > 0) {
+            snprintf(line, sizeof(line), "Net cash: $%s", moneyStr(-net));
+            drawTextAt(px, py + 4.0f, 1.2f, line);
+        }
+        break;
     }
+    case UI_BASKET_SEND:
+        if (basketLen > 0) drawRect(basketSendVAO, 0.40f, 0.80f, 0.50f);
+        else               drawRect(basketSendVAO, 0.80f, 0.85f, 0.80f);
+        drawTextAt(ndcToPixelX(w->x) + 12.0f, ndcToPixelY(w->y) + 14.0f, 1.3f, "Send basket");
+        break;
+    case UI_BASKET_CLEAR:
+        drawRect(basketClearVAO, 0.85f, 0.85f, 0.85f);
+        drawTextAt(ndcToPixelX(w->x) + 12.0f, ndcToPixelY(w->y) + 14.0f, 1.3f, "Clear");
+        break;
+
+    case UI_LOTS: {
+        // Lots of the selected stock in open order with their P&L; '>' marks
+        // the lot the next sale relieves first
+        drawRect(lotsPanelVAO, 0.94f, 0.94f, 0.96f);
+        const LotQueue* q = &portfolio.queues[selectedStock];
+        const Position* s = &stocks[selectedStock];
+        float px = ndcToPixelX(lotsX) + 12.0f;
+        float py = ndcToPixelY(lotsY) + 12.0f;
+        snprintf(line, sizeof(line), "Lots %s: %d open", s->symbol, q->count);
+        drawTextAt(px, py, 1.3f, line);
+        py += 20.0f;
+
+        uint32_t next = (portfolio.relief == RELIEF_LIFO) ? q->tail
+                      : (portfolio.relief == RELIEF_HIFO && q->heapLen > 0) ? q->heap[0]
+                      : q->head;
+        float bottom = ndcToPixelY(lotsY - lotsH) - 14.0f;
+        int shown = 0;
+        for (uint32_t l = q->head; l && py <= bottom; l = portfolio.lots.lots[l].next, py += 15.0f, ++shown) {
+            const Lot* lot = &portfolio.lots.lots[l];
+            snprintf(line, sizeof(line), "%s%d @ $%s  unrl $%s  rlzd $%s", l == next ? "> " : "  ",
+                     (int)lot->qty, moneyStr(lot->unitCost), moneyStr(lotUnrealized(lot, s->price)),
+                     moneyStr(lot->realized));
+            drawTextAt(px, py, 1.1f, line);
+        }
+        if (shown < q->count) {
+            snprintf(line, sizeof(line), "  ... %d more", q->count - shown);
+            drawTextAt(px, bottom + 2.0f, 1.1f, line);
+        }
+        break;
+    }
+    case UI_RELIEF:
+        drawRect(reliefBtnVAO, 0.80f, 0.80f, 0.92f);
+        snprintf(line, sizeof(line), "Relief %s", reliefMethodName(portfolio.relief));
+        drawTextAt(ndcToPixelX(w->x) + 10.0f, ndcToPixelY(w->y) + 14.0f, 1.2f, line);
+        break;
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
-}
+    case UI_NAVBAR:
+        drawRect(navBarVAO, 0.80f, 0.80f, 0.80f);
 
-static void glfwErrorCallback(int code, const char *desc) {
-    fprintf(stderr, "GLFW error %d: %s\n", code, desc);
-}
-static void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
-    if (width < 1)  width = 1;
-    if (height < 1) height = 1;
-    glViewport(0,0,width,height);
-    windowWidth  = width;
-    windowHeight = height;
-}
+        // Icons
+        drawRect(homeBodyVAO, 0.30f, 0.30f, 0.30f);
+        glBindVertexArray(homeRoofVAO);  glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(stockBar1VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(stockBar2VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(stockBar3VAO); glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
-static bool pointInRectNDC(float x, float y, float rx, float ry, float rw, float rh) {
-    return (x >= rx && x <= rx+rw && y <= ry && y >= ry-rh);
+        // Active tab underline
+        drawRect(currentTab == TAB_HOME ? navActiveLeftVAO : navActiveRightVAO, 0.20f, 0.45f, 0.85f);
+
+        drawTextAt(ndcToPixelX(-0.82f), ndcToPixelY(-0.86f) + 12.0f, 1.2f, "Home");
+        drawTextAt(ndcToPixelX(0.62f),  ndcToPixelY(-0.86f) + 12.0f, 1.2f, "Stocks");
+        break;
+    case UI_ADD_BALANCE:
+        drawRect(navAddBtnVAO, 0.35f, 0.65f, 0.95f);
+        drawTextAt(ndcToPixelX(w->x) + 12.0f, ndcToPixelY(w->y) + 12.0f, 1.2f, "Add Balance");
+        break;
+
+    case UI_BANNER:
+        // Fired triggers, over whichever tab is showing
+        drawRect(alertBannerVAO, 0.98f, 0.88f, 0.45f);
+        drawTextAt(ndcToPixelX(w->x) + 12.0f, ndcToPixelY(w->y) + 8.0f, 1.3f, alertText);
+        break;
+
+    case UI_MODAL_SCRIM:
+        break;
+    case UI_MODAL_PANEL:
+        drawRect(addPanelVAO, 0.94f, 0.94f, 0.96f);
+        drawTextAt(ndcToPixelX(panelX) + 20.0f, ndcToPixelY(panelY) - 28.0f, 1.6f, "Add Balance");
+        drawTextAt(ndcToPixelX(inX), ndcToPixelY(inY) - 14.0f, 1.2f, "Amount (e.g. 250.00):");
+        break;
+    case UI_MODAL_INPUT: {
+        drawRect(addInputVAO, 0.85f, 0.85f, 0.85f);
+        float scale = 1.4f;
+        float ix = ndcToPixelX(inX) + 10.0f;
+        float iy = ndcToPixelY(inY) + (ndcToPixelY(inY - inH) - ndcToPixelY(inY)) * 0.5f - 6.0f;
+        const char* toShow = (addInput.len > 0) ? addInput.text : "0.00";
+        drawTextAt(ix, iy, scale, toShow);
+        if (addInputActive) drawCaret(ix, iy, scale, toShow);
+        break;
+    }
+    case UI_MODAL_CONFIRM:
+        drawRect(addConfirmBtnVAO, 0.40f, 0.80f, 0.50f);
+        drawTextAt(ndcToPixelX(confX) + 10.0f, ndcToPixelY(confY) + 14.0f, 1.3f, "Add Balance");
+        break;
+    }
+    glUseProgram(rectShader);
 }
 
 static void submitAddBalance(void) {
-    // Parse the input as float and add to cash
-    if (addInputLen > 0) {
-        float amt = (float)atof(addInputText);
-        if (amt > 0.0f && isfinite(amt)) {
-            cashBalance += amt;
-        }
+    // Parse the input straight into fixed-point and add to cash
+    Money amt;
+    if (addInput.len > 0 && moneyParse(addInput.text, &amt) && portfolioDeposit(&portfolio, amt)) {
+        journalAppend(journal, JOURNAL_DEPOSIT, NULL, 0, amt);
     }
     addModalOpen = false;
     addInputActive = false;
-    addInputLen = 0;
-    addInputText[0] = '\0';
+    numericFieldClear(&addInput);
 }
 
 static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
@@ -694,104 +1816,119 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
     float ndcX = (float)((2.0 * xp) / windowWidth - 1.0);
     float ndcY = (float)(1.0 - (2.0 * yp) / windowHeight);
 
-    // If modal is open: handle modal interactions first
-    if (addModalOpen) {
-        // Click confirm button
-        if (pointInRectNDC(ndcX, ndcY, confX, confY, confW, confH)) {
-            submitAddBalance();
-            return;
-        }
-        // Click input box
-        if (pointInRectNDC(ndcX, ndcY, inX, inY, inW, inH)) {
-            addInputActive = true;
-            return;
-        }
-        // Click outside panel closes modal
-        if (!pointInRectNDC(ndcX, ndcY, panelX, panelY, panelW, panelH)) {
-            addModalOpen = false;
-            addInputActive = false;
-            return;
-        }
-        // Click inside panel but not on input/confirm: keep focus state
-        return;
-    }
-
-    // Navbar interactions
-    if (ndcY <= navY && ndcY >= navY - navH) {
-        // Click on center "Add Balance" button?
-        if (pointInRectNDC(ndcX, ndcY, addBtnX, addBtnY, addBtnW, addBtnH)) {
-            addModalOpen = true;
-            addInputActive = true;
-            return;
-        }
-        // Otherwise, switch tab by halves
+    uiSync();
+    int id = widgetHitTest(ui, ndcX, ndcY);
+    if (id == WIDGET_NONE) return;
+    const Widget* w = widgetGet(ui, id);
+
+    switch ((UiTag)w->tag) {
+    // Add Balance modal: it covers everything, a click outside the panel closes it
+    case UI_MODAL_CONFIRM:
+        submitAddBalance();
+        break;
+    case UI_MODAL_INPUT:
+        addInputActive = true;
+        break;
+    case UI_MODAL_PANEL:
+        break;                          // keep the focus state
+    case UI_MODAL_SCRIM:
+        addModalOpen = false;
+        addInputActive = false;
+        break;
+
+    case UI_ADD_BALANCE:
+        addModalOpen = true;
+        addInputActive = true;
+        break;
+    case UI_NAVBAR:
+        // Switch tab by halves
         currentTab = (ndcX < 0.0f) ? TAB_HOME : TAB_STOCKS;
         if (currentTab != TAB_HOME) searchBarActive = false;
-        return;
-    }
-
-    if (currentTab == TAB_HOME) {
-        // Click inside search bar focuses it
-        if (ndcX >= -0.7f && ndcX <=  0.7f && ndcY <= 0.95f && ndcY >= 0.83f) {
-            searchBarActive = true;
-            return;
+        if (currentTab != TAB_STOCKS) ticketFocus = NULL;
+        break;
+
+    case UI_SEARCH_BAR:
+        searchBarActive = true;
+        break;
+    case UI_SEARCH_LIST: {
+        // A result row selects the stock and jumps to the Stocks tab
+        int count; const uint32_t* idx = searchResults(&count);
+        int k = searchRowAt(ndcX, ndcY, count);
+        if (k >= 0 && masterStock(idx[k]) >= 0) {
+            selectedStock = masterStock(idx[k]);
+            currentTab = TAB_STOCKS;
+            posScrollTo(stockRow[selectedStock]);
         }
-
-        // If there is search text, allow clicking on result rows to select
-        if (searchLen > 0) {
-            int idx[3]; int count = computeSearchMatches(idx);
-            for (int i = 0; i < count && i < 3; ++i) {
-                float y = resYBase - i * resYStep;
-                if (pointInRectNDC(ndcX, ndcY, resX, y, resW, resH)) {
-                    selectedStock = idx[i];
-                    currentTab = TAB_STOCKS;      // jump to Stocks tab
-                    searchBarActive = false;      // blur search
-                    return;
-                }
-            }
-        }
-
-        // Clicked elsewhere on Home
         searchBarActive = false;
-        return;
+        break;
     }
-
-    if (currentTab == TAB_STOCKS) {
-        for (int i = 0; i < 3; ++i) {
-            float l = stockX, r = stockX + stockW;
-            float t = stockY[i], b = stockY[i] - stockH;
-            if (ndcX >= l && ndcX <= r && ndcY <= t && ndcY >= b) {
-                selectedStock = i;
-                return;
-            }
-        }
-        if (ndcX >= buyX && ndcX <= buyX+buyW && ndcY <= buyY && ndcY >= buyY-buyH) {
-            Stock* s = &stocks[selectedStock];
-            if (cashBalance >= s->price) {
-                cashBalance -= s->price;
-                s->totalCost += s->price;
-                s->qty += 1;
-                s->avgCost = (s->qty > 0) ? (s->totalCost / (float)s->qty) : 0.0f;
-            }
-            return;
+    case UI_HOME:
+    case UI_CHARTS:
+    case UI_STATS:
+    case UI_MOVERS:
+        searchBarActive = false;
+        break;
+
+    case UI_POSITIONS: {
+        // Header: sort by the column, again to flip the direction. Row: select if traded.
+        if (ndcY > posY - posHeaderH) {
+            PosColumn c = posColumnAt(ndcX);
+            posSortDesc   = (c == posSortColumn) ? !posSortDesc : (c != POS_SYMBOL);
+            posSortColumn = c;
+            posResort();
+            break;
         }
-        if (ndcX >= sellX && ndcX <= sellX+sellW && ndcY <= sellY && ndcY >= sellY-sellH) {
-            Stock* s = &stocks[selectedStock];
-            if (s->qty > 0) {
-                realizedPnL += (s->price - s->avgCost);
-                cashBalance += s->price;
-                s->qty -= 1;
-                s->totalCost -= s->avgCost;
-                if (s->qty <= 0) {
-                    s->qty = 0;
-                    s->totalCost = 0.0f;
-                    s->avgCost = 0.0f;
-                } else {
-                    s->avgCost = s->totalCost / (float)s->qty;
-                }
-            }
-            return;
+        int k = posView ? posRowAt(ndcX, ndcY) : -1;
+        uint32_t m = (k >= 0) ? sortedViewOrder(posView)[k] : 0;
+        if (k >= 0 && rowStock(m) >= 0) selectedStock = rowStock(m);
+        else ticketFocus = NULL;
+        break;
+    }
+    case UI_BUY:
+    case UI_SELL: {
+        int qty = ticketQty();
+        if (qty <= 0) break;
+        OrderLeg leg = { selectedStock, (w->tag == UI_BUY) ? qty : -qty };
+        Money limit;
+        if (mods & GLFW_MOD_SHIFT) {
+            if (basketLen < MAX_BASKET_LEGS) basket[basketLen++] = leg;
+        } else if (limitInput.len > 0) {
+            if (moneyParse(limitInput.text, &limit)) placeLimitOrder(leg.stock, leg.qty, limit);
+        } else {
+            applyOrder(&leg, 1);
         }
+        break;
+    }
+    case UI_TICKET_FIELD:
+        ticketFocus = (w->arg == 0) ? &qtyInput : &limitInput;
+        break;
+    case UI_TRIGGER:
+        armTrigger((TriggerKind)w->arg);
+        break;
+    case UI_ORDERS: {
+        // Rows start 20 px below the title line, 16 px apart (see UI_ORDERS in drawWidget)
+        int row = (int)floorf(((float)yp - (ndcToPixelY(ordersY) + 30.0f)) / 16.0f);
+        if (row >= 0 && row < openOrderCount) cancelOpenOrder(row);
+        break;
+    }
+    case UI_BASKET_SEND:
+        if (basketLen == 0) ticketFocus = NULL;
+        else if (applyOrder(basket, basketLen)) basketLen = 0;   // rejected baskets stay for editing
+        break;
+    case UI_BASKET_CLEAR:
+        basketLen = 0;
+        break;
+    case UI_RELIEF:
+        setReliefMethod((ReliefMethod)((portfolio.relief + 1) % RELIEF_METHOD_COUNT));
+        break;
+    case UI_STOCKS:
+    case UI_BASKET:
+    case UI_LOTS:
+        ticketFocus = NULL;
+        break;
+
+    case UI_BANNER:
+        break;
     }
 }
 
@@ -804,10 +1941,22 @@ static void key_callback(GLFWwindow *window, int key, int sc, int action, int mo
             addInputActive = false;
             return;
         }
+        if (ticketFocus) {
+            ticketFocus = NULL;
+            return;
+        }
         glfwSetWindowShouldClose(window, GLFW_TRUE);
         return;
     }
 
+    if (key == GLFW_KEY_F2) {
+        int n = (int)(sizeof(paneLayouts) / sizeof(paneLayouts[0]));
+        paneLayout = (paneLayout + 1) % n;
+        setPaneLayout(paneLayouts[paneLayout]);
+        hoverActive = false; hoverPane = hoverCandle = -1;
+        return;
+    }
+
     if (key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER) {
         if (addModalOpen) {
             submitAddBalance();
@@ -817,40 +1966,79 @@ static void key_callback(GLFWwindow *window, int key, int sc, int action, int mo
 
     if (key == GLFW_KEY_BACKSPACE) {
         if (addModalOpen && addInputActive) {
-            if (addInputLen > 0) { addInputText[--addInputLen] = '\0'; }
+            numericFieldBackspace(&addInput);
+            return;
+        }
+        if (currentTab == TAB_STOCKS && ticketFocus) {
+            numericFieldBackspace(ticketFocus);
             return;
         }
         if (searchBarActive) {
-            if (searchLen > 0) { searchText[--searchLen] = '\0'; }
+            if (searchLen > 0) { searchText[--searchLen] = '\0'; searchTextEdited(); }
             return;
         }
     }
 }
 
+static void cursor_pos_callback(GLFWwindow *window, double xp, double yp) {
+    hoverNdcX = (float)((2.0 * xp) / windowWidth - 1.0);
+    hoverNdcY = (float)(1.0 - (2.0 * yp) / windowHeight);
+    hoverPane   = (uiTagAt(hoverNdcX, hoverNdcY) == UI_CHARTS) ? paneAtNDC(hoverNdcX, hoverNdcY) : -1;
+    hoverActive = hoverPane >= 0;
+    hoverCandle = hoverActive ? candleIndexAtX(&panes[hoverPane], hoverNdcX) : -1;
+}
+
+// Wheel over a pane scrolls it back through the compressed archive (up = older).
+static void scroll_callback(GLFWwindow *window, double xoff, double yoff) {
+    double xp, yp; glfwGetCursorPos(window, &xp, &yp);
+    float ndcX = (float)((2.0 * xp) / windowWidth - 1.0), ndcY = (float)(1.0 - (2.0 * yp) / windowHeight);
+    int tag = uiTagAt(ndcX, ndcY);
+
+    // Over the search results: scroll the list, a row and a half per notch
+    if (tag == UI_SEARCH_LIST) {
+        int count; searchResults(&count);
+        searchScroll -= (float)yoff * 1.5f;
+        clampSearchScroll(count);
+        return;
+    }
+
+    // Over the positions table: scroll it the same way
+    if (tag == UI_POSITIONS) {
+        posScroll -= (float)yoff * 1.5f;
+        clampPosScroll();
+        return;
+    }
+
+    int i = (tag == UI_CHARTS) ? paneAtNDC(ndcX, ndcY) : -1;
+    if (i < 0) return;
+    Pane* p = &panes[i];
+    const CandleStore* st = paneArchive(p);
+    int sb = p->scrollBack + (int)(yoff * 30.0);
+    if (sb > st->total - 1) sb = (int)st->total - 1;
+    if (sb < 0) sb = 0;
+    p->scrollBack = sb;
+}
+
 static void char_callback(GLFWwindow *window, unsigned int codepoint) {
     // Numeric input for Add Balance modal
     if (addModalOpen && addInputActive) {
-        if (codepoint == 8) { if (addInputLen > 0) { addInputText[--addInputLen] = '\0'; } return; }
-        if ((codepoint >= '0' && codepoint <= '9') || codepoint == '.') {
-            // allow only a single '.'
-            if (codepoint == '.') {
-                for (int i = 0; i < addInputLen; ++i) if (addInputText[i] == '.') return;
-            }
-            if (addInputLen < (int)sizeof(addInputText)-1) {
-                addInputText[addInputLen++] = (char)codepoint;
-                addInputText[addInputLen] = '\0';
-            }
-        }
+        numericFieldChar(&addInput, codepoint);
+        return;
+    }
+    // Order ticket: whole-share quantity or limit price
+    if (currentTab == TAB_STOCKS && ticketFocus) {
+        numericFieldChar(ticketFocus, codepoint);
         return;
     }
 
     // Search bar typing
     if (!searchBarActive) return;
-    if (codepoint == 8) { if (searchLen > 0) { searchText[--searchLen] = '\0'; } return; }
+    if (codepoint == 8) { if (searchLen > 0) { searchText[--searchLen] = '\0'; searchTextEdited(); } return; }
     if (codepoint >= 32 && codepoint < 127) {
         if (searchLen < (int)sizeof(searchText)-1) {
             searchText[searchLen++] = (char)codepoint;
             searchText[searchLen] = '\0';
+            searchTextEdited();
         }
     }
 }
@@ -864,15 +2052,17 @@ static void initTextRendering(void) {
     glEnableVertexAttribArray(0);
     glBindVertexArray(0);
 }
-static void renderText(float x, float y, const char *text) {
-    char buffer[100000];
+// Tessellate text into a malloc'd xy triangle list; returns the float count (0 on failure).
+static int tessellateText(float x, float y, const char *text, float** outTri) {
+    static char buffer[100000];
+    *outTri = NULL;
     int num_quads = stb_easy_font_print((int)x, (int)y, (char*)text, NULL, buffer, sizeof(buffer));
-    if (num_quads <= 0) return;
+    if (num_quads <= 0) return 0;
 
     float* src = (float*)buffer;
     int triFloats = num_quads * 6 * 2;
     float* tri = (float*)malloc(triFloats * sizeof(float));
-    if (!tri) return;
+    if (!tri) return 0;
 
     int t = 0;
     for (int i = 0; i < num_quads; ++i) {
@@ -890,6 +2080,13 @@ static void renderText(float x, float y, const char *text) {
         tri[t++] = x2; tri[t++] = y2;
         tri[t++] = x3; tri[t++] = y3;
     }
+    *outTri = tri;
+    return triFloats;
+}
+static void renderText(float x, float y, const char *text) {
+    float* tri = NULL;
+    int triFloats = tessellateText(x, y, text, &tri);
+    if (triFloats <= 0) return;
 
     glBindVertexArray(textVAO);
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
@@ -898,6 +2095,72 @@ static void renderText(float x, float y, const char *text) {
     glDrawArrays(GL_TRIANGLES, 0, triFloats / 2);
     free(tri);
 }
+static void textBatchAdd(TextBatch* b, float x, float y, float scale, const char *text) {
+    float* tri = NULL;
+    int triFloats = tessellateText(x, y, text, &tri);
+    if (triFloats <= 0) return;
+    if (b->floats + triFloats > b->cap) {
+        int cap = b->cap ? b->cap : 4096;
+        while (cap < b->floats + triFloats) cap *= 2;
+        float* nv = (float*)realloc(b->v, (size_t)cap * sizeof(float));
+        if (!nv) { free(tri); return; }
+        b->v = nv; b->cap = cap;
+    }
+    for (int i = 0; i < triFloats; i += 2) {
+        b->v[b->floats++] = x + (tri[i]     - x) * scale;
+        b->v[b->floats++] = y + (tri[i + 1] - y) * scale;
+    }
+    free(tri);
+}
+// One draw for everything added since the last call; leaves the batch empty.
+static void textBatchDraw(TextBatch* b) {
+    if (b->floats <= 0) return;
+    glUseProgram(textShader);
+    glUniform2f(glGetUniformLocation(textShader, "uResolution"), (float)windowWidth, (float)windowHeight);
+    glUniform1f(glGetUniformLocation(textShader, "uScale"), 1.0f);
+    glUniform2f(glGetUniformLocation(textShader, "uOrigin"), 0.0f, 0.0f);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    glBufferData(GL_ARRAY_BUFFER, b->floats * sizeof(float), b->v, GL_DYNAMIC_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, b->floats / 2);
+    b->floats = 0;
+}
+static void drawRectInstances(const float* rects, int count, float r, float g, float b) {
+    if (count <= 0) return;
+    glUseProgram(instRectShader);
+    glUniform3f(glGetUniformLocation(instRectShader, "uColor"), r, g, b);
+    glBindVertexArray(instRectVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instRectVBO);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)count * 4 * sizeof(float), rects, GL_DYNAMIC_DRAW);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+}
+static void retainedTextSet(RetainedText* rt, float x, float y, const char *text) {
+    if (rt->vertCount > 0 && rt->x == x && rt->y == y && strcmp(rt->text, text) == 0) return;
+    if (!rt->vao) {
+        glGenVertexArrays(1, &rt->vao);
+        glGenBuffers(1, &rt->vbo);
+        glBindVertexArray(rt->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, rt->vbo);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+    snprintf(rt->text, sizeof(rt->text), "%s", text);
+    rt->x = x; rt->y = y;
+
+    float* tri = NULL;
+    int triFloats = tessellateText(x, y, text, &tri);
+    glBindBuffer(GL_ARRAY_BUFFER, rt->vbo);
+    glBufferData(GL_ARRAY_BUFFER, triFloats * sizeof(float), tri, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    rt->vertCount = triFloats / 2;
+    free(tri);
+}
+static void retainedTextDraw(const RetainedText* rt) {
+    if (rt->vertCount <= 0) return;
+    glBindVertexArray(rt->vao);
+    glDrawArrays(GL_TRIANGLES, 0, rt->vertCount);
+}
 static float measureTextWidthRaw(const char *text) {
     if (!text || !*text) return 0.0f;
     char buf[100000];
@@ -917,108 +2180,147 @@ static float measureTextWidthRaw(const char *text) {
 static float ndcToPixelX(float ndcX) { return (ndcX + 1.0f) * 0.5f * windowWidth; }
 static float ndcToPixelY(float ndcY) { return (1.0f - ndcY) * 0.5f * windowHeight; }
 
-static void initCandleSeries(float initialValue) {
-    for (int i=0;i<MAX_CANDLES;++i) {
-        candles[i].open = candles[i].high = candles[i].low = candles[i].close = initialValue;
-        candles[i].valid = false;
-    }
-    currentCandle = 0;
-    candleCount   = 1;
-    candles[0].open  = candles[0].high = candles[0].low = candles[0].close = initialValue;
-    candles[0].valid = true;
-}
-static void updateCandleSeries(double now, float v) {
-    if (currentCandle < 0) return;
-
-    Candle* c = &candles[currentCandle];
-    if (!c->valid) { c->open = c->high = c->low = c->close = v; c->valid = true; }
-    c->close = v;
-    if (v > c->high) c->high = v;
-    if (v < c->low ) c->low  = v;
-
-    if (now - lastCandleTime >= CANDLE_DT) {
-        lastCandleTime = now;
-        int next = (currentCandle + 1) % MAX_CANDLES;
-        Candle* n = &candles[next];
-        n->open = c->close;
-        n->high = n->low = n->close = n->open;
-        n->valid = true;
-        currentCandle = next;
-        if (candleCount < MAX_CANDLES) candleCount++;
-    }
-}
-
 static float mapYValue(float val, float vmin, float vmax, float chartBottom, float height) {
     float t = (val - vmin) / (vmax - vmin);
     if (t < 0.0f) t = 0.0f;
     if (t > 1.0f) t = 1.0f;
     return chartBottom + t * height;
 }
-static void rebuildCandleMeshes(void) {
-    if (candleCount <= 0) { upVertCount=dnVertCount=wickVertCount=0; return; }
-    if (windowWidth <= 0 || windowHeight <= 0) { upVertCount=dnVertCount=wickVertCount=0; return; }
 
-    int count = candleCount;
-    int first = (candleCount == MAX_CANDLES) ? (currentCandle + 1) % MAX_CANDLES : 0;
+static int paneStock(const Pane* p) {
+    return (p->stock < 0) ? selectedStock : p->stock;
+}
+static const CandleSeries* paneLiveSeries(const Pane* p) {
+    return (p->kind == PANE_PORTFOLIO) ? &portfolioSeries : &symbolSeries[paneStock(p)];
+}
+static CandleStore* paneArchive(const Pane* p) {
+    return (p->kind == PANE_PORTFOLIO) ? &portfolioArchive : &symbolArchive[paneStock(p)];
+}
+static const CandleSeries* paneSeries(const Pane* p) {
+    return (p->scrollBack > 0) ? &paneViews[p - panes] : paneLiveSeries(p);
+}
 
-    float vmin =  1e30f, vmax = -1e30f;
-    for (int i = 0; i < count; ++i) {
-        int idx = (first + i) % MAX_CANDLES;
-        if (!candles[idx].valid) continue;
-        Candle c = candles[idx];
-        if (c.low  < vmin) vmin = c.low;
-        if (c.high > vmax) vmax = c.high;
+// Decode the archive window ending 'scrollBack' candles behind the newest closed
+// candle. Only the blocks covering that window are touched, and only when the
+// archive grew or the scroll position changed.
+static void refreshPaneView(Pane* p) {
+    if (p->scrollBack <= 0) return;
+    CandleStore* st = paneArchive(p);
+    if (p->viewStore == st && p->viewTotal == st->total && p->viewScroll == p->scrollBack) return;
+    p->viewStore  = st;
+    p->viewTotal  = st->total;
+    p->viewScroll = p->scrollBack;
+
+    static Candle window[MAX_CANDLES];
+    long end = st->total - p->scrollBack;
+    int n = candleStoreRead(st, end - MAX_CANDLES, MAX_CANDLES, window);   // clips a short archive
+    candleSeriesLoad(&paneViews[p - panes], window, n, CANDLE_DT);
+}
+
+// Tile the chart area with n panes: one column up to 4, then 2 or 4 columns.
+// Pane 0 is the portfolio return, then the selected symbol's price, volume and
+// indicator; larger layouts fill with the same trio for each stock.
+static void setPaneLayout(int n) {
+    if (n < 1) n = 1;
+    if (n > MAX_PANES) n = MAX_PANES;
+    int cols = (n <= 4) ? 1 : (n <= 8) ? 2 : 4;
+    int rows = (n + cols - 1) / cols;
+    const float gap = 0.02f;
+    float cw = (chartWidthNDC  - gap * (cols - 1)) / (float)cols;
+    float ch = (chartHeightNDC - gap * (rows - 1)) / (float)rows;
+
+    for (int i = 0; i < n; ++i) {
+        Pane* p = &panes[i];
+        static const PaneKind perStock[3] = { PANE_SYMBOL, PANE_VOLUME, PANE_INDICATOR };
+        if (i == 0) { p->kind = PANE_PORTFOLIO; p->stock = -1; }
+        else if (i < 4) { p->kind = perStock[i - 1]; p->stock = -1; }
+        else {
+            p->kind  = perStock[(i - 4) % 3];
+            p->stock = ((i - 4) / 3) % 3;
+        }
+        int r = i / cols, c = i % cols;
+        p->x = chartLeftNDC + c * (cw + gap);
+        p->y = chartTopNDC  - r * (ch + gap);
+        p->w = cw;
+        p->h = ch;
+        p->upCount = p->dnCount = p->wickCount = p->lineCount = p->volCount = 0;
+        p->scrollBack = 0;
+        p->viewStore = NULL;
     }
-    if (!(vmax > vmin)) { upVertCount=dnVertCount=wickVertCount=0; return; }
-    float pad = 0.05f * (vmax - vmin);
-    vmin -= pad; vmax += pad;
+    paneCount = n;
+}
 
-    const float left   = chartLeftNDC;
-    const float top    = chartTopNDC;
-    const float width  = chartWidthNDC;
-    const float height = chartHeightNDC;
-    const float step   = width / (float)count;
+// Pane rect in framebuffer pixels (origin bottom-left) for glViewport/glScissor.
+static void paneViewport(const Pane* p, int* vx, int* vy, int* vw, int* vh) {
+    *vx = (int)((p->x + 1.0f) * 0.5f * windowWidth);
+    *vy = (int)(((p->y - p->h) + 1.0f) * 0.5f * windowHeight);
+    *vw = (int)(p->w * 0.5f * windowWidth);
+    *vh = (int)(p->h * 0.5f * windowHeight);
+    if (*vw < 1) *vw = 1;
+    if (*vh < 1) *vh = 1;
+}
 
-    const float minBodyPx  = 2.0f;
-    const float minBodyNDC = (minBodyPx * 2.0f) / (float)windowHeight;
+// CPU staging for the shared chart buffers (xyz per vertex)
+#define PANE_MAX_BODY_VERTS (MAX_CANDLES * 6)
+#define PANE_MAX_LINE_VERTS (MAX_CANDLES * 4 + 4)
+static float upStage  [MAX_PANES * PANE_MAX_BODY_VERTS * 3];
+static float dnStage  [MAX_PANES * PANE_MAX_BODY_VERTS * 3];
+static float lineStage[MAX_PANES * PANE_MAX_LINE_VERTS * 3];
+static float volStage [MAX_PANES * MAX_CANDLES * 3];
+static int upV = 0, dnV = 0, lineV = 0, volN = 0;
+
+static void pushLineVert(float x, float y) {
+    lineStage[lineV*3+0] = x; lineStage[lineV*3+1] = y; lineStage[lineV*3+2] = -0.20f; lineV++;
+}
 
-    const float fill = 0.55f;
-    float bodyW = step * fill;
-    if (bodyW < minBodyNDC)  bodyW = minBodyNDC;
+// Candle x-layout shared by candle bodies and volume bars: slot i is centred at
+// -1 + (i + 0.5) * step with step = 2 / count, bodies 55% of a slot (>= 2 px).
+static float candleBodyWidth(const Pane* p, int count) {
+    int vx, vy, vw, vh; paneViewport(p, &vx, &vy, &vw, &vh);
+    const float step = 2.0f / (float)count;
+    const float minBodyPx = 2.0f;
+    float bodyW = step * 0.55f;
+    if (bodyW < (minBodyPx * 2.0f) / (float)vw) bodyW = (minBodyPx * 2.0f) / (float)vw;
     if (bodyW > step * 0.95f) bodyW = step * 0.95f;
+    return bodyW;
+}
 
-    int maxUpVerts   = count * 6;
-    int maxDnVerts   = count * 6;
-    int maxWickVerts = count * 2;
+// Candles of 's' in pane-local coordinates: x,y in [-1,1].
+static void appendCandlePane(Pane* p, const CandleSeries* s) {
+    p->upFirst = upV; p->dnFirst = dnV; p->wickFirst = lineV;
+    p->upCount = p->dnCount = p->wickCount = 0;
+    if (s->count <= 0 || s->current < 0) return;
+
+    int count = s->count;
+    Candle all;
+    if (!candleSeriesRange(s, 0, count - 1, &all)) return;
+    float vmin = all.low, vmax = all.high;
+    if (!(vmax > vmin)) return;
+    float pad = 0.05f * (vmax - vmin);
+    vmin -= pad; vmax += pad;
 
-    float* up  = (float*)malloc(sizeof(float)*3*maxUpVerts);
-    float* dn  = (float*)malloc(sizeof(float)*3*maxDnVerts);
-    float* wck = (float*)malloc(sizeof(float)*3*maxWickVerts);
-    if (!up || !dn || !wck) { free(up); free(dn); free(wck); upVertCount=dnVertCount=wickVertCount=0; return; }
-    int upV=0, dnV=0, wkV=0;
+    int vx, vy, vw, vh; paneViewport(p, &vx, &vy, &vw, &vh);
+    const float step = 2.0f / (float)count;
+    const float minBodyNDC = (2.0f * 2.0f) / (float)vh;
+    const float bodyW = candleBodyWidth(p, count);
 
-    const float chartBottom = top - height;
     const float zBody = -0.25f;
-    const float zWick = -0.20f;
 
     for (int i = 0; i < count; ++i) {
-        int idx = (first + i) % MAX_CANDLES;
-        if (!candles[idx].valid) continue;
-        Candle c = candles[idx];
+        const Candle* c = &s->candles[candleSeriesIndex(s, i)];
+        if (!c->valid) continue;
 
-        float yO = mapYValue(c.open,  vmin, vmax, chartBottom, height);
-        float yC = mapYValue(c.close, vmin, vmax, chartBottom, height);
-        float yH = mapYValue(c.high,  vmin, vmax, chartBottom, height);
-        float yL = mapYValue(c.low,   vmin, vmax, chartBottom, height);
+        float yO = mapYValue(c->open,  vmin, vmax, -1.0f, 2.0f);
+        float yC = mapYValue(c->close, vmin, vmax, -1.0f, 2.0f);
+        float yH = mapYValue(c->high,  vmin, vmax, -1.0f, 2.0f);
+        float yL = mapYValue(c->low,   vmin, vmax, -1.0f, 2.0f);
 
-        float xCenter = left + (float)i * step + step * 0.5f;
+        float xCenter = -1.0f + (float)i * step + step * 0.5f;
         float x0 = xCenter - bodyW * 0.5f;
         float x1 = xCenter + bodyW * 0.5f;
 
-        if (wkV + 2 <= maxWickVerts) {
-            wck[wkV*3+0] = xCenter; wck[wkV*3+1] = yL;  wck[wkV*3+2] = zWick; wkV++;
-            wck[wkV*3+0] = xCenter; wck[wkV*3+1] = yH;  wck[wkV*3+2] = zWick; wkV++;
-        }
+        pushLineVert(xCenter, yL);
+        pushLineVert(xCenter, yH);
 
         float yB = fminf(yO, yC);
         float yT = fmaxf(yO, yC);
@@ -1033,38 +2335,317 @@ static void rebuildCandleMeshes(void) {
             x0,yB,zBody,  x1,yT,zBody,  x0,yT,zBody
         };
 
-        if (c.close >= c.open) {
-            if (upV + 6 <= maxUpVerts) { memcpy(up + upV*3, tri, sizeof(tri)); upV += 6; }
-        } else {
-            if (dnV + 6 <= maxDnVerts) { memcpy(dn + dnV*3, tri, sizeof(tri)); dnV += 6; }
+        if (c->close >= c->open) { memcpy(upStage + upV*3, tri, sizeof(tri)); upV += 6; }
+        else                     { memcpy(dnStage + dnV*3, tri, sizeof(tri)); dnV += 6; }
+    }
+    p->upCount   = upV - p->upFirst;
+    p->dnCount   = dnV - p->dnFirst;
+    p->wickCount = lineV - p->wickFirst;
+}
+
+// RSI(14) of the series closes on a fixed 0..100 scale, with 30/70 guides.
+static void appendIndicatorPane(Pane* p, const CandleSeries* s) {
+    p->upFirst = upV; p->dnFirst = dnV; p->wickFirst = lineV;
+    p->upCount = p->dnCount = p->wickCount = 0;
+    p->lineFirst = lineV; p->lineCount = 0;
+    if (s->count <= 0 || s->current < 0) return;
+
+    const int period = 14;
+    int count = s->count;
+    const float step = 2.0f / (float)count;
+
+    pushLineVert(-1.0f, -0.4f); pushLineVert(1.0f, -0.4f);   // 30
+    pushLineVert(-1.0f,  0.4f); pushLineVert(1.0f,  0.4f);   // 70
+
+    float gain = 0.0f, loss = 0.0f;
+    float prevX = 0.0f, prevY = 0.0f; bool havePrev = false;
+    for (int i = 1; i < count; ++i) {
+        const Candle* a = &s->candles[candleSeriesIndex(s, i - 1)];
+        const Candle* b = &s->candles[candleSeriesIndex(s, i)];
+        float d = b->close - a->close;
+        if (d > 0) gain += d; else loss -= d;
+        if (i > period) {
+            const Candle* oa = &s->candles[candleSeriesIndex(s, i - period - 1)];
+            const Candle* ob = &s->candles[candleSeriesIndex(s, i - period)];
+            float od = ob->close - oa->close;
+            if (od > 0) gain -= od; else loss += od;
         }
+        if (i < period) continue;
+
+        float rsi = (gain + loss > 1e-12f) ? 100.0f * gain / (gain + loss) : 50.0f;
+        float x = -1.0f + (float)i * step + step * 0.5f;
+        float y = rsi / 50.0f - 1.0f;
+        if (havePrev) { pushLineVert(prevX, prevY); pushLineVert(x, y); }
+        prevX = x; prevY = y; havePrev = true;
     }
+    p->lineCount = lineV - p->lineFirst;
+}
 
-    glBindVertexArray(candleUpVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, candleUpVBO);
-    glBufferData(GL_ARRAY_BUFFER, upV * 3 * sizeof(float), up, GL_DYNAMIC_DRAW);
-    upVertCount = upV;
+// Volume bars as instances {slot, volume, up}; the shader applies the candle x-layout.
+static void appendVolumePane(Pane* p, const CandleSeries* s) {
+    p->upFirst = upV; p->dnFirst = dnV; p->wickFirst = lineV;
+    p->upCount = p->dnCount = p->wickCount = 0;
+    p->volFirst = volN; p->volCount = 0; p->volMax = 0.0f;
+    if (s->count <= 0 || s->current < 0) return;
+
+    for (int i = 0; i < s->count; ++i) {
+        const Candle* c = &s->candles[candleSeriesIndex(s, i)];
+        if (!c->valid) continue;
+        volStage[volN*3+0] = (float)i;
+        volStage[volN*3+1] = c->volume;
+        volStage[volN*3+2] = (c->close >= c->open) ? 1.0f : 0.0f;
+        volN++;
+        if (c->volume > p->volMax) p->volMax = c->volume;
+    }
+    p->volCount = volN - p->volFirst;
+    p->step  = 2.0f / (float)s->count;
+    p->bodyW = candleBodyWidth(p, s->count);
+    if (p->volMax <= 0.0f) p->volMax = 1.0f;
+}
+
+// Rebuild every pane into the shared buffers: four uploads per frame total.
+static void rebuildChartMeshes(void) {
+    upV = dnV = lineV = volN = 0;
+    bool charting = portfolioHasPosition(&portfolio);
+    for (int i = 0; i < paneCount; ++i) {
+        Pane* p = &panes[i];
+        p->lineCount = p->volCount = 0;
+        refreshPaneView(p);
+        if (p->kind == PANE_INDICATOR)               appendIndicatorPane(p, paneSeries(p));
+        else if (p->kind == PANE_VOLUME)             appendVolumePane(p, paneSeries(p));
+        else if (p->kind == PANE_SYMBOL || charting) appendCandlePane(p, paneSeries(p));
+        else { p->upFirst = upV; p->dnFirst = dnV; p->wickFirst = lineV; p->upCount = p->dnCount = p->wickCount = 0; }
+
+        char label[64];
+        if (p->kind == PANE_PORTFOLIO)   snprintf(label, sizeof(label), "Portfolio return");
+        else if (p->kind == PANE_SYMBOL) snprintf(label, sizeof(label), "%s", stocks[paneStock(p)].symbol);
+        else if (p->kind == PANE_VOLUME) snprintf(label, sizeof(label), "%s Volume", stocks[paneStock(p)].symbol);
+        else                             snprintf(label, sizeof(label), "%s RSI(14)", stocks[paneStock(p)].symbol);
+        if (p->scrollBack > 0) {
+            size_t len = strlen(label);
+            snprintf(label + len, sizeof(label) - len, "  -%ds", (int)(p->scrollBack * CANDLE_DT));
+        }
+        float lx = ndcToPixelX(p->x + p->w) - stb_easy_font_width(label) * 1.1f - 8.0f;
+        float ly = ndcToPixelY(p->y) + 6.0f;
+        retainedTextSet(&p->label, lx, ly, label);
+    }
 
-    glBindVertexArray(candleDnVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, candleUpVBO);
+    glBufferData(GL_ARRAY_BUFFER, upV * 3 * sizeof(float), upStage, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, candleDnVBO);
-    glBufferData(GL_ARRAY_BUFFER, dnV * 3 * sizeof(float), dn, GL_DYNAMIC_DRAW);
-    dnVertCount = dnV;
+    glBufferData(GL_ARRAY_BUFFER, dnV * 3 * sizeof(float), dnStage, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, chartLineVBO);
+    glBufferData(GL_ARRAY_BUFFER, lineV * 3 * sizeof(float), lineStage, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, volInstVBO);
+    glBufferData(GL_ARRAY_BUFFER, volN * 3 * sizeof(float), volStage, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    glBindVertexArray(wickVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, wickVBO);
-    glBufferData(GL_ARRAY_BUFFER, wkV * 3 * sizeof(float), wck, GL_DYNAMIC_DRAW);
-    wickVertCount = wkV;
+// One pass over all panes with the shared pipelines; only viewport/scissor change per pane.
+static void drawPanes(void) {
+    GLint colorLoc = glGetUniformLocation(rectShader, "uColor");
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = 0; i < paneCount; ++i) {
+        const Pane* p = &panes[i];
+        int vx, vy, vw, vh; paneViewport(p, &vx, &vy, &vw, &vh);
+        glViewport(vx, vy, vw, vh);
+        glScissor(vx, vy, vw, vh);
+
+        glUniform3f(colorLoc, 0.88f, 0.88f, 0.88f);
+        glBindVertexArray(paneBgVAO);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
-    free(up); free(dn); free(wck);
+        if (p->wickCount > 0 || p->lineCount > 0) {
+            glBindVertexArray(chartLineVAO);
+            glUniform3f(colorLoc, 0.10f, 0.10f, 0.10f);
+            if (p->wickCount > 0) glDrawArrays(GL_LINES, p->wickFirst, p->wickCount);
+            glUniform3f(colorLoc, 0.20f, 0.45f, 0.85f);
+            if (p->lineCount > 0) glDrawArrays(GL_LINES, p->lineFirst, p->lineCount);
+        }
+        if (p->upCount > 0) {
+            glUniform3f(colorLoc, 0.20f, 0.70f, 0.30f);
+            glBindVertexArray(candleUpVAO);
+            glDrawArrays(GL_TRIANGLES, p->upFirst, p->upCount);
+        }
+        if (p->dnCount > 0) {
+            glUniform3f(colorLoc, 0.85f, 0.25f, 0.25f);
+            glBindVertexArray(candleDnVAO);
+            glDrawArrays(GL_TRIANGLES, p->dnFirst, p->dnCount);
+        }
+
+        if (p->volCount > 0) {
+            // One instanced draw per volume pane; the instance range is selected by offset
+            glUseProgram(volShader);
+            glUniform1f(glGetUniformLocation(volShader, "uStep"), p->step);
+            glUniform1f(glGetUniformLocation(volShader, "uBodyW"), p->bodyW);
+            glUniform1f(glGetUniformLocation(volShader, "uMaxVolume"), p->volMax);
+            glBindVertexArray(volVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, volInstVBO);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float),
+                                  (void*)((size_t)p->volFirst * 3 * sizeof(float)));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, p->volCount);
+            glUseProgram(rectShader);
+        }
+
+        if (i == hoverPane && hoverCandle >= 0) {
+            glUniform3f(colorLoc, 0.45f, 0.45f, 0.45f);
+            glBindVertexArray(crosshairVAO);
+            glDrawArrays(GL_LINES, 0, 4);
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, windowWidth, windowHeight);
+}
+
+static int paneAtNDC(float ndcX, float ndcY) {
+    for (int i = 0; i < paneCount; ++i) {
+        const Pane* p = &panes[i];
+        if (pointInRectNDC(ndcX, ndcY, p->x, p->y, p->w, p->h)) return i;
+    }
+    return -1;
+}
+
+// O(1): pane x -> slot (step = 2 / count, as in appendCandlePane) -> ring index.
+static int candleIndexAtX(const Pane* p, float ndcX) {
+    const CandleSeries* s = paneSeries(p);
+    if (s->count <= 0 || s->current < 0) return -1;
+    float localX = (ndcX - p->x) / p->w * 2.0f - 1.0f;
+    const float step = 2.0f / (float)s->count;
+    int slot = (int)((localX + 1.0f) / step);
+    if (slot < 0) slot = 0;
+    if (slot >= s->count) slot = s->count - 1;
+    int idx = candleSeriesIndex(s, slot);
+    return s->candles[idx].valid ? idx : -1;
+}
+
+static bool sameCandle(const Candle* a, const Candle* b) {
+    return a->time == b->time && a->open == b->open && a->high == b->high &&
+           a->low == b->low && a->close == b->close && a->volume == b->volume;
+}
+
+// Re-resolve the hovered candle (cheap) and rebuild crosshair/readout only when they change.
+static void updateHover(void) {
+    if (!hoverActive || currentTab != TAB_HOME || hoverPane < 0 || hoverPane >= paneCount) { hoverCandle = -1; return; }
+    const Pane* p = &panes[hoverPane];
+    if (p->upCount + p->dnCount + p->lineCount + p->volCount == 0) { hoverCandle = -1; return; }
+    hoverCandle = candleIndexAtX(p, hoverNdcX);
+    if (hoverCandle < 0) return;
+
+    const CandleSeries* s = paneSeries(p);
+    int slot = (hoverCandle - candleSeriesFirst(s) + MAX_CANDLES) % MAX_CANDLES;
+    const float step = 2.0f / (float)s->count;
+    float xCenter = -1.0f + (float)slot * step + step * 0.5f;
+    float localY  = (hoverNdcY - (p->y - p->h)) / p->h * 2.0f - 1.0f;
+    const float z = -0.15f;
+    float lines[12] = {
+        xCenter, -1.0f, z,   xCenter, 1.0f, z,
+        -1.0f, localY, z,    1.0f, localY, z
+    };
+    if (memcmp(lines, crosshairVerts, sizeof(lines)) != 0) {
+        memcpy(crosshairVerts, lines, sizeof(lines));
+        updateLineVBO(crosshairVBO, crosshairVerts, 12);
+    }
+
+    const Candle* c = &s->candles[hoverCandle];
+    Candle since;
+    if (!candleSeriesRange(s, slot, s->count - 1, &since)) since = *c;
+    float px = ndcToPixelX(p->x) + 10.0f;
+    float py = ndcToPixelY(p->y - p->h) - 26.0f;
+    if (hoverPane == readoutPane && hoverCandle == readoutCandle &&
+        sameCandle(c, &readoutValues) && sameCandle(&since, &readoutSince) &&
+        hoverReadout.x == px && hoverReadout.y == py) return;
+    readoutPane   = hoverPane;
+    readoutCandle = hoverCandle;
+    readoutValues = *c;
+    readoutSince  = since;
+
+    char line[256];
+    int secs = (int)(c->time - sessionStart);
+    if (secs < 0) secs = 0;
+    if (fabsf(c->open) > 1e-6f) {
+        snprintf(line, sizeof(line), "%02d:%02d  O %.2f  H %.2f  L %.2f  C %.2f  %+.2f%%  V %.0f",
+                 secs / 60, secs % 60, c->open, c->high, c->low, c->close,
+                 (c->close - c->open) / fabsf(c->open) * 100.0f, c->volume);
+    } else {
+        snprintf(line, sizeof(line), "%02d:%02d  O %.2f  H %.2f  L %.2f  C %.2f  --%%  V %.0f",
+                 secs / 60, secs % 60, c->open, c->high, c->low, c->close, c->volume);
+    }
+    // Range rollup from the hovered candle to now (segment tree, O(log n))
+    size_t len = strlen(line);
+    snprintf(line + len, sizeof(line) - len, "\nSince: %+.2f  H %.2f  L %.2f  V %.0f",
+             since.close - since.open, since.high, since.low, since.volume);
+    retainedTextSet(&hoverReadout, px, py, line);
+}
+
+// Covariance of per-candle log returns over the candles all series share,
+// scaled to the risk horizon, and a fresh job for the current holdings.
+static void submitRiskJob(void) {
+    RiskJob job = { .steps = RISK_STEPS, .paths = RISK_PATHS, .confidence = RISK_CONFIDENCE };
+    job.seed = (uint64_t)rand() << 32 ^ (uint64_t)rand();
+    int held[3], n = MAX_CANDLES;
+    for (int i = 0; i < 3; ++i) {
+        if (stocks[i].qty <= 0) continue;
+        held[job.assets] = i;
+        job.value[job.assets++] = moneyToDouble(moneyMulInt(stocks[i].price, stocks[i].qty));
+        if (symbolSeries[i].count < n) n = symbolSeries[i].count;
+    }
+    if (job.assets == 0 || n < 3) { riskJob = 0; return; }
+
+    // newest n closes of each held stock -> n-1 log returns
+    static double ret[3][MAX_CANDLES];
+    double mean[3] = {0};
+    for (int a = 0; a < job.assets; ++a) {
+        const CandleSeries* cs = &symbolSeries[held[a]];
+        int first = cs->count - n;
+        double prev = cs->candles[candleSeriesIndex(cs, first)].close;
+        for (int k = 1; k < n; ++k) {
+            double c = cs->candles[candleSeriesIndex(cs, first + k)].close;
+            ret[a][k - 1] = (prev > 0.0 && c > 0.0) ? log(c / prev) : 0.0;
+            mean[a] += ret[a][k - 1];
+            prev = c;
+        }
+        mean[a] /= (n - 1);
+    }
+    double scale = RISK_DAY_SECONDS / CANDLE_DT / (n - 2);
+    for (int a = 0; a < job.assets; ++a)
+        for (int b = 0; b <= a; ++b) {
+            double c = 0.0;
+            for (int k = 0; k < n - 1; ++k) c += (ret[a][k] - mean[a]) * (ret[b][k] - mean[b]);
+            job.cov[a][b] = job.cov[b][a] = c * scale;
+        }
+    uint64_t id = riskSubmit(riskEngine, &job);
+    if (id) riskJob = id;
 }
 
 static void updatePricesRandomWalk(void) {
     for (int i = 0; i < 3; ++i) {
-        float p = stocks[i].price;
-        float pct = ((rand() % 11) + 1) / 1000.0f;
+        Money p = stocks[i].price;
+        int permille = (rand() % 11) + 1;
         int dir = (rand() & 1) ? +1 : -1;
-        float delta = p * pct * dir;
-        p = fmaxf(1.0f, p + delta);
-        stocks[i].price = p;
+        Money delta = moneyDivInt(moneyMulInt(p, permille), 1000) * dir;
+        p += delta;
+        if (p < MONEY_ONE) p = MONEY_ONE;
+        portfolioSetPrice(&portfolio, i, p);
+        if (books[i]) orderBookMatchTick(books[i], p, 0);   // resting limits trade through the print
+        if (triggers[i]) triggerSetTick(triggers[i], p);    // only the nearest trigger per side is checked
+        // Traded size for this tick: round lots, larger on bigger moves
+        tickVolume[i] += (float)(100 * (1 + rand() % 20)) * (1.0f + permille * 0.1f);
+    }
+
+    // The rest of the universe takes the same walk from a cheaper generator
+    static uint32_t rng = 0x9E3779B9u;
+    for (int m = 0; m < quoteCount; ++m) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;       // xorshift32
+        int permille = (int)(rng % 11) + 1;
+        Money delta = moneyDivInt(moneyMulInt(quotes[m], permille), 1000);
+        quotes[m] += (rng & 0x800) ? delta : -delta;
+        if (quotes[m] < MONEY_ONE) quotes[m] = MONEY_ONE;
+    }
+    for (int i = 0; i < 3; ++i) if (stockRow[i] >= 0) quotes[stockRow[i]] = stocks[i].price;
+    for (int m = 0; m < quoteCount; ++m) {
+        int64_t change = quoteChange(m);
+        leaderboardUpdate(gainers, (uint32_t)m, change);
+        leaderboardUpdate(losers,  (uint32_t)m, -change);
+        posRefresh(m);
     }
 }
@@ -0,0 +1,53 @@
+#include "money.h"
+
+Money moneySum(const Money* v, int n) {
+    Money s = 0;
+    for (int i = 0; i < n; ++i) s += v[i];
+    return s;
+}
+
+int moneyFormat(char* buf, size_t cap, Money m) {
+    char tmp[32];
+    int  n = 0;
+    bool neg = m < 0;
+    uint64_t u = neg ? (uint64_t)0 - (uint64_t)m : (uint64_t)m;
+    uint64_t cents = (u + MONEY_SCALE / 200) / (MONEY_SCALE / 100);
+    if (cents == 0) neg = false;
+
+    // digits in reverse: two decimals, point, then the integer part
+    tmp[n++] = (char)('0' + cents % 10); cents /= 10;
+    tmp[n++] = (char)('0' + cents % 10); cents /= 10;
+    tmp[n++] = '.';
+    do { tmp[n++] = (char)('0' + cents % 10); cents /= 10; } while (cents);
+    if (neg) tmp[n++] = '-';
+
+    if (cap == 0) return 0;
+    int len = (n < (int)cap - 1) ? n : (int)cap - 1;
+    for (int i = 0; i < len; ++i) buf[i] = tmp[n - 1 - i];
+    buf[len] = '\0';
+    return len;
+}
+
+bool moneyParse(const char* s, Money* out) {
+    if (!s) return false;
+    bool neg = false;
+    if (*s == '-' || *s == '+') neg = (*s++ == '-');
+
+    uint64_t whole = 0, frac = 0;
+    int fracDigits = 0, digits = 0;
+    for (; *s >= '0' && *s <= '9'; ++s, ++digits) {
+        whole = whole * 10 + (uint64_t)(*s - '0');
+        if (whole >= (uint64_t)(INT64_MAX / MONEY_SCALE)) return false;
+    }
+    if (*s == '.') {
+        for (++s; *s >= '0' && *s <= '9'; ++s, ++digits) {
+            if (fracDigits < 6) { frac = frac * 10 + (uint64_t)(*s - '0'); fracDigits++; }
+        }
+    }
+    if (*s != '\0' || digits == 0) return false;
+    while (fracDigits++ < 6) frac *= 10;
+
+    Money m = (Money)(whole * MONEY_SCALE + frac);
+    *out = neg ? -m : m;
+    return true;
+}
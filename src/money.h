@@ -0,0 +1,48 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-point money: signed 64-bit count of micro-units (1e-6 of a currency unit).
+// All accounting is integer arithmetic, so results are exact and identical across
+// compilers and optimisation levels. Range is about +/- 9.2e12 units.
+typedef int64_t Money;
+
+#define MONEY_SCALE      1000000LL
+#define MONEY_UNITS(x)   ((Money)(x) * MONEY_SCALE)   // compile-time whole units
+#define MONEY_ONE        MONEY_UNITS(1)
+
+// Divide with rounding half away from zero (d > 0).
+static inline Money moneyDivInt(Money m, int64_t d) {
+    return (m >= 0) ? (m + d / 2) / d : -((-m + d / 2) / d);
+}
+static inline Money moneyMulInt(Money m, int64_t k) { return m * k; }
+
+// m * num / den (den > 0), rounded half away from zero, with a 128-bit intermediate.
+static inline Money moneyMulDiv(Money m, int64_t num, int64_t den) {
+#ifdef __SIZEOF_INT128__
+    __int128 p = (__int128)m * num;
+    return (Money)((p >= 0) ? (p + den / 2) / den : -((-p + den / 2) / den));
+#else
+    return moneyDivInt(m / den * num, 1) + moneyDivInt(m % den * num, den);
+#endif
+}
+
+// Display/plotting only; never feed the result back into accounting.
+static inline double moneyToDouble(Money m) { return (double)m / (double)MONEY_SCALE; }
+static inline float  moneyToFloat(Money m)  { return (float)moneyToDouble(m); }
+
+// Sum of n amounts. Plain int64 loop so the compiler can vectorise it.
+Money moneySum(const Money* v, int n);
+
+// Format as "-1234.56" (rounded to cents, half away from zero) without printf.
+// Returns the length written (buffer is always NUL terminated when cap > 0).
+int moneyFormat(char* buf, size_t cap, Money m);
+
+// Parse "123", "123.4", "-0.05" etc. (at most 6 fractional digits are kept).
+// Returns false on malformed input or overflow.
+bool moneyParse(const char* s, Money* out);
+
+#endif // MONEY_H
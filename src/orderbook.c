@@ -0,0 +1,327 @@
+#include "orderbook.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NIL               0u      // order slot 0 is never used
+#define LADDER_MAX_DEPTH  3       // 64^3 = 262144 levels
+
+typedef struct {
+    int32_t  qty;          // remaining
+    uint32_t owner;
+    uint32_t next, prev;   // FIFO within the level; 'next' doubles as the free list
+    uint32_t gen;
+    int32_t  level;        // -1 while the slot is free
+    uint8_t  side;
+} BookOrder;
+
+typedef struct {
+    uint32_t head, tail;
+    int64_t  qty;
+} BookLevel;
+
+// One side of the book: the level FIFOs plus the occupancy bitmaps.
+// bits[d+1] has bit w set iff word w of bits[d] is non-zero; the top holds one word.
+typedef struct {
+    BookLevel* levels;
+    uint64_t*  bits[LADDER_MAX_DEPTH];
+    int        words[LADDER_MAX_DEPTH];
+    int        depth;
+    int        best;       // best non-empty level, -1 if none
+} Ladder;
+
+struct OrderBook {
+    Money      minPrice, tick;
+    int        nLevels;
+    Ladder     side[2];
+    BookOrder* orders;
+    uint32_t   cap;
+    uint32_t   freeHead;
+    int        count;
+    BookFillFn onFill;
+    void*      user;
+};
+
+// ---- occupancy bitmap ----
+static void ladderSet(Ladder* l, int i) {
+    for (int d = 0; d < l->depth; ++d) {
+        int w = i >> 6;
+        uint64_t was = l->bits[d][w];
+        l->bits[d][w] = was | (1ULL << (i & 63));
+        if (was) return;              // parent bit already set
+        i = w;
+    }
+}
+
+static void ladderClear(Ladder* l, int i) {
+    for (int d = 0; d < l->depth; ++d) {
+        int w = i >> 6;
+        l->bits[d][w] &= ~(1ULL << (i & 63));
+        if (l->bits[d][w]) return;    // word still occupied, parents unchanged
+        i = w;
+    }
+}
+
+// Lowest set index >= i at depth d, or -1.
+static int ladderNext(const Ladder* l, int d, int i) {
+    int w = i >> 6;
+    if (w >= l->words[d]) return -1;
+    uint64_t m = l->bits[d][w] & (~0ULL << (i & 63));
+    if (m) return (w << 6) | __builtin_ctzll(m);
+    if (d == l->depth - 1) return -1;
+    int nw = ladderNext(l, d + 1, w + 1);
+    return (nw < 0) ? -1 : (nw << 6) | __builtin_ctzll(l->bits[d][nw]);
+}
+
+// Highest set index <= i at depth d, or -1.
+static int ladderPrev(const Ladder* l, int d, int i) {
+    if (i < 0) return -1;
+    int w = i >> 6;
+    if (w >= l->words[d]) { w = l->words[d] - 1; i = (w << 6) | 63; }
+    uint64_t m = l->bits[d][w] & (((i & 63) == 63) ? ~0ULL : ((2ULL << (i & 63)) - 1));
+    if (m) return (w << 6) | (63 - __builtin_clzll(m));
+    if (d == l->depth - 1) return -1;
+    int pw = ladderPrev(l, d + 1, w - 1);
+    return (pw < 0) ? -1 : (pw << 6) | (63 - __builtin_clzll(l->bits[d][pw]));
+}
+
+static bool ladderInit(Ladder* l, int n) {
+    memset(l, 0, sizeof(*l));
+    l->best = -1;
+    l->levels = (BookLevel*)calloc((size_t)n, sizeof(BookLevel));
+    if (!l->levels) return false;
+    int count = n;
+    do {
+        int words = (count + 63) / 64;
+        l->words[l->depth] = words;
+        l->bits[l->depth] = (uint64_t*)calloc((size_t)words, sizeof(uint64_t));
+        if (!l->bits[l->depth]) return false;
+        l->depth++;
+        count = words;
+    } while (count > 1);
+    return true;
+}
+
+static void ladderFree(Ladder* l) {
+    free(l->levels);
+    for (int d = 0; d < LADDER_MAX_DEPTH; ++d) free(l->bits[d]);
+}
+
+// ---- book ----
+OrderBook* orderBookCreate(Money minPrice, Money tick, int levels, int maxOrders) {
+    if (tick <= 0 || levels <= 0 || levels > 64 * 64 * 64 || maxOrders <= 0) return NULL;
+    OrderBook* b = (OrderBook*)calloc(1, sizeof(OrderBook));
+    if (!b) return NULL;
+    b->minPrice = minPrice;
+    b->tick     = tick;
+    b->nLevels  = levels;
+    b->cap      = (uint32_t)maxOrders + 1;
+    b->orders   = (BookOrder*)calloc(b->cap, sizeof(BookOrder));
+    if (!b->orders || !ladderInit(&b->side[BOOK_BUY], levels) || !ladderInit(&b->side[BOOK_SELL], levels)) {
+        orderBookFree(b);
+        return NULL;
+    }
+    // Free list in slot order, so early orders land in low (warm) slots
+    for (uint32_t i = 1; i < b->cap; ++i) {
+        b->orders[i].level = -1;
+        b->orders[i].gen   = 1;
+        b->orders[i].next  = (i + 1 < b->cap) ? i + 1 : NIL;
+    }
+    b->freeHead = 1;
+    return b;
+}
+
+void orderBookFree(OrderBook* b) {
+    if (!b) return;
+    ladderFree(&b->side[BOOK_BUY]);
+    ladderFree(&b->side[BOOK_SELL]);
+    free(b->orders);
+    free(b);
+}
+
+void orderBookSetFillHandler(OrderBook* b, BookFillFn fn, void* user) {
+    b->onFill = fn;
+    b->user   = user;
+}
+
+static inline OrderId makeId(const OrderBook* b, uint32_t slot) {
+    return ((uint64_t)b->orders[slot].gen << 32) | slot;
+}
+
+static inline Money levelPrice(const OrderBook* b, int level) {
+    return b->minPrice + moneyMulInt(b->tick, level);
+}
+
+// Ladder index of an exact tick price, or -1.
+static int priceLevel(const OrderBook* b, Money price) {
+    Money off = price - b->minPrice;
+    if (off < 0 || off % b->tick != 0) return -1;
+    Money level = off / b->tick;
+    return (level < b->nLevels) ? (int)level : -1;
+}
+
+// Slot of a live order, or NIL.
+static uint32_t liveSlot(const OrderBook* b, OrderId id) {
+    uint32_t slot = (uint32_t)id;
+    if (slot == NIL || slot >= b->cap) return NIL;
+    const BookOrder* o = &b->orders[slot];
+    return (o->level >= 0 && o->gen == (uint32_t)(id >> 32)) ? slot : NIL;
+}
+
+// Level emptied: drop it from the bitmap and move 'best' if it was the best.
+static void levelEmptied(Ladder* l, int side, int level) {
+    ladderClear(l, level);
+    if (l->best != level) return;
+    l->best = (side == BOOK_BUY) ? ladderPrev(l, 0, level - 1) : ladderNext(l, 0, level + 1);
+}
+
+static void releaseSlot(OrderBook* b, uint32_t slot) {
+    BookOrder* o = &b->orders[slot];
+    o->level = -1;
+    o->gen++;
+    o->next = b->freeHead;
+    b->freeHead = slot;
+    b->count--;
+}
+
+// Fill resting orders on 'side' from the best level while it is at or better
+// than 'limitLevel', up to 'want' shares, at 'exec' (0 = each level's price).
+// 'taker' (optional) reports the incoming order's fills as well.
+// Returns the quantity filled.
+static int64_t takeFrom(OrderBook* b, int side, int limitLevel, int64_t want, Money exec, BookFill* taker) {
+    Ladder* l = &b->side[side];
+    int64_t done = 0;
+    while (want > 0 && l->best >= 0 && (side == BOOK_BUY ? l->best >= limitLevel : l->best <= limitLevel)) {
+        int level = l->best;
+        BookLevel* lv = &l->levels[level];
+        Money limit = levelPrice(b, level);
+        Money price = exec ? exec : limit;
+        while (want > 0 && lv->head != NIL) {
+            uint32_t slot = lv->head;
+            BookOrder* o = &b->orders[slot];
+            int32_t q = (o->qty < want) ? o->qty : (int32_t)want;
+            o->qty  -= q;
+            lv->qty -= q;
+            want    -= q;
+            done    += q;
+
+            BookFill f = { makeId(b, slot), o->owner, (BookSide)side, price, limit, q, o->qty };
+            if (o->qty == 0) {
+                lv->head = o->next;
+                if (lv->head != NIL) b->orders[lv->head].prev = NIL;
+                else lv->tail = NIL;
+                releaseSlot(b, slot);
+            }
+            if (b->onFill) {
+                b->onFill(&f, b->user);
+                if (taker) {
+                    taker->price = price;
+                    taker->qty   = q;
+                    taker->remaining -= q;
+                    b->onFill(taker, b->user);
+                }
+            }
+        }
+        if (lv->head == NIL) levelEmptied(l, side, level);
+    }
+    return done;
+}
+
+OrderId orderBookLimit(OrderBook* b, BookSide side, Money price, int32_t qty, uint32_t owner, int32_t* filled) {
+    if (filled) *filled = 0;
+    int level = priceLevel(b, price);
+    if (level < 0 || qty <= 0) return 0;
+
+    // Cross the opposite side first
+    BookFill taker = { 0, owner, side, price, price, 0, qty };
+    int32_t done = (int32_t)takeFrom(b, side ^ 1, level, qty, 0, &taker);
+    if (filled) *filled = done;
+    qty -= done;
+    if (qty == 0 || b->freeHead == NIL) return 0;
+
+    uint32_t slot = b->freeHead;
+    BookOrder* o = &b->orders[slot];
+    b->freeHead = o->next;
+    b->count++;
+    o->qty   = qty;
+    o->owner = owner;
+    o->side  = (uint8_t)side;
+    o->level = level;
+    o->next  = NIL;
+
+    Ladder* l = &b->side[side];
+    BookLevel* lv = &l->levels[level];
+    o->prev = lv->tail;
+    if (lv->tail != NIL) b->orders[lv->tail].next = slot;
+    else {
+        lv->head = slot;
+        ladderSet(l, level);
+        if (l->best < 0 || (side == BOOK_BUY ? level > l->best : level < l->best)) l->best = level;
+    }
+    lv->tail = slot;
+    lv->qty += qty;
+    return makeId(b, slot);
+}
+
+bool orderBookCancel(OrderBook* b, OrderId id) {
+    uint32_t slot = liveSlot(b, id);
+    if (slot == NIL) return false;
+    BookOrder* o = &b->orders[slot];
+    Ladder* l = &b->side[o->side];
+    BookLevel* lv = &l->levels[o->level];
+
+    if (o->prev != NIL) b->orders[o->prev].next = o->next; else lv->head = o->next;
+    if (o->next != NIL) b->orders[o->next].prev = o->prev; else lv->tail = o->prev;
+    lv->qty -= o->qty;
+    if (lv->head == NIL) levelEmptied(l, o->side, o->level);
+    releaseSlot(b, slot);
+    return true;
+}
+
+int64_t orderBookMatchTick(OrderBook* b, Money price, int64_t volume) {
+    if (volume <= 0) volume = INT64_MAX;
+    // Levels at or through the print; prices between ticks round inward
+    Money off = price - b->minPrice;
+    int64_t below = (off < 0) ? -1 : off / b->tick;                         // asks <= price
+    int64_t above = (off <= 0) ? 0 : (off + b->tick - 1) / b->tick;         // bids >= price
+    if (below >= b->nLevels) below = b->nLevels - 1;
+    if (above > b->nLevels) above = b->nLevels;
+
+    int64_t done = 0;
+    if (below >= 0) done += takeFrom(b, BOOK_SELL, (int)below, volume, price, NULL);
+    if (above < b->nLevels) done += takeFrom(b, BOOK_BUY, (int)above, volume - done, price, NULL);
+    return done;
+}
+
+bool orderBookBestBid(const OrderBook* b, Money* price) {
+    int best = b->side[BOOK_BUY].best;
+    if (best < 0) return false;
+    *price = levelPrice(b, best);
+    return true;
+}
+
+bool orderBookBestAsk(const OrderBook* b, Money* price) {
+    int best = b->side[BOOK_SELL].best;
+    if (best < 0) return false;
+    *price = levelPrice(b, best);
+    return true;
+}
+
+int64_t orderBookDepthAt(const OrderBook* b, BookSide side, Money price) {
+    int level = priceLevel(b, price);
+    return (level < 0) ? 0 : b->side[side].levels[level].qty;
+}
+
+bool orderBookOrder(const OrderBook* b, OrderId id, BookSide* side, Money* price, int32_t* qty, uint32_t* owner) {
+    uint32_t slot = liveSlot(b, id);
+    if (slot == NIL) return false;
+    const BookOrder* o = &b->orders[slot];
+    if (side)  *side  = (BookSide)o->side;
+    if (price) *price = levelPrice(b, o->level);
+    if (qty)   *qty   = o->qty;
+    if (owner) *owner = o->owner;
+    return true;
+}
+
+int orderBookCount(const OrderBook* b) {
+    return b->count;
+}
@@ -0,0 +1,74 @@
+#ifndef ORDERBOOK_H
+#define ORDERBOOK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "money.h"
+
+// Limit order book for one symbol.
+// Prices live on a fixed ladder (minPrice + k * tick). Each ladder level holds
+// a FIFO of resting orders, linked intrusively through the order pool, so
+// adds, cancels and fills are O(1) and never allocate. A hierarchical
+// occupancy bitmap (64-way) finds the next non-empty level in a few word
+// scans; the best bid/ask are cached, so reading them is O(1).
+// Incoming limits match against the opposite side first (price-time
+// priority); orderBookMatchTick fills resting orders against a traded price.
+
+typedef enum { BOOK_BUY = 0, BOOK_SELL = 1 } BookSide;
+
+// Handle to a resting order: pool slot + generation, so a stale id never
+// cancels a newer order that reused the slot. 0 = none.
+typedef uint64_t OrderId;
+
+typedef struct {
+    OrderId  order;
+    uint32_t owner;        // caller's tag, e.g. stock index
+    BookSide side;
+    Money    price;        // execution price
+    Money    limit;        // the order's limit price
+    int32_t  qty;          // filled now
+    int32_t  remaining;    // left on the order afterwards (0 = done)
+} BookFill;
+
+typedef void (*BookFillFn)(const BookFill* f, void* user);
+
+typedef struct OrderBook OrderBook;
+
+// Ladder of 'levels' prices from minPrice in steps of 'tick' (levels <= 262144),
+// room for maxOrders resting orders. NULL on bad arguments or out of memory.
+OrderBook* orderBookCreate(Money minPrice, Money tick, int levels, int maxOrders);
+void orderBookFree(OrderBook* b);
+
+// Called for every fill, resting (maker) and incoming (taker, order 0) sides
+// alike. The handler must not modify the book.
+void orderBookSetFillHandler(OrderBook* b, BookFillFn fn, void* user);
+
+// Submit a limit order. Crossing quantity fills immediately, the rest rests.
+// Returns the resting order's id, 0 if it filled completely or was rejected
+// (price off the ladder or not on a tick, qty <= 0, pool full); *filled
+// (optional) receives the quantity filled on entry.
+OrderId orderBookLimit(OrderBook* b, BookSide side, Money price, int32_t qty, uint32_t owner, int32_t* filled);
+
+// Remove a resting order. False if it is no longer resting.
+bool orderBookCancel(OrderBook* b, OrderId id);
+
+// A trade printed at 'price' for 'volume' shares (<= 0: unlimited): fill resting
+// buys at or above it and sells at or below it, best level first, FIFO within
+// a level. These fills execute at the print, never worse than their limit;
+// crosses on entry execute at the resting level. Returns the quantity filled.
+int64_t orderBookMatchTick(OrderBook* b, Money price, int64_t volume);
+
+// Best resting prices, O(1). False if that side is empty.
+bool orderBookBestBid(const OrderBook* b, Money* price);
+bool orderBookBestAsk(const OrderBook* b, Money* price);
+
+// Resting quantity at a price (0 if none or off the ladder).
+int64_t orderBookDepthAt(const OrderBook* b, BookSide side, Money price);
+
+// Details of a resting order. False if it is no longer resting.
+bool orderBookOrder(const OrderBook* b, OrderId id, BookSide* side, Money* price, int32_t* qty, uint32_t* owner);
+
+// Number of resting orders.
+int orderBookCount(const OrderBook* b);
+
+#endif // ORDERBOOK_H
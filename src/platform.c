@@ -0,0 +1,162 @@
+#include "platform.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+typedef struct { void (*fn)(void*); void* arg; } ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI threadTrampoline(LPVOID p) {
+    ThreadStart ts = *(ThreadStart*)p;
+    free(p);
+    ts.fn(ts.arg);
+    return 0;
+}
+#else
+static void* threadTrampoline(void* p) {
+    ThreadStart ts = *(ThreadStart*)p;
+    free(p);
+    ts.fn(ts.arg);
+    return NULL;
+}
+#endif
+
+bool platformThreadStart(PlatformThread* t, void (*fn)(void*), void* arg) {
+    ThreadStart* ts = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (!ts) return false;
+    ts->fn = fn; ts->arg = arg;
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, threadTrampoline, ts, 0, NULL);
+    if (!*t) { free(ts); return false; }
+#else
+    if (pthread_create(t, NULL, threadTrampoline, ts) != 0) { free(ts); return false; }
+#endif
+    return true;
+}
+
+void platformThreadJoin(PlatformThread t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+#ifdef _WIN32
+void platformMutexInit(PlatformMutex* m)    { InitializeCriticalSection(m); }
+void platformMutexDestroy(PlatformMutex* m) { DeleteCriticalSection(m); }
+void platformMutexLock(PlatformMutex* m)    { EnterCriticalSection(m); }
+void platformMutexUnlock(PlatformMutex* m)  { LeaveCriticalSection(m); }
+
+void platformCondInit(PlatformCond* c)      { InitializeConditionVariable(c); }
+void platformCondDestroy(PlatformCond* c)   { (void)c; }
+void platformCondWait(PlatformCond* c, PlatformMutex* m)           { SleepConditionVariableCS(c, m, INFINITE); }
+void platformCondWaitMs(PlatformCond* c, PlatformMutex* m, int ms) { SleepConditionVariableCS(c, m, (DWORD)ms); }
+void platformCondSignal(PlatformCond* c)    { WakeConditionVariable(c); }
+void platformCondBroadcast(PlatformCond* c) { WakeAllConditionVariable(c); }
+#else
+void platformMutexInit(PlatformMutex* m)    { pthread_mutex_init(m, NULL); }
+void platformMutexDestroy(PlatformMutex* m) { pthread_mutex_destroy(m); }
+void platformMutexLock(PlatformMutex* m)    { pthread_mutex_lock(m); }
+void platformMutexUnlock(PlatformMutex* m)  { pthread_mutex_unlock(m); }
+
+void platformCondInit(PlatformCond* c)      { pthread_cond_init(c, NULL); }
+void platformCondDestroy(PlatformCond* c)   { pthread_cond_destroy(c); }
+void platformCondWait(PlatformCond* c, PlatformMutex* m) { pthread_cond_wait(c, m); }
+void platformCondWaitMs(PlatformCond* c, PlatformMutex* m, int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+    pthread_cond_timedwait(c, m, &ts);
+}
+void platformCondSignal(PlatformCond* c)    { pthread_cond_signal(c); }
+void platformCondBroadcast(PlatformCond* c) { pthread_cond_broadcast(c); }
+#endif
+
+bool platformFileSync(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(f))) != 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+bool platformFileTruncate(FILE* f, int64_t size) {
+    // A seek, unlike fflush, is valid whichever way an update stream was last
+    // used: it writes pending output and drops read-ahead
+    if (fseek(f, 0, SEEK_CUR) != 0) return false;
+#ifdef _WIN32
+    return _chsize_s(_fileno(f), size) == 0;
+#else
+    return ftruncate(fileno(f), (off_t)size) == 0;
+#endif
+}
+
+bool platformReplaceFile(const char* src, const char* dst) {
+#ifdef _WIN32
+    return MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(src, dst) == 0;
+#endif
+}
+
+const void* platformMapFile(const char* path, size_t* size) {
+    *size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(file, &len) || len.QuadPart == 0) { CloseHandle(file); return NULL; }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return NULL;
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);                  // the view keeps the mapping alive
+    if (!data) return NULL;
+    *size = (size_t)len.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return NULL; }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return data;
+#endif
+}
+
+void platformUnmapFile(const void* data, size_t size) {
+    if (!data) return;
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+int platformCpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// Thin OS layer for the non-GL modules: threads, locks, file durability.
+// Win32 API on Windows (MinGW), pthreads/POSIX elsewhere.
+// Not included by main.c so windows.h never meets the GL headers.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE             PlatformThread;
+typedef CRITICAL_SECTION   PlatformMutex;
+typedef CONDITION_VARIABLE PlatformCond;
+#else
+#include <pthread.h>
+typedef pthread_t          PlatformThread;
+typedef pthread_mutex_t    PlatformMutex;
+typedef pthread_cond_t     PlatformCond;
+#endif
+
+// Start fn(arg) on a new thread. Returns false on failure.
+bool platformThreadStart(PlatformThread* t, void (*fn)(void*), void* arg);
+void platformThreadJoin(PlatformThread t);
+
+void platformMutexInit(PlatformMutex* m);
+void platformMutexDestroy(PlatformMutex* m);
+void platformMutexLock(PlatformMutex* m);
+void platformMutexUnlock(PlatformMutex* m);
+
+void platformCondInit(PlatformCond* c);
+void platformCondDestroy(PlatformCond* c);
+void platformCondWait(PlatformCond* c, PlatformMutex* m);
+// Wait at most 'ms' milliseconds (spurious wakeups possible, as with Wait).
+void platformCondWaitMs(PlatformCond* c, PlatformMutex* m, int ms);
+void platformCondSignal(PlatformCond* c);
+void platformCondBroadcast(PlatformCond* c);
+
+// Flush stdio buffers and force the file's data to stable storage.
+bool platformFileSync(FILE* f);
+
+// Cut the file to 'size' bytes (used to drop a torn tail before appending).
+bool platformFileTruncate(FILE* f, int64_t size);
+
+// Atomically replace 'dst' with 'src' (rename over an existing file).
+bool platformReplaceFile(const char* src, const char* dst);
+
+// Map a whole file read-only. Returns NULL if missing or empty; *size gets the length.
+const void* platformMapFile(const char* path, size_t* size);
+void platformUnmapFile(const void* data, size_t size);
+
+// Logical CPU count (>= 1).
+int platformCpuCount(void);
+
+#endif // PLATFORM_H
@@ -0,0 +1,119 @@
+#include "portfolio.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline void aggRemove(Portfolio* p, const Position* s) {
+    p->holdingsValue -= moneyMulInt(s->price, s->qty);
+    p->invested      -= s->totalCost;
+    if (s->qty > 0) p->openPositions--;
+}
+static inline void aggAdd(Portfolio* p, const Position* s) {
+    p->holdingsValue += moneyMulInt(s->price, s->qty);
+    p->invested      += s->totalCost;
+    if (s->qty > 0) p->openPositions++;
+}
+
+bool portfolioInit(Portfolio* p, int count, const char* const* symbols, const Money* prices,
+                   Money cash, uint32_t lotCapacity) {
+    memset(p, 0, sizeof(*p));
+    if (count < 1 || count > PORTFOLIO_MAX_STOCKS) return false;
+    p->count = count;
+    p->cash  = cash;
+    p->relief = RELIEF_FIFO;
+    for (int i = 0; i < count; ++i) {
+        strncpy(p->pos[i].symbol, symbols[i], sizeof(p->pos[i].symbol) - 1);
+        p->pos[i].price = prices[i];
+    }
+    bool ok = lotPoolInit(&p->lots, lotCapacity);
+    for (int i = 0; i < count; ++i) ok = ok && lotQueueInit(&p->queues[i], &p->lots);
+    if (!ok) portfolioFree(p);
+    return ok;
+}
+
+void portfolioFree(Portfolio* p) {
+    for (int i = 0; i < PORTFOLIO_MAX_STOCKS; ++i) lotQueueFree(&p->queues[i]);
+    lotPoolFree(&p->lots);
+    memset(p, 0, sizeof(*p));
+}
+
+int portfolioFind(const Portfolio* p, const char* symbol, size_t maxLen) {
+    for (int i = 0; i < p->count; ++i)
+        if (strncmp(p->pos[i].symbol, symbol, maxLen) == 0) return i;
+    return -1;
+}
+
+void portfolioSetPrice(Portfolio* p, int i, Money price) {
+    Position* s = &p->pos[i];
+    p->holdingsValue += moneyMulInt(price - s->price, s->qty);
+    s->price = price;
+}
+
+void portfolioFill(Portfolio* p, int i, int qty, Money price) {
+    Position* s = &p->pos[i];
+    aggRemove(p, s);
+    if (qty > 0) {
+        Money cost = moneyMulInt(price, qty);
+        if (!lotOpen(&p->lots, &p->queues[i], qty, price, cost) && !lotMergeNewest(&p->lots, &p->queues[i], qty, cost))
+            fprintf(stderr, "Lots: pool full, %s buy of %d has no lot\n", s->symbol, qty);
+        p->cash      -= cost;
+        s->totalCost += cost;
+        s->qty       += qty;
+    } else {
+        int n = -qty;
+        Money relieved = lotRelieve(&p->lots, &p->queues[i], n, price, p->relief);
+        Money proceeds = moneyMulInt(price, n);
+        p->realized  += proceeds - relieved;
+        p->cash      += proceeds;
+        s->qty       -= n;
+        s->totalCost -= relieved;
+    }
+    s->avgCost = (s->qty > 0) ? moneyDivInt(s->totalCost, s->qty) : 0;
+    aggAdd(p, s);
+}
+
+bool portfolioCanFill(const Portfolio* p, int i, long long qty, int reservedQty) {
+    const Position* s = &p->pos[i];
+    if (qty < 0) return -qty <= (long long)(s->qty - reservedQty);
+    if (qty > (long long)(INT_MAX - s->qty)) return false;
+    return lotPoolAvailable(&p->lots) > 0 || p->queues[i].count > 0;
+}
+
+bool portfolioDeposit(Portfolio* p, Money amount) {
+    if (amount <= 0 || amount > INT64_MAX - p->cash) return false;
+    p->cash += amount;
+    return true;
+}
+
+void portfolioSetPosition(Portfolio* p, int i, Money price, int qty, Money totalCost) {
+    Position* s = &p->pos[i];
+    aggRemove(p, s);
+    s->price     = price;
+    s->qty       = qty;
+    s->totalCost = totalCost;
+    s->avgCost   = (qty > 0) ? moneyDivInt(totalCost, qty) : 0;
+    aggAdd(p, s);
+}
+
+bool portfolioCheck(const Portfolio* p) {
+    Money cost[PORTFOLIO_MAX_STOCKS], value[PORTFOLIO_MAX_STOCKS];
+    int open = 0;
+    bool ok = true;
+    for (int i = 0; i < p->count; ++i) {
+        const Position* s = &p->pos[i];
+        cost[i]  = s->totalCost;
+        value[i] = moneyMulInt(s->price, s->qty);
+        if (s->qty > 0) open++;
+
+        Money basis = 0;
+        long long held = 0;
+        for (uint32_t l = p->queues[i].head; l; l = p->lots.lots[l].next) {
+            basis += p->lots.lots[l].basis;
+            held  += p->lots.lots[l].qty;
+        }
+        ok = ok && basis == s->totalCost && held == s->qty;
+    }
+    return ok && moneySum(cost, p->count) == p->invested &&
+           moneySum(value, p->count) == p->holdingsValue && open == p->openPositions;
+}
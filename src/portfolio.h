@@ -0,0 +1,80 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "money.h"
+#include "lots.h"
+
+// Positions, cash, tax lots and P&L of a set of stocks: the accounting core
+// shared by the app and headless backtests. All state lives in the Portfolio
+// value, so any number of them can run side by side (one per thread).
+// Aggregates are maintained by deltas on every price tick and fill, so the
+// stats below are O(1). Integer money, so the deltas are exact.
+
+#define PORTFOLIO_MAX_STOCKS 8
+
+typedef struct {
+    char  symbol[8];
+    Money price;
+    int   qty;
+    Money avgCost;      // display only: totalCost / qty
+    Money totalCost;    // sum of the lots' basis
+} Position;
+
+typedef struct {
+    int      count;
+    Position pos[PORTFOLIO_MAX_STOCKS];
+    Money    cash, realized;
+    Money    holdingsValue;     // sum of qty * price
+    Money    invested;          // sum of totalCost
+    int      openPositions;     // positions with qty > 0
+    LotPool  lots;
+    LotQueue queues[PORTFOLIO_MAX_STOCKS];
+    ReliefMethod relief;
+} Portfolio;
+
+// Flat portfolio of 'count' stocks at their opening prices with room for
+// lotCapacity tax lots. False if out of memory (nothing to free then).
+bool portfolioInit(Portfolio* p, int count, const char* const* symbols, const Money* prices,
+                   Money cash, uint32_t lotCapacity);
+void portfolioFree(Portfolio* p);
+
+// Index of the stock whose symbol matches the first maxLen chars, -1 if none.
+int portfolioFind(const Portfolio* p, const char* symbol, size_t maxLen);
+
+// Mark stock i to a new price.
+void portfolioSetPrice(Portfolio* p, int i, Money price);
+
+// Move a position by qty shares at 'price' (buy > 0, sell < 0). No checks:
+// callers validate first. A buy opens a tax lot (or folds into the newest
+// one when the pool is full); a sale relieves lots by p->relief and realizes
+// against their basis, so closing a position reconciles its basis to zero.
+void portfolioFill(Portfolio* p, int i, int qty, Money price);
+
+// Position side of an order check: a sale (qty < 0) must fit the shares not
+// reserved elsewhere (e.g. by open limit sells), a buy must not overflow the
+// position and needs a lot. Cash is the caller's to check, since a basket
+// nets it across legs.
+bool portfolioCanFill(const Portfolio* p, int i, long long qty, int reservedQty);
+
+// Add cash. False if the amount is not positive or would overflow.
+bool portfolioDeposit(Portfolio* p, Money amount);
+
+// Overwrite a position wholesale (snapshot restore); its lots are loaded
+// separately through p->lots / p->queues.
+void portfolioSetPosition(Portfolio* p, int i, Money price, int qty, Money totalCost);
+
+// Full recount of the aggregates and lots. False if anything is out of sync.
+bool portfolioCheck(const Portfolio* p);
+
+static inline Money portfolioHoldingsValue(const Portfolio* p) { return p->holdingsValue; }
+static inline Money portfolioInvested(const Portfolio* p)      { return p->invested; }
+static inline Money portfolioUnrealizedPnL(const Portfolio* p) { return p->holdingsValue - p->invested; }
+static inline Money portfolioTotalReturn(const Portfolio* p)   { return p->realized + portfolioUnrealizedPnL(p); }
+static inline bool  portfolioHasPosition(const Portfolio* p)   { return p->openPositions > 0; }
+// Equity = cash + live holdings
+static inline Money portfolioEquity(const Portfolio* p)        { return p->cash + p->holdingsValue; }
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,323 @@
+#include "risk.h"
+#include "platform.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RISK_MAX_WORKERS 64
+#define RISK_PUBLISHES   16     // partial results per job, roughly
+
+typedef struct {
+    RiskJob  job;
+    double   chol[RISK_MAX_ASSETS][RISK_MAX_ASSETS];   // per-step, lower triangular
+    double   stepDrift[RISK_MAX_ASSETS];
+} RiskPlan;
+
+// Per-chunk arrays, one row of paths per asset
+typedef struct {
+    double x[RISK_MAX_ASSETS][RISK_CHUNK];     // log return so far
+    double z[RISK_MAX_ASSETS][RISK_CHUNK];     // this step's shocks
+    double loss[RISK_CHUNK];
+} RiskScratch;
+
+typedef struct {
+    RiskEngine* engine;
+    PlatformThread thread;
+    RiskScratch* scratch;
+    double* ranked;             // copy of finished losses for ranking
+} RiskWorker;
+
+struct RiskEngine {
+    PlatformMutex lock;
+    PlatformCond  wake;          // new job or stop
+    bool     stop;
+
+    int      maxPaths, maxChunks;
+    RiskWorker workers[RISK_MAX_WORKERS];
+    int      workerCount;
+
+    // current job, all under 'lock'
+    uint64_t jobId;
+    RiskPlan plan;
+    int      chunks, nextChunk, doneChunks, donePaths, publishEvery;
+    double*  losses;             // per path, by chunk
+    uint8_t* chunkDone;
+    RiskResult result;           // newest published
+    bool     haveResult;
+};
+
+// ---- random numbers: xoshiro256+, seeded per chunk through splitmix64 ----
+typedef struct { uint64_t s[4]; } Rng;
+
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rngSeed(Rng* r, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int k = 0; k < 4; ++k) r->s[k] = splitmix64(&x);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+static inline uint64_t rngNext(Rng* r) {
+    uint64_t* s = r->s;
+    uint64_t out = s[0] + s[3];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return out;
+}
+
+// (0, 1]: safe for log()
+static inline double rngUnit(Rng* r) { return ((rngNext(r) >> 11) + 1) * (1.0 / 9007199254740992.0); }
+
+// n standard normals (n even), Box-Muller over whole arrays
+static void fillNormals(Rng* r, double* z, int n) {
+    int half = n / 2;
+    double* u1 = z;
+    double* u2 = z + half;
+    for (int k = 0; k < half; ++k) { u1[k] = rngUnit(r); u2[k] = rngUnit(r); }
+    for (int k = 0; k < half; ++k) {
+        double rad = sqrt(-2.0 * log(u1[k]));
+        double th  = 6.283185307179586 * u2[k];
+        u1[k] = rad * cos(th);
+        u2[k] = rad * sin(th);
+    }
+}
+
+// ---- simulation ----
+// Losses (negative P&L) of the chunk's n paths into sc->loss.
+static void simulateChunk(const RiskPlan* p, int chunk, int n, RiskScratch* sc) {
+    double (*x)[RISK_CHUNK] = sc->x;
+    double (*z)[RISK_CHUNK] = sc->z;
+    double* out = sc->loss;
+    int A = p->job.assets;
+    int m = (n + 1) & ~1;
+    Rng rng;
+    rngSeed(&rng, p->job.seed, (uint64_t)chunk);
+
+    for (int a = 0; a < A; ++a)
+        for (int k = 0; k < n; ++k) x[a][k] = 0.0;
+    for (int step = 0; step < p->job.steps; ++step) {
+        for (int a = 0; a < A; ++a) fillNormals(&rng, z[a], m);
+        // correlate in place from the last asset down: row a only reads z[0..a]
+        for (int a = A - 1; a >= 0; --a) {
+            double* xa = x[a];
+            const double* za = z[a];
+            double drift = p->stepDrift[a];
+            double d = p->chol[a][a];
+            for (int k = 0; k < n; ++k) xa[k] += drift + d * za[k];
+            for (int b = 0; b < a; ++b) {
+                double c = p->chol[a][b];
+                const double* zb = z[b];
+                if (c != 0.0) for (int k = 0; k < n; ++k) xa[k] += c * zb[k];
+            }
+        }
+    }
+    for (int k = 0; k < n; ++k) out[k] = 0.0;
+    for (int a = 0; a < A; ++a) {
+        double v = p->job.value[a];
+        for (int k = 0; k < n; ++k) out[k] -= v * (exp(x[a][k]) - 1.0);
+    }
+}
+
+// Rearrange a so its t largest values come first (quickselect).
+static void selectLargest(double* a, int n, int t) {
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        double pivot = a[lo + (hi - lo) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] > pivot) i++;
+            while (a[j] < pivot) j--;
+            if (i <= j) { double tmp = a[i]; a[i] = a[j]; a[j] = tmp; i++; j--; }
+        }
+        if (t - 1 <= j)      hi = j;
+        else if (t - 1 >= i) lo = i;
+        else break;
+    }
+}
+
+static void rankLosses(double* losses, int n, double confidence, RiskResult* r) {
+    int t = (int)ceil((1.0 - confidence) * n);
+    if (t < 1) t = 1;
+    if (t > n) t = n;
+    double total = 0.0;
+    for (int k = 0; k < n; ++k) total += losses[k];
+    selectLargest(losses, n, t);
+    double tail = 0.0, var = losses[0];
+    for (int k = 0; k < t; ++k) {
+        tail += losses[k];
+        if (losses[k] < var) var = losses[k];
+    }
+    r->var = var;
+    r->cvar = tail / t;
+    r->meanPnL = -total / n;
+    r->pathsDone = n;
+}
+
+static void riskMain(void* arg) {
+    RiskWorker* w = (RiskWorker*)arg;
+    RiskEngine* e = w->engine;
+    RiskPlan plan = {0};
+    uint64_t planId = 0;
+
+    platformMutexLock(&e->lock);
+    for (;;) {
+        while (!e->stop && e->nextChunk >= e->chunks) platformCondWait(&e->wake, &e->lock);
+        if (e->stop) break;
+
+        uint64_t id = e->jobId;
+        if (planId != id) { plan = e->plan; planId = id; }
+        int chunk = e->nextChunk++;
+        int n = plan.job.paths - chunk * RISK_CHUNK;
+        if (n > RISK_CHUNK) n = RISK_CHUNK;
+        platformMutexUnlock(&e->lock);
+
+        simulateChunk(&plan, chunk, n, w->scratch);
+
+        platformMutexLock(&e->lock);
+        if (e->jobId != id) continue;            // superseded, drop the chunk
+        memcpy(e->losses + (size_t)chunk * RISK_CHUNK, w->scratch->loss, (size_t)n * sizeof(double));
+        e->chunkDone[chunk] = 1;
+        e->doneChunks++;
+        e->donePaths += n;
+        if (e->doneChunks % e->publishEvery != 0 && e->doneChunks != e->chunks) continue;
+
+        // Rank everything finished so far outside the lock
+        int count = 0;
+        for (int c = 0; c < e->chunks; ++c) {
+            if (!e->chunkDone[c]) continue;
+            int cn = plan.job.paths - c * RISK_CHUNK;
+            if (cn > RISK_CHUNK) cn = RISK_CHUNK;
+            memcpy(w->ranked + count, e->losses + (size_t)c * RISK_CHUNK, (size_t)cn * sizeof(double));
+            count += cn;
+        }
+        platformMutexUnlock(&e->lock);
+
+        RiskResult r = { .job = id, .paths = plan.job.paths };
+        rankLosses(w->ranked, count, plan.job.confidence, &r);
+
+        platformMutexLock(&e->lock);
+        if (e->jobId == id && (!e->haveResult || e->result.job != id || e->result.pathsDone < count)) {
+            e->result = r;
+            e->haveResult = true;
+        }
+    }
+    platformMutexUnlock(&e->lock);
+}
+
+// Lower-triangular L with L L^T = cov. Semi-definite inputs (e.g. an asset
+// with no variance) get zero columns; false if cov is not PSD.
+static bool cholesky(int n, const double cov[RISK_MAX_ASSETS][RISK_MAX_ASSETS], double L[RISK_MAX_ASSETS][RISK_MAX_ASSETS]) {
+    memset(L, 0, sizeof(double) * RISK_MAX_ASSETS * RISK_MAX_ASSETS);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            double s = cov[i][j];
+            for (int k = 0; k < j; ++k) s -= L[i][k] * L[j][k];
+            if (i == j) {
+                double tol = 1e-12 * (fabs(cov[i][i]) + 1e-300);
+                if (s < -tol) return false;
+                L[i][i] = (s > tol) ? sqrt(s) : 0.0;
+            } else {
+                L[i][j] = (L[j][j] > 0.0) ? s / L[j][j] : 0.0;
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t riskSubmit(RiskEngine* e, const RiskJob* job) {
+    if (!e || job->assets < 1 || job->assets > RISK_MAX_ASSETS || job->steps < 1 ||
+        job->paths < 1 || job->paths > e->maxPaths || !(job->confidence > 0.0 && job->confidence < 1.0))
+        return 0;
+    RiskPlan plan;
+    plan.job = *job;
+    double stepCov[RISK_MAX_ASSETS][RISK_MAX_ASSETS] = {{0}};
+    for (int i = 0; i < job->assets; ++i) {
+        plan.stepDrift[i] = job->drift[i] / job->steps;
+        for (int k = 0; k < job->assets; ++k) stepCov[i][k] = job->cov[i][k] / job->steps;
+    }
+    if (!cholesky(job->assets, stepCov, plan.chol)) return 0;
+
+    platformMutexLock(&e->lock);
+    uint64_t id = ++e->jobId;
+    e->plan = plan;
+    e->chunks = (job->paths + RISK_CHUNK - 1) / RISK_CHUNK;
+    e->nextChunk = e->doneChunks = e->donePaths = 0;
+    e->publishEvery = (e->chunks + RISK_PUBLISHES - 1) / RISK_PUBLISHES;
+    memset(e->chunkDone, 0, (size_t)e->chunks);
+    platformCondBroadcast(&e->wake);
+    platformMutexUnlock(&e->lock);
+    return id;
+}
+
+bool riskLatest(RiskEngine* e, RiskResult* out) {
+    if (!e) return false;
+    platformMutexLock(&e->lock);
+    bool have = e->haveResult;
+    if (have) *out = e->result;
+    platformMutexUnlock(&e->lock);
+    return have;
+}
+
+int riskWorkerCount(const RiskEngine* e) {
+    return e ? e->workerCount : 0;
+}
+
+RiskEngine* riskEngineStart(int workers, int maxPaths) {
+    if (maxPaths < 1) return NULL;
+    if (workers <= 0) workers = platformCpuCount() - 1;
+    if (workers < 1) workers = 1;
+    if (workers > RISK_MAX_WORKERS) workers = RISK_MAX_WORKERS;
+
+    RiskEngine* e = (RiskEngine*)calloc(1, sizeof(RiskEngine));
+    if (!e) return NULL;
+    e->maxPaths  = maxPaths;
+    e->maxChunks = (maxPaths + RISK_CHUNK - 1) / RISK_CHUNK;
+    e->losses    = (double*)malloc((size_t)e->maxChunks * RISK_CHUNK * sizeof(double));
+    e->chunkDone = (uint8_t*)calloc((size_t)e->maxChunks, 1);
+    if (!e->losses || !e->chunkDone) { free(e->losses); free(e->chunkDone); free(e); return NULL; }
+    platformMutexInit(&e->lock);
+    platformCondInit(&e->wake);
+
+    for (int k = 0; k < workers; ++k) {
+        RiskWorker* w = &e->workers[e->workerCount];
+        w->engine = e;
+        w->scratch = (RiskScratch*)malloc(sizeof(RiskScratch));
+        w->ranked  = (double*)malloc((size_t)maxPaths * sizeof(double));
+        if (!w->scratch || !w->ranked || !platformThreadStart(&w->thread, riskMain, w)) {
+            free(w->scratch); free(w->ranked);
+            break;
+        }
+        e->workerCount++;
+    }
+    if (e->workerCount == 0) {
+        riskEngineStop(e);
+        return NULL;
+    }
+    return e;
+}
+
+void riskEngineStop(RiskEngine* e) {
+    if (!e) return;
+    platformMutexLock(&e->lock);
+    e->stop = true;
+    platformCondBroadcast(&e->wake);
+    platformMutexUnlock(&e->lock);
+    for (int k = 0; k < e->workerCount; ++k) {
+        platformThreadJoin(e->workers[k].thread);
+        free(e->workers[k].scratch);
+        free(e->workers[k].ranked);
+    }
+    platformCondDestroy(&e->wake);
+    platformMutexDestroy(&e->lock);
+    free(e->losses);
+    free(e->chunkDone);
+    free(e);
+}
@@ -0,0 +1,59 @@
+#ifndef RISK_H
+#define RISK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Monte Carlo value-at-risk for a portfolio of a few assets.
+// Log prices follow a correlated Gaussian walk over the horizon (Cholesky of
+// the covariance), split into 'steps' increments per path. A pool of worker
+// threads takes chunks of RISK_CHUNK paths; each chunk is generated
+// structure-of-arrays (one array of paths per asset), so the inner loops run
+// over paths and vectorize. Each chunk seeds its own generator from the job
+// seed, so results do not depend on the worker count.
+// Every so often a worker ranks the paths finished so far and publishes a
+// partial result; the UI thread polls the newest one and never waits.
+// Submitting a new job abandons the one in flight.
+
+#define RISK_MAX_ASSETS 8
+#define RISK_CHUNK      1024
+
+typedef struct {
+    int      assets;                                  // 1..RISK_MAX_ASSETS
+    double   value[RISK_MAX_ASSETS];                  // market value held
+    double   drift[RISK_MAX_ASSETS];                  // mean log return over the horizon
+    double   cov[RISK_MAX_ASSETS][RISK_MAX_ASSETS];   // log-return covariance over the horizon
+    int      steps;                                   // increments per path (>= 1)
+    int      paths;                                   // 1..maxPaths
+    double   confidence;                              // e.g. 0.99
+    uint64_t seed;
+} RiskJob;
+
+typedef struct {
+    uint64_t job;              // id from riskSubmit
+    int      pathsDone, paths;
+    double   var;              // loss not exceeded with 'confidence' (negative = gain)
+    double   cvar;             // mean loss beyond var (expected shortfall)
+    double   meanPnL;
+} RiskResult;
+
+typedef struct RiskEngine RiskEngine;
+
+// Start 'workers' threads (<= 0: one per CPU but the caller's) for jobs of up
+// to maxPaths paths. NULL if out of memory or no thread could start.
+RiskEngine* riskEngineStart(int workers, int maxPaths);
+
+// Abandon any job and join the workers.
+void riskEngineStop(RiskEngine* e);
+
+// Queue a job, replacing the current one. Returns its id, 0 if the job is
+// invalid (bad sizes, or a covariance that is not positive semi-definite).
+uint64_t riskSubmit(RiskEngine* e, const RiskJob* job);
+
+// Newest published result of the newest job. False if none is out yet.
+bool riskLatest(RiskEngine* e, RiskResult* out);
+
+// Number of worker threads running.
+int riskWorkerCount(const RiskEngine* e);
+
+#endif // RISK_H
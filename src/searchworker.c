@@ -0,0 +1,152 @@
+#include "searchworker.h"
+#include "platform.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define READY_FRESH 4u                  // ready slot holds results the UI has not taken
+
+struct SearchWorker {
+    const SymbolIndex* ix;
+    PlatformThread thread;
+    PlatformMutex  lock;                // guards pending, weights and stop; never held while searching
+    PlatformCond   wake;
+    char     pending[SEARCH_QUERY_MAX];
+    SymbolWeight weights[SEARCH_WEIGHTS_MAX];
+    int      weightCount;
+    bool     stop;
+    _Atomic uint64_t submitted;         // newest sequence number handed out
+
+    SearchResults buf[3];
+    int           back;                 // worker's buffer
+    int           front;                // UI's buffer
+    _Atomic unsigned ready;             // buffer index | READY_FRESH
+    const SearchResults* last;          // newest published, read-only to both sides
+};
+
+typedef struct { SearchWorker* w; uint64_t seq; } CancelCtx;
+
+// A newer submission overtakes the running query
+static bool overtaken(void* user) {
+    CancelCtx* c = (CancelCtx*)user;
+    return atomic_load_explicit(&c->w->submitted, memory_order_relaxed) != c->seq;
+}
+
+static void runQuery(SearchWorker* w, const char* query, const SymbolWeight* weights, int weightCount,
+                     uint64_t seq) {
+    SearchResults* out = &w->buf[w->back];
+    const SearchResults* prev = w->last;
+    CancelCtx ctx = { w, seq };
+    SymbolCancel cancel = { overtaken, &ctx };
+    int total = 0, n;
+
+    if (!query[0])
+        n = 0;
+    else if (prev && prev->count == prev->total && symbolIndexNarrows(prev->query, query))
+        n = symbolIndexRefine(w->ix, query, weights, weightCount, prev->ids, prev->count, out->ids,
+                              SEARCH_RESULTS_MAX, &total, &cancel);
+    else
+        n = symbolIndexQuery(w->ix, query, weights, weightCount, out->ids, SEARCH_RESULTS_MAX, &total, &cancel);
+    if (n < 0) return;                  // overtaken; the newer query follows
+
+    out->seq = seq;
+    snprintf(out->query, sizeof(out->query), "%s", query);
+    out->count = n;
+    out->total = query[0] ? total : 0;
+    w->last = out;
+    unsigned old = atomic_exchange_explicit(&w->ready, (unsigned)w->back | READY_FRESH, memory_order_acq_rel);
+    w->back = (int)(old & 3u);
+}
+
+static void workerMain(void* arg) {
+    SearchWorker* w = (SearchWorker*)arg;
+    uint64_t done = 0;
+    char query[SEARCH_QUERY_MAX];
+    SymbolWeight weights[SEARCH_WEIGHTS_MAX];
+    for (;;) {
+        platformMutexLock(&w->lock);
+        while (!w->stop && atomic_load(&w->submitted) == done) platformCondWait(&w->wake, &w->lock);
+        if (w->stop) { platformMutexUnlock(&w->lock); return; }
+        uint64_t seq = atomic_load(&w->submitted);
+        memcpy(query, w->pending, sizeof(query));
+        int weightCount = w->weightCount;
+        memcpy(weights, w->weights, (size_t)weightCount * sizeof(SymbolWeight));
+        platformMutexUnlock(&w->lock);
+
+        runQuery(w, query, weights, weightCount, seq);
+        done = seq;
+    }
+}
+
+SearchWorker* searchWorkerStart(const SymbolIndex* ix) {
+    if (!ix) return NULL;
+    SearchWorker* w = (SearchWorker*)calloc(1, sizeof(SearchWorker));
+    if (!w) return NULL;
+    w->ix = ix;
+    for (int i = 0; i < 3; ++i) {
+        w->buf[i].ids = (uint32_t*)malloc(SEARCH_RESULTS_MAX * sizeof(uint32_t));
+        if (!w->buf[i].ids) {
+            for (int k = 0; k < i; ++k) free(w->buf[k].ids);
+            free(w);
+            return NULL;
+        }
+    }
+    w->back = 0;
+    atomic_init(&w->ready, 1u);
+    w->front = 2;
+    atomic_init(&w->submitted, 0);
+    platformMutexInit(&w->lock);
+    platformCondInit(&w->wake);
+    if (!platformThreadStart(&w->thread, workerMain, w)) {
+        platformCondDestroy(&w->wake);
+        platformMutexDestroy(&w->lock);
+        for (int i = 0; i < 3; ++i) free(w->buf[i].ids);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+void searchWorkerStop(SearchWorker* w) {
+    if (!w) return;
+    platformMutexLock(&w->lock);
+    w->stop = true;
+    atomic_fetch_add(&w->submitted, 1);     // cancels a running query
+    platformCondSignal(&w->wake);
+    platformMutexUnlock(&w->lock);
+    platformThreadJoin(w->thread);
+    platformCondDestroy(&w->wake);
+    platformMutexDestroy(&w->lock);
+    for (int i = 0; i < 3; ++i) free(w->buf[i].ids);
+    free(w);
+}
+
+uint64_t searchSubmit(SearchWorker* w, const char* query) {
+    if (!w) return 0;
+    platformMutexLock(&w->lock);
+    snprintf(w->pending, sizeof(w->pending), "%s", query ? query : "");
+    uint64_t seq = atomic_fetch_add(&w->submitted, 1) + 1;
+    platformCondSignal(&w->wake);
+    platformMutexUnlock(&w->lock);
+    return seq;
+}
+
+void searchSetWeights(SearchWorker* w, const SymbolWeight* weights, int count) {
+    if (!w) return;
+    if (count > SEARCH_WEIGHTS_MAX) count = SEARCH_WEIGHTS_MAX;
+    platformMutexLock(&w->lock);
+    w->weightCount = (weights && count > 0) ? count : 0;
+    if (w->weightCount) memcpy(w->weights, weights, (size_t)w->weightCount * sizeof(SymbolWeight));
+    atomic_fetch_add(&w->submitted, 1);     // the pending query again, reranked
+    platformCondSignal(&w->wake);
+    platformMutexUnlock(&w->lock);
+}
+
+const SearchResults* searchLatest(SearchWorker* w) {
+    if (!w) return NULL;
+    if (atomic_load_explicit(&w->ready, memory_order_acquire) & READY_FRESH) {
+        unsigned old = atomic_exchange_explicit(&w->ready, (unsigned)w->front, memory_order_acq_rel);
+        w->front = (int)(old & 3u);
+    }
+    return w->buf[w->front].seq ? &w->buf[w->front] : NULL;
+}
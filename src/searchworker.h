@@ -0,0 +1,53 @@
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "symbolindex.h"
+
+// Symbol search off the UI thread.
+// Every edit of the query is submitted; one worker thread runs the newest
+// against the index and drops any query a newer submission has overtaken,
+// mid-run if need be. Only the best SEARCH_RESULTS_MAX are kept, so the
+// index can stop early and skip the fuzzy pass once exact hits fill them. A
+// query that extends the last completed one narrows those results, when
+// they held every match, instead of asking the index again. Results rank with the
+// weights last set (held positions), which are copied in under the same lock.
+// Results travel through a triple buffer: the worker fills its own buffer and
+// swaps it into a shared 'ready' slot with one atomic exchange, the UI swaps
+// the ready slot with the buffer it is reading. Neither side ever waits on the
+// other, and a buffer the UI holds is never written.
+
+#define SEARCH_QUERY_MAX 256
+#define SEARCH_RESULTS_MAX 64           // ten screens of the results list; ranking more costs every keystroke
+#define SEARCH_WEIGHTS_MAX 64
+
+typedef struct {
+    uint64_t  seq;                      // submission these answer
+    char      query[SEARCH_QUERY_MAX];
+    int       count, total;             // results held (at most SEARCH_RESULTS_MAX), entries matching
+    uint32_t* ids;                      // entry ids, best first
+} SearchResults;
+
+typedef struct SearchWorker SearchWorker;
+
+// Start the worker over 'ix' (which must outlive it). NULL if out of memory
+// or the thread could not start.
+SearchWorker* searchWorkerStart(const SymbolIndex* ix);
+
+// Abandon any query and join the worker.
+void searchWorkerStop(SearchWorker* w);
+
+// Queue 'query', overtaking whatever is pending or running. Returns its
+// sequence number (0 if w is NULL). Never blocks on a running query.
+uint64_t searchSubmit(SearchWorker* w, const char* query);
+
+// Rank by these weights (at most SEARCH_WEIGHTS_MAX, each id once) from now
+// on, and run the current query again with them.
+void searchSetWeights(SearchWorker* w, const SymbolWeight* weights, int count);
+
+// Newest completed results. The pointer stays valid and unchanged until the
+// next call; NULL before the first query completes.
+const SearchResults* searchLatest(SearchWorker* w);
+
+#endif // SEARCHWORKER_H
@@ -0,0 +1,178 @@
+#include "snapshot.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char SNAPSHOT_MAGIC[8] = { 'P','F','S','N','A','P','0','1' };
+#define SNAPSHOT_HEADER_BYTES 24
+
+struct SnapshotWriter {
+    char*    path;
+    Journal* journal;
+    PlatformThread thread;
+    PlatformMutex  lock;
+    PlatformCond   wake;       // payload handed over or stop requested
+    PlatformCond   idle;       // a write finished
+
+    void*    payload;          // owned by the writer once submitted
+    size_t   size;
+    uint64_t seq;
+    bool     busy;             // a payload is queued or being written
+    bool     stop;
+};
+
+// FNV-1a over header and payload
+static uint64_t snapshotCheck(const unsigned char* p, size_t n) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001B3ULL; }
+    return h;
+}
+
+static bool writeSnapshotFile(const char* path, const void* payload, size_t size, uint64_t seq) {
+    unsigned char hdr[SNAPSHOT_HEADER_BYTES];
+    uint64_t len = size;
+    memcpy(hdr, SNAPSHOT_MAGIC, 8);
+    memcpy(hdr + 8, &seq, 8);
+    memcpy(hdr + 16, &len, 8);
+    uint64_t check = snapshotCheck(hdr, sizeof(hdr));
+    check ^= snapshotCheck((const unsigned char*)payload, size) * 31;
+
+    size_t plen = strlen(path);
+    char* tmpPath = (char*)malloc(plen + 5);
+    if (!tmpPath) return false;
+    memcpy(tmpPath, path, plen);
+    memcpy(tmpPath + plen, ".tmp", 5);
+
+    FILE* f = fopen(tmpPath, "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr)
+          && fwrite(payload, 1, size, f) == size
+          && fwrite(&check, 1, sizeof(check), f) == sizeof(check)
+          && platformFileSync(f);
+        ok = (fclose(f) == 0) && ok;
+    }
+    // Only a complete, synced file replaces the previous snapshot
+    if (ok) ok = platformReplaceFile(tmpPath, path);
+    if (!ok) remove(tmpPath);
+    free(tmpPath);
+    return ok;
+}
+
+static void snapshotMain(void* arg) {
+    SnapshotWriter* w = (SnapshotWriter*)arg;
+    platformMutexLock(&w->lock);
+    for (;;) {
+        while (!w->stop && !w->payload) platformCondWait(&w->wake, &w->lock);
+        if (!w->payload) break;          // stop requested, nothing queued
+
+        void* payload = w->payload;
+        size_t size = w->size;
+        uint64_t seq = w->seq;
+        w->payload = NULL;
+        platformMutexUnlock(&w->lock);
+
+        if (writeSnapshotFile(w->path, payload, size, seq)) journalCompact(w->journal, seq);
+        else fprintf(stderr, "Snapshot: failed to write %s\n", w->path);
+        free(payload);
+
+        platformMutexLock(&w->lock);
+        w->busy = false;
+        platformCondBroadcast(&w->idle);
+    }
+    platformMutexUnlock(&w->lock);
+}
+
+SnapshotWriter* snapshotWriterStart(const char* path, Journal* journal) {
+    SnapshotWriter* w = (SnapshotWriter*)calloc(1, sizeof(SnapshotWriter));
+    if (!w) return NULL;
+    size_t plen = strlen(path);
+    w->path = (char*)malloc(plen + 1);
+    if (!w->path) { free(w); return NULL; }
+    memcpy(w->path, path, plen + 1);
+    w->journal = journal;
+    platformMutexInit(&w->lock);
+    platformCondInit(&w->wake);
+    platformCondInit(&w->idle);
+    if (!platformThreadStart(&w->thread, snapshotMain, w)) {
+        platformCondDestroy(&w->wake);
+        platformCondDestroy(&w->idle);
+        platformMutexDestroy(&w->lock);
+        free(w->path); free(w);
+        return NULL;
+    }
+    return w;
+}
+
+bool snapshotSubmit(SnapshotWriter* w, void* payload, size_t size, uint64_t seq) {
+    if (!w) return false;
+    platformMutexLock(&w->lock);
+    bool accepted = !w->busy;
+    if (accepted) {
+        w->payload = payload;
+        w->size = size;
+        w->seq = seq;
+        w->busy = true;
+        platformCondSignal(&w->wake);
+    }
+    platformMutexUnlock(&w->lock);
+    return accepted;
+}
+
+void snapshotWait(SnapshotWriter* w) {
+    if (!w) return;
+    platformMutexLock(&w->lock);
+    while (w->busy) platformCondWait(&w->idle, &w->lock);
+    platformMutexUnlock(&w->lock);
+}
+
+void snapshotWriterStop(SnapshotWriter* w) {
+    if (!w) return;
+    platformMutexLock(&w->lock);
+    w->stop = true;
+    platformCondSignal(&w->wake);
+    platformMutexUnlock(&w->lock);
+    platformThreadJoin(w->thread);
+
+    platformCondDestroy(&w->wake);
+    platformCondDestroy(&w->idle);
+    platformMutexDestroy(&w->lock);
+    free(w->path);
+    free(w);
+}
+
+const void* snapshotMap(const char* path, size_t* size, uint64_t* seq) {
+    size_t fileSize;
+    const unsigned char* base = (const unsigned char*)platformMapFile(path, &fileSize);
+    if (!base) return NULL;
+
+    uint64_t len = 0, check = 0;
+    bool ok = fileSize >= SNAPSHOT_HEADER_BYTES + 8 && memcmp(base, SNAPSHOT_MAGIC, 8) == 0;
+    if (ok) {
+        memcpy(&len, base + 16, 8);
+        ok = len == fileSize - SNAPSHOT_HEADER_BYTES - 8;
+    }
+    if (ok) {
+        memcpy(&check, base + SNAPSHOT_HEADER_BYTES + len, 8);
+        uint64_t h = snapshotCheck(base, SNAPSHOT_HEADER_BYTES);
+        h ^= snapshotCheck(base + SNAPSHOT_HEADER_BYTES, (size_t)len) * 31;
+        ok = h == check;
+    }
+    if (!ok) {
+        fprintf(stderr, "Snapshot: %s is damaged, ignoring it\n", path);
+        platformUnmapFile(base, fileSize);
+        return NULL;
+    }
+    memcpy(seq, base + 8, 8);
+    *size = (size_t)len;
+    return base + SNAPSHOT_HEADER_BYTES;
+}
+
+void snapshotUnmap(const void* payload) {
+    if (!payload) return;
+    const unsigned char* base = (const unsigned char*)payload - SNAPSHOT_HEADER_BYTES;
+    uint64_t len;
+    memcpy(&len, base + 16, 8);
+    platformUnmapFile(base, (size_t)len + SNAPSHOT_HEADER_BYTES + 8);
+}
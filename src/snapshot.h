@@ -0,0 +1,41 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "journal.h"
+
+// Point-in-time state snapshots, paired with the journal as a write-ahead log.
+// The UI thread copies its state into a private buffer (cheap: tens of KB) and
+// hands it off; a background thread writes it to '<path>.tmp', fsyncs, renames
+// it over 'path' and then compacts the journal up to the snapshot's seq.
+// A crash at any point leaves either the old or the new snapshot intact, and
+// the journal still holds everything after whichever one survived.
+//
+// On disk: 24-byte header (magic, seq, payload length), the payload, 8-byte checksum.
+// The payload is opaque here; its layout belongs to the caller.
+
+typedef struct SnapshotWriter SnapshotWriter;
+
+// Start the writer thread. 'journal' (may be NULL) is compacted after each write.
+SnapshotWriter* snapshotWriterStart(const char* path, Journal* journal);
+
+// Hand a malloc'd payload to the writer, which frees it. 'seq' is the newest
+// journal record reflected in the payload. Returns false (and frees nothing)
+// if the previous snapshot is still being written.
+bool snapshotSubmit(SnapshotWriter* w, void* payload, size_t size, uint64_t seq);
+
+// Block until the previous snapshot, if any, is written, so the next submit
+// is accepted.
+void snapshotWait(SnapshotWriter* w);
+
+// Finish any snapshot in flight and stop the thread.
+void snapshotWriterStop(SnapshotWriter* w);
+
+// Map the snapshot at 'path' and verify it. Returns the payload (read-only,
+// valid until snapshotUnmap) or NULL if missing or damaged.
+const void* snapshotMap(const char* path, size_t* size, uint64_t* seq);
+void snapshotUnmap(const void* payload);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,145 @@
+#include "sortedview.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Repairs with at most N / SMALL_BATCH changes merge the changed items back in
+#define SMALL_BATCH      16
+// Insertion-pass moves allowed per item before giving up for a merge sort
+#define INSERTION_BUDGET 8
+
+struct SortedView {
+    int       count;
+    int64_t*  keys;
+    uint32_t* order;        // ids by (key, id)
+    uint32_t* rank;         // id -> position in order
+    uint32_t* tmp;          // scratch, count entries
+    uint32_t* changed;      // ids set since the last repair
+    int       changedCount;
+    uint8_t*  dirty;        // id is in 'changed'
+};
+
+SortedView* sortedViewCreate(int count) {
+    if (count < 0) return NULL;
+    SortedView* v = (SortedView*)calloc(1, sizeof(SortedView));
+    if (!v) return NULL;
+    size_t n = (size_t)count + 1;
+    v->count   = count;
+    v->keys    = (int64_t*)calloc(n, sizeof(int64_t));
+    v->order   = (uint32_t*)malloc(n * sizeof(uint32_t));
+    v->rank    = (uint32_t*)malloc(n * sizeof(uint32_t));
+    v->tmp     = (uint32_t*)malloc(n * sizeof(uint32_t));
+    v->changed = (uint32_t*)malloc(n * sizeof(uint32_t));
+    v->dirty   = (uint8_t*)calloc(n, 1);
+    if (!v->keys || !v->order || !v->rank || !v->tmp || !v->changed || !v->dirty) {
+        sortedViewFree(v);
+        return NULL;
+    }
+    for (int i = 0; i < count; ++i) v->order[i] = v->rank[i] = (uint32_t)i;
+    return v;
+}
+
+void sortedViewFree(SortedView* v) {
+    if (!v) return;
+    free(v->keys); free(v->order); free(v->rank);
+    free(v->tmp); free(v->changed); free(v->dirty);
+    free(v);
+}
+
+static inline bool less(const int64_t* keys, uint32_t a, uint32_t b) {
+    return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+}
+
+// Bottom-up merge sort of ids[0..n) by (key, id), using tmp
+static void mergeSort(const int64_t* keys, uint32_t* ids, uint32_t* tmp, int n) {
+    uint32_t* src = ids;
+    uint32_t* dst = tmp;
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = (lo + width < n) ? lo + width : n;
+            int hi  = (lo + 2 * width < n) ? lo + 2 * width : n;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) dst[k++] = less(keys, src[j], src[i]) ? src[j++] : src[i++];
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi)  dst[k++] = src[j++];
+        }
+        uint32_t* t = src; src = dst; dst = t;
+    }
+    if (src != ids) memcpy(ids, src, (size_t)n * sizeof(uint32_t));
+}
+
+static void rebuildRanks(SortedView* v) {
+    for (int i = 0; i < v->count; ++i) v->rank[v->order[i]] = (uint32_t)i;
+}
+
+static void clearChanged(SortedView* v) {
+    for (int i = 0; i < v->changedCount; ++i) v->dirty[v->changed[i]] = 0;
+    v->changedCount = 0;
+}
+
+void sortedViewReset(SortedView* v, const int64_t* keys) {
+    memcpy(v->keys, keys, (size_t)v->count * sizeof(int64_t));
+    mergeSort(v->keys, v->order, v->tmp, v->count);
+    rebuildRanks(v);
+    clearChanged(v);
+}
+
+void sortedViewSet(SortedView* v, uint32_t id, int64_t key) {
+    if (v->keys[id] == key) return;
+    v->keys[id] = key;
+    if (!v->dirty[id]) {
+        v->dirty[id] = 1;
+        v->changed[v->changedCount++] = id;
+    }
+}
+
+// Few changes: the untouched items are still in order, so drop the changed
+// ones, sort those alone and merge the two runs
+static void mergeChanged(SortedView* v) {
+    int n = v->count, k = v->changedCount, kept = 0;
+    for (int i = 0; i < n; ++i)
+        if (!v->dirty[v->order[i]]) v->order[kept++] = v->order[i];
+    uint32_t* moved = v->changed;
+    mergeSort(v->keys, moved, v->tmp, k);
+
+    // Merge from the back so the kept run can share the order array
+    int i = kept - 1, j = k - 1, out = n - 1;
+    while (j >= 0) {
+        if (i >= 0 && less(v->keys, moved[j], v->order[i])) v->order[out--] = v->order[i--];
+        else                                                v->order[out--] = moved[j--];
+    }
+}
+
+// Many changes, probably small: insertion sort, bailing out to a merge sort
+// when the keys moved too far for that to pay
+static void insertionRepair(SortedView* v) {
+    int n = v->count;
+    long long budget = (long long)INSERTION_BUDGET * n;
+    for (int i = 1; i < n; ++i) {
+        uint32_t x = v->order[i];
+        int j = i;
+        while (j > 0 && less(v->keys, x, v->order[j - 1])) { v->order[j] = v->order[j - 1]; --j; }
+        v->order[j] = x;
+        budget -= i - j;
+        if (budget < 0) { mergeSort(v->keys, v->order, v->tmp, n); return; }
+    }
+}
+
+void sortedViewRepair(SortedView* v) {
+    if (v->changedCount == 0) return;
+    if ((long long)v->changedCount * SMALL_BATCH <= v->count) mergeChanged(v);
+    else                                                      insertionRepair(v);
+    rebuildRanks(v);
+    clearChanged(v);
+}
+
+int sortedViewCount(const SortedView* v) {
+    return v->count;
+}
+
+const uint32_t* sortedViewOrder(const SortedView* v) {
+    return v->order;
+}
+
+int sortedViewRank(const SortedView* v, uint32_t id) {
+    return (int)v->rank[id];
+}
@@ -0,0 +1,41 @@
+#ifndef SORTEDVIEW_H
+#define SORTEDVIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Order of a fixed set of items by an int64 key, kept sorted as keys change.
+// Callers record new keys with sortedViewSet, which only notes what changed,
+// and call sortedViewRepair once per batch of ticks:
+//  - a batch touching few items lifts them out, sorts just those and merges
+//    them back: O(N + k log k) for k changes;
+//  - a larger batch gets an insertion-sort pass over the whole order, which
+//    costs the number of inversions, small when keys only drifted, and falls
+//    back to a merge sort once it spends a few N moves, so no batch costs
+//    more than O(N log N).
+// Ties break by id, so the order is total and stable from batch to batch.
+
+typedef struct SortedView SortedView;
+
+// View over ids 0..count-1, all keys 0. NULL if out of memory.
+SortedView* sortedViewCreate(int count);
+void sortedViewFree(SortedView* v);
+
+// Replace every key and sort from scratch (e.g. a new sort column).
+void sortedViewReset(SortedView* v, const int64_t* keys);
+
+// New key for one item; takes effect at the next repair.
+void sortedViewSet(SortedView* v, uint32_t id, int64_t key);
+
+// Restore the order after a batch of sortedViewSet calls.
+void sortedViewRepair(SortedView* v);
+
+int sortedViewCount(const SortedView* v);
+
+// Ids by ascending key, valid until the next repair or reset.
+const uint32_t* sortedViewOrder(const SortedView* v);
+
+// Position of an id in the order (as of the last repair).
+int sortedViewRank(const SortedView* v, uint32_t id);
+
+#endif // SORTEDVIEW_H
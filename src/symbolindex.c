@@ -0,0 +1,958 @@
+#include "symbolindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GRAM_KEYS   (1u << 18)        // three 6-bit character codes
+#define SHORT_KEYS  (64 + 4096)       // one code, then two
+#define QUERY_MAX   64
+#define CANCEL_EVERY 4096             // entries between cancellation polls
+
+typedef struct {
+    uint32_t firstChild;              // children are contiguous in 'nodes'
+    uint32_t lo, hi;                  // range of bySymbol below this node
+    uint16_t childCount;
+    uint8_t  c;                       // folded character leading here
+} TrieNode;
+
+// Which character codes and (hashed) adjacent pairs occur in a text
+typedef struct { uint64_t chars, pairs; } TextSketch;
+
+struct SymbolIndex {
+    int          count;
+    const char** symbol;
+    const char** name;                // entries may be NULL
+    uint32_t*    bySymbol;            // ids by folded symbol
+    uint32_t*    symRank;             // position of each id in bySymbol
+    uint32_t*    byName;              // ids with a name, by folded name
+    uint32_t*    nameRank;            // position of each id in byName, UINT32_MAX if unnamed
+    int          namedCount;
+    TrieNode*    nodes;
+    uint32_t     nodeCount, nodeCap;
+    uint32_t*    gramStart;           // GRAM_KEYS + 1 offsets into gramIds
+    uint32_t*    gramIds;             // ascending ids per trigram
+    uint32_t*    rankStart;           // GRAM_KEYS + 1 offsets into rankIds
+    uint32_t*    rankIds;             // per trigram, ids by rank class of its occurrences, symbol length
+    uint8_t*     rankClass;           // ... and that class
+    TextSketch*  sketch;              // per id: symbol, then name
+    uint32_t*    shortCount;          // entries holding each code / code pair
+};
+
+static inline unsigned char fold(unsigned char c) { return (c >= 'a' && c <= 'z') ? (unsigned char)(c - 32) : c; }
+
+static int foldCmp(const char* a, const char* b) {
+    for (;; ++a, ++b) {
+        unsigned char x = fold((unsigned char)*a), y = fold((unsigned char)*b);
+        if (x != y || !x) return (int)x - (int)y;
+    }
+}
+
+// Folded 'fq' (qlen chars) is a prefix of s
+static bool hasPrefix(const char* s, const char* fq, int qlen) {
+    for (int k = 0; k < qlen; ++k)
+        if (fold((unsigned char)s[k]) != (unsigned char)fq[k]) return false;
+    return true;
+}
+
+static inline bool isWordStart(const char* s, size_t i) {
+    return i == 0 || s[i - 1] == ' ' || s[i - 1] == '.' || s[i - 1] == '-';
+}
+
+// Best occurrence of fq in s: a word start if there is one, else the first.
+// Returns the position, -1 if none; *wordStart tells which.
+static int findFolded(const char* s, const char* fq, int qlen, bool* wordStart) {
+    int first = -1;
+    for (int i = 0; s[i]; ++i) {
+        if (fold((unsigned char)s[i]) != (unsigned char)fq[0] || !hasPrefix(s + i, fq, qlen)) continue;
+        if (isWordStart(s, (size_t)i)) { *wordStart = true; return i; }
+        if (first < 0) first = i;
+    }
+    *wordStart = false;
+    return first;
+}
+
+// ---- sorting ids by a string column ----
+static void sortIds(uint32_t* ids, uint32_t* tmp, int n, const char** col) {
+    if (n < 2) return;
+    if (n <= 16) {
+        for (int i = 1; i < n; ++i) {
+            uint32_t v = ids[i];
+            int j = i - 1;
+            while (j >= 0 && foldCmp(col[ids[j]], col[v]) > 0) { ids[j + 1] = ids[j]; j--; }
+            ids[j + 1] = v;
+        }
+        return;
+    }
+    int h = n / 2;
+    sortIds(ids, tmp, h, col);
+    sortIds(ids + h, tmp, n - h, col);
+    int i = 0, j = h, k = 0;
+    while (i < h && j < n) tmp[k++] = (foldCmp(col[ids[j]], col[ids[i]]) < 0) ? ids[j++] : ids[i++];
+    while (i < h) tmp[k++] = ids[i++];
+    memcpy(ids, tmp, (size_t)k * sizeof(uint32_t));
+}
+
+// ---- trie ----
+static bool reserveNodes(SymbolIndex* ix, uint32_t n) {
+    if (ix->nodeCount + n <= ix->nodeCap) return true;
+    uint32_t cap = ix->nodeCap ? ix->nodeCap : 1024;
+    while (cap < ix->nodeCount + n) cap *= 2;
+    TrieNode* nn = (TrieNode*)realloc(ix->nodes, (size_t)cap * sizeof(TrieNode));
+    if (!nn) return false;
+    ix->nodes = nn;
+    ix->nodeCap = cap;
+    return true;
+}
+
+// Children of node 'at', whose symbols share their first 'depth' characters.
+static bool buildChildren(SymbolIndex* ix, uint32_t at, int depth) {
+    uint32_t lo = ix->nodes[at].lo, hi = ix->nodes[at].hi;
+    while (lo < hi && ix->symbol[ix->bySymbol[lo]][depth] == '\0') lo++;   // ends here, sorts first
+    uint32_t groups = 0;
+    for (uint32_t k = lo; k < hi; ++k)
+        if (k == lo || fold((unsigned char)ix->symbol[ix->bySymbol[k]][depth]) !=
+                       fold((unsigned char)ix->symbol[ix->bySymbol[k - 1]][depth])) groups++;
+    if (groups == 0) return true;
+    if (!reserveNodes(ix, groups)) return false;
+
+    uint32_t first = ix->nodeCount;
+    ix->nodeCount += groups;
+    ix->nodes[at].firstChild = first;
+    ix->nodes[at].childCount = (uint16_t)groups;
+    uint32_t g = first;
+    for (uint32_t k = lo; k < hi; ) {
+        unsigned char c = fold((unsigned char)ix->symbol[ix->bySymbol[k]][depth]);
+        uint32_t end = k + 1;
+        while (end < hi && fold((unsigned char)ix->symbol[ix->bySymbol[end]][depth]) == c) end++;
+        ix->nodes[g] = (TrieNode){ 0, k, end, 0, c };
+        g++;
+        k = end;
+    }
+    for (uint32_t n = first; n < first + groups; ++n)
+        if (!buildChildren(ix, n, depth + 1)) return false;
+    return true;
+}
+
+// Range of bySymbol whose symbols start with the folded query.
+static void triePrefix(const SymbolIndex* ix, const char* fq, int qlen, uint32_t* lo, uint32_t* hi) {
+    uint32_t at = 0;
+    for (int k = 0; k < qlen; ++k) {
+        const TrieNode* n = &ix->nodes[at];
+        uint32_t next = 0;
+        for (uint32_t c = n->firstChild; c < n->firstChild + n->childCount; ++c)
+            if (ix->nodes[c].c == (unsigned char)fq[k]) { next = c; break; }
+        if (!next) { *lo = *hi = 0; return; }
+        at = next;
+    }
+    *lo = ix->nodes[at].lo;
+    *hi = ix->nodes[at].hi;
+}
+
+// ---- trigrams ----
+static int cmpU64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static inline uint32_t gramCode(unsigned char c) {
+    c = fold(c);
+    if (c >= 'A' && c <= 'Z') return (uint32_t)(c - 'A') + 1;
+    if (c >= '0' && c <= '9') return (uint32_t)(c - '0') + 27;
+    return 37 + c % 27;               // the rest share codes; hits are verified anyway
+}
+
+static inline uint32_t gramKey(const char* s) {
+    return gramCode((unsigned char)s[0]) << 12 | gramCode((unsigned char)s[1]) << 6 | gramCode((unsigned char)s[2]);
+}
+
+// Count (fill == NULL) or emit the distinct trigrams of entry id
+static void entryGrams(SymbolIndex* ix, uint32_t id, uint32_t* last, uint32_t* fill) {
+    const char* texts[2] = { ix->symbol[id], ix->name[id] };
+    for (int t = 0; t < 2; ++t) {
+        const char* s = texts[t];
+        if (!s) continue;
+        for (size_t i = 0; s[i] && s[i + 1] && s[i + 2]; ++i) {
+            uint32_t key = gramKey(s + i);
+            if (last[key] == id) continue;
+            last[key] = id;
+            if (fill) ix->gramIds[fill[key]++] = id;
+            else      ix->gramStart[key + 1]++;
+        }
+    }
+}
+
+static bool buildGrams(SymbolIndex* ix) {
+    ix->gramStart = (uint32_t*)calloc(GRAM_KEYS + 1, sizeof(uint32_t));
+    uint32_t* last = (uint32_t*)malloc(GRAM_KEYS * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)malloc(GRAM_KEYS * sizeof(uint32_t));
+    bool ok = ix->gramStart && last && fill;
+    if (ok) {
+        memset(last, 0xFF, GRAM_KEYS * sizeof(uint32_t));
+        for (int id = 0; id < ix->count; ++id) entryGrams(ix, (uint32_t)id, last, NULL);
+        for (uint32_t k = 0; k < GRAM_KEYS; ++k) ix->gramStart[k + 1] += ix->gramStart[k];
+        ix->gramIds = (uint32_t*)malloc((size_t)ix->gramStart[GRAM_KEYS] * sizeof(uint32_t) + 1);
+        ok = ix->gramIds != NULL;
+    }
+    if (ok) {
+        memset(last, 0xFF, GRAM_KEYS * sizeof(uint32_t));
+        memcpy(fill, ix->gramStart, GRAM_KEYS * sizeof(uint32_t));
+        for (int id = 0; id < ix->count; ++id) entryGrams(ix, (uint32_t)id, last, fill);
+    }
+    free(last);
+    free(fill);
+    return ok;
+}
+
+// Rank class of a substring hit of the given tier (2..5, see rankKey) and
+// start: one ordered byte, so posting lists can be walked best class first.
+// Starts from 63 on share a class.
+static inline uint32_t rankClassOf(uint32_t tier, size_t pos) {
+    if (pos > 63) pos = 63;
+    return (tier == 2) ? 0 : 1 + (tier - 3) * 64 + (uint32_t)pos;
+}
+
+// Adds (trigram << 8 | rank class) to buf[0..n) unless there; only starts
+// from 63 on share a class, so only those can repeat
+static inline int addClass(uint32_t* buf, int n, uint32_t v, size_t pos) {
+    for (int k = n - 1; pos >= 63 && k >= 0; --k)
+        if (buf[k] == v) return n;
+    buf[n] = v;
+    return n + 1;
+}
+
+// The distinct (trigram << 8 | rank class) of entry id's trigram
+// occurrences, as the tier and start a query beginning there would get,
+// into buf; returns how many.
+static int entryClasses(const SymbolIndex* ix, uint32_t id, uint32_t* buf) {
+    int n = 0;
+    const char* sym = ix->symbol[id];
+    const char* name = ix->name[id];
+    for (size_t i = 0; sym[i] && sym[i + 1] && sym[i + 2]; ++i)
+        n = addClass(buf, n, gramKey(sym + i) << 8 | rankClassOf(3, i), i);
+    for (size_t i = 0; name && name[i] && name[i + 1] && name[i + 2]; ++i)
+        n = addClass(buf, n, gramKey(name + i) << 8 | rankClassOf(i == 0 ? 2 : isWordStart(name, i) ? 4 : 5, i), i);
+    return n;
+}
+
+// Posting lists again, each ordered as rankKey orders hits: by rank class,
+// symbol length, then id. An entry is listed once per class its occurrences
+// of the trigram fall in. Entries are emitted by symbol length, then each
+// list is counting-sorted by class, which keeps that order.
+static bool buildRanked(SymbolIndex* ix) {
+    size_t longest = 0, n = (size_t)ix->count + 1;
+    uint32_t lenStart[257] = { 0 };
+    for (int id = 0; id < ix->count; ++id) {
+        size_t symLen = strlen(ix->symbol[id]), len = symLen + (ix->name[id] ? strlen(ix->name[id]) : 0);
+        if (len > longest) longest = len;
+        lenStart[(symLen > 0xFF ? 0xFF : symLen) + 1]++;
+    }
+    for (int k = 0; k < 256; ++k) lenStart[k + 1] += lenStart[k];
+    ix->rankStart = (uint32_t*)calloc(GRAM_KEYS + 1, sizeof(uint32_t));
+    uint32_t* buf = (uint32_t*)malloc((longest + 1) * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)malloc(GRAM_KEYS * sizeof(uint32_t));
+    uint32_t* order = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* ids = NULL;
+    uint8_t* classes = NULL;
+    bool ok = ix->rankStart && buf && fill && order;
+    if (ok) {
+        for (int id = 0; id < ix->count; ++id) {
+            size_t symLen = strlen(ix->symbol[id]);
+            order[lenStart[symLen > 0xFF ? 0xFF : symLen]++] = (uint32_t)id;
+            int m = entryClasses(ix, (uint32_t)id, buf);
+            for (int k = 0; k < m; ++k) ix->rankStart[(buf[k] >> 8) + 1]++;
+        }
+        for (uint32_t k = 0; k < GRAM_KEYS; ++k) ix->rankStart[k + 1] += ix->rankStart[k];
+        size_t total = ix->rankStart[GRAM_KEYS];
+        ix->rankIds = (uint32_t*)malloc(total * sizeof(uint32_t) + 1);
+        ix->rankClass = (uint8_t*)malloc(total + 1);
+        ids = (uint32_t*)malloc(total * sizeof(uint32_t) + 1);
+        classes = (uint8_t*)malloc(total + 1);
+        ok = ix->rankIds && ix->rankClass && ids && classes;
+    }
+    if (ok) {
+        memcpy(fill, ix->rankStart, GRAM_KEYS * sizeof(uint32_t));
+        for (int o = 0; o < ix->count; ++o) {
+            int m = entryClasses(ix, order[o], buf);
+            for (int k = 0; k < m; ++k) {
+                uint32_t at = fill[buf[k] >> 8]++;
+                ids[at] = order[o];
+                classes[at] = (uint8_t)buf[k];
+            }
+        }
+        for (uint32_t k = 0; k < GRAM_KEYS; ++k) {
+            uint32_t lo = ix->rankStart[k], hi = ix->rankStart[k + 1], at[257];
+            if (lo == hi) continue;
+            memset(at, 0, sizeof(at));
+            for (uint32_t p = lo; p < hi; ++p) at[classes[p] + 1]++;
+            for (int c = 0; c < 256; ++c) at[c + 1] += at[c];
+            for (uint32_t p = lo; p < hi; ++p) {
+                uint32_t to = lo + at[classes[p]]++;
+                ix->rankIds[to] = ids[p];
+                ix->rankClass[to] = classes[p];
+            }
+        }
+    }
+    free(buf);
+    free(fill);
+    free(order);
+    free(ids);
+    free(classes);
+    return ok;
+}
+
+static inline uint32_t pairCode(uint32_t a, uint32_t b) { return (a * 37 + b) & 63; }
+
+static TextSketch sketchOf(const char* s) {
+    TextSketch k = { 0, 0 };
+    uint32_t prev = 0;
+    for (int i = 0; s && s[i]; ++i) {
+        uint32_t c = gramCode((unsigned char)s[i]);
+        k.chars |= 1ULL << c;
+        if (i) k.pairs |= 1ULL << pairCode(prev, c);
+        prev = c;
+    }
+    return k;
+}
+
+static inline uint32_t shortKey(const char* s, int len) {
+    return (len == 1) ? gramCode((unsigned char)s[0])
+                      : 64 + (gramCode((unsigned char)s[0]) << 6 | gramCode((unsigned char)s[1]));
+}
+
+// Sketches, and how many entries hold each one- and two-character window
+static bool buildSketches(SymbolIndex* ix) {
+    ix->sketch = (TextSketch*)malloc(((size_t)ix->count * 2 + 1) * sizeof(TextSketch));
+    ix->shortCount = (uint32_t*)calloc(SHORT_KEYS, sizeof(uint32_t));
+    uint32_t* last = (uint32_t*)malloc(SHORT_KEYS * sizeof(uint32_t));
+    bool ok = ix->sketch && ix->shortCount && last;
+    if (ok) {
+        memset(last, 0xFF, SHORT_KEYS * sizeof(uint32_t));
+        for (int id = 0; id < ix->count; ++id) {
+            ix->sketch[2 * id]     = sketchOf(ix->symbol[id]);
+            ix->sketch[2 * id + 1] = sketchOf(ix->name[id]);
+            const char* texts[2] = { ix->symbol[id], ix->name[id] };
+            for (int t = 0; t < 2; ++t)
+                for (int i = 0; texts[t] && texts[t][i]; ++i)
+                    for (int len = 1; len <= 2 && (len == 1 || texts[t][i + 1]); ++len) {
+                        uint32_t key = shortKey(texts[t] + i, len);
+                        if (last[key] != (uint32_t)id) { last[key] = (uint32_t)id; ix->shortCount[key]++; }
+                    }
+        }
+    }
+    free(last);
+    return ok;
+}
+
+// ---- build ----
+SymbolIndex* symbolIndexBuild(const char* const* symbols, const char* const* names, int count) {
+    if (count < 0 || count > SYMBOL_INDEX_MAX) return NULL;
+    SymbolIndex* ix = (SymbolIndex*)calloc(1, sizeof(SymbolIndex));
+    if (!ix) return NULL;
+    size_t n = (size_t)count + 1;
+    ix->count    = count;
+    ix->symbol   = (const char**)malloc(n * sizeof(char*));
+    ix->name     = (const char**)calloc(n, sizeof(char*));
+    ix->bySymbol = (uint32_t*)malloc(n * sizeof(uint32_t));
+    ix->symRank  = (uint32_t*)malloc(n * sizeof(uint32_t));
+    ix->byName   = (uint32_t*)malloc(n * sizeof(uint32_t));
+    ix->nameRank = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* tmp = (uint32_t*)malloc(n * sizeof(uint32_t));
+    bool ok = ix->symbol && ix->name && ix->bySymbol && ix->symRank && ix->byName && ix->nameRank && tmp;
+    if (ok) {
+        for (int i = 0; i < count; ++i) {
+            ix->symbol[i] = symbols[i] ? symbols[i] : "";
+            ix->name[i]   = names ? names[i] : NULL;
+            ix->bySymbol[i] = (uint32_t)i;
+            ix->nameRank[i] = UINT32_MAX;
+            if (ix->name[i]) ix->byName[ix->namedCount++] = (uint32_t)i;
+        }
+        sortIds(ix->bySymbol, tmp, count, ix->symbol);
+        sortIds(ix->byName, tmp, ix->namedCount, ix->name);
+        for (int k = 0; k < count; ++k) ix->symRank[ix->bySymbol[k]] = (uint32_t)k;
+        for (int k = 0; k < ix->namedCount; ++k) ix->nameRank[ix->byName[k]] = (uint32_t)k;
+        ok = reserveNodes(ix, 1);
+    }
+    free(tmp);
+    if (ok) {
+        ix->nodes[0] = (TrieNode){ 0, 0, (uint32_t)count, 0, 0 };
+        ix->nodeCount = 1;
+        ok = buildChildren(ix, 0, 0) && buildGrams(ix) && buildRanked(ix) && buildSketches(ix);
+    }
+    if (!ok) { symbolIndexFree(ix); return NULL; }
+    return ix;
+}
+
+void symbolIndexFree(SymbolIndex* ix) {
+    if (!ix) return;
+    free(ix->symbol); free(ix->name);
+    free(ix->bySymbol); free(ix->symRank); free(ix->byName); free(ix->nameRank);
+    free(ix->nodes);
+    free(ix->gramStart); free(ix->gramIds);
+    free(ix->rankStart); free(ix->rankIds); free(ix->rankClass);
+    free(ix->sketch);
+    free(ix->shortCount);
+    free(ix);
+}
+
+int symbolIndexCount(const SymbolIndex* ix) {
+    return ix ? ix->count : 0;
+}
+
+// ---- query ----
+static inline bool cancelled(const SymbolCancel* c, uint32_t step) {
+    return c && (step & (CANCEL_EVERY - 1)) == 0 && c->fn(c->user);
+}
+
+// Bounded max-heap of the 'cap' best rank keys seen (smaller is better),
+// and the weights those keys are ranked with
+typedef struct {
+    uint64_t* keys;
+    int len, cap;
+    const SymbolWeight* weights;
+    int weightCount;
+} TopK;
+
+static void topkPush(TopK* t, uint64_t key) {
+    uint64_t* h = t->keys;
+    if (t->len < t->cap) {
+        int i = t->len++;
+        while (i > 0 && h[(i - 1) / 2] < key) { h[i] = h[(i - 1) / 2]; i = (i - 1) / 2; }
+        h[i] = key;
+        return;
+    }
+    if (t->cap == 0 || key >= h[0]) return;
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= t->len) break;
+        if (c + 1 < t->len && h[c + 1] > h[c]) c++;
+        if (h[c] <= key) break;
+        h[i] = h[c];
+        i = c;
+    }
+    h[i] = key;
+}
+
+// Lightness of entry id: the bit length of its weight counted down from
+// LIGHT_NONE, so heavier entries get smaller keys; LIGHT_NONE without one
+#define LIGHT_NONE 63u
+
+static uint64_t lightOf(const SymbolWeight* weights, int count, uint32_t id) {
+    for (int k = 0; k < count; ++k)
+        if (weights[k].id == id && weights[k].weight)
+            return LIGHT_NONE - (uint64_t)(32 - __builtin_clz(weights[k].weight));
+    return LIGHT_NONE;
+}
+
+// Symbol prefix: exact symbol | lightness | place in the trie | id, below
+// every rankKey tier
+static inline uint64_t prefixKey(const SymbolIndex* ix, const TopK* t, uint32_t id, bool exact) {
+    return (uint64_t)!exact << 60 | lightOf(t->weights, t->weightCount, id) << 54 |
+           (uint64_t)ix->symRank[id] << 32 | id;
+}
+
+// tier | position | lightness | symbol length | id: smaller ranks higher
+static inline uint64_t rankKey(uint64_t tier, uint64_t pos, uint64_t light, size_t symLen, uint32_t id) {
+    if (pos > 0xFFF) pos = 0xFFF;
+    if (symLen > 0xFF) symLen = 0xFF;
+    return tier << 60 | pos << 48 | light << 42 | (uint64_t)symLen << 34 | id;
+}
+
+// Best key an unweighted entry id can have as a substring hit of rank class
+// c, and the class of a key
+static inline uint64_t classFloor(uint32_t c, size_t symLen, uint32_t id) {
+    return (c == 0) ? rankKey(2, 0, LIGHT_NONE, symLen, id)
+                    : rankKey(3 + (c - 1) / 64, (c - 1) % 64, LIGHT_NONE, symLen, id);
+}
+
+static inline uint32_t keyClass(uint64_t key) {
+    return rankClassOf((uint32_t)(key >> 60), (size_t)(key >> 48 & 0xFFF));
+}
+
+// Rank of an entry that is not a symbol-prefix match; false if it does not match.
+static bool rankEntry(const SymbolIndex* ix, const TopK* t, uint32_t id, const char* fq, int qlen, uint64_t* key) {
+    const char* sym = ix->symbol[id];
+    const char* name = ix->name[id];
+    size_t symLen = strlen(sym);
+    uint64_t light = lightOf(t->weights, t->weightCount, id);
+    if (name && hasPrefix(name, fq, qlen)) { *key = rankKey(2, 0, light, symLen, id); return true; }
+    bool ws;
+    int at = findFolded(sym, fq, qlen, &ws);
+    if (at >= 0) { *key = rankKey(3, (uint64_t)at, light, symLen, id); return true; }
+    if (name && (at = findFolded(name, fq, qlen, &ws)) >= 0) {
+        *key = rankKey(ws ? 4 : 5, (uint64_t)at, light, symLen, id);
+        return true;
+    }
+    return false;
+}
+
+// First position in byName whose folded name is not below the folded prefix
+static int nameLowerBound(const SymbolIndex* ix, const char* fq, int qlen) {
+    int lo = 0, hi = ix->namedCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const char* s = ix->name[ix->byName[mid]];
+        int c = 0;
+        for (int k = 0; k < qlen && !c; ++k) {
+            unsigned char x = fold((unsigned char)s[k]);
+            c = (int)x - (int)(unsigned char)fq[k];
+            if (!x) break;
+        }
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Whether a text with sketch k can hold the (short) query with sketch q
+static inline bool sketchHolds(const TextSketch* k, const TextSketch* q) {
+    return (k->chars & q->chars) == q->chars && (k->pairs & q->pairs) == q->pairs;
+}
+
+// Letters and digits have character codes of their own, so for such a query
+// a window count or posting list is exact, with nothing to verify
+static bool codesExact(const char* fq, int qlen) {
+    for (int k = 0; k < qlen; ++k)
+        if (gramCode((unsigned char)fq[k]) >= 37) return false;
+    return true;
+}
+
+// Whether t still takes substring hits, or name prefixes already fill it
+static inline bool takesSubstrings(const TopK* t) {
+    return t->len < t->cap || (t->cap > 0 && t->keys[0] > rankKey(3, 0, 0, 0, 0));
+}
+
+// Name prefixes that are not symbol prefixes [symLo, symHi), ranked into t
+// from the sorted names; *nameLo, *nameHi receive their range of byName.
+// Returns matches, -1 if cancelled.
+static int namePrefixes(const SymbolIndex* ix, const char* fq, int qlen, uint32_t symLo, uint32_t symHi,
+                        TopK* t, uint32_t* nameLo, uint32_t* nameHi, const SymbolCancel* cancel) {
+    int matches = 0;
+    uint32_t k = (uint32_t)nameLowerBound(ix, fq, qlen);
+    *nameLo = k;
+    for (; k < (uint32_t)ix->namedCount; ++k) {
+        if (cancelled(cancel, k - *nameLo + 1)) return -1;
+        uint32_t id = ix->byName[k];
+        if (!hasPrefix(ix->name[id], fq, qlen)) break;
+        if (ix->symRank[id] >= symLo && ix->symRank[id] < symHi) continue;
+        topkPush(t, rankKey(2, 0, lightOf(t->weights, t->weightCount, id), strlen(ix->symbol[id]), id));
+        matches++;
+    }
+    *nameHi = k;
+    return matches;
+}
+
+// Queries too short for trigrams, past the symbol prefixes [symLo, symHi):
+// name prefixes first. If those fill the results of an exact query, the rest
+// is counted straight from shortCount; otherwise every entry whose sketches
+// can hold the query is verified and ranked. Returns matches, -1 if cancelled.
+static int shortMatches(const SymbolIndex* ix, const char* fq, int qlen, uint32_t symLo, uint32_t symHi,
+                        TopK* t, const SymbolCancel* cancel) {
+    bool exact = codesExact(fq, qlen);
+    int counted = (int)(ix->shortCount[shortKey(fq, qlen)] - (symHi - symLo));
+    if (exact && t->cap == 0) return counted;
+
+    uint32_t nameLo, nameHi;
+    int matches = namePrefixes(ix, fq, qlen, symLo, symHi, t, &nameLo, &nameHi, cancel);
+    if (matches < 0) return -1;
+    if (exact && !takesSubstrings(t)) return counted;
+
+    TextSketch q = sketchOf(fq);
+    for (uint32_t id = 0; id < (uint32_t)ix->count; ++id) {
+        if (cancelled(cancel, id + 1)) return -1;
+        if ((ix->symRank[id] >= symLo && ix->symRank[id] < symHi) ||
+            (ix->nameRank[id] >= nameLo && ix->nameRank[id] < nameHi)) continue;
+        if (!sketchHolds(&ix->sketch[2 * id], &q) && !sketchHolds(&ix->sketch[2 * id + 1], &q)) continue;
+        uint64_t key;
+        if (!rankEntry(ix, t, id, fq, qlen, &key)) continue;
+        topkPush(t, key);
+        matches++;
+    }
+    return matches;
+}
+
+// Entries holding every trigram of the query, ranked into t and marked in
+// 'seen' (optional bitmap). Returns matches, -1 if cancelled.
+static int gramMatches(const SymbolIndex* ix, const char* fq, int qlen, TopK* t, uint64_t* seen,
+                       const SymbolCancel* cancel) {
+    uint32_t lists[QUERY_MAX], cursor[QUERY_MAX];
+    int nl = 0, driver = 0;
+    for (int i = 0; i + 3 <= qlen; ++i) {
+        uint32_t key = gramKey(fq + i);
+        bool dup = false;
+        for (int k = 0; k < nl && !dup; ++k) dup = lists[k] == key;
+        if (dup) continue;
+        if (ix->gramStart[key] == ix->gramStart[key + 1]) return 0;
+        lists[nl] = key;
+        cursor[nl] = ix->gramStart[key];
+        uint32_t len = ix->gramStart[key + 1] - ix->gramStart[key];
+        if (len < ix->gramStart[lists[driver] + 1] - ix->gramStart[lists[driver]]) driver = nl;
+        nl++;
+    }
+
+    // Walk the shortest list; the others only move forward
+    int matches = 0;
+    for (uint32_t p = ix->gramStart[lists[driver]]; p < ix->gramStart[lists[driver] + 1]; ++p) {
+        if (cancelled(cancel, p - ix->gramStart[lists[driver]] + 1)) return -1;
+        uint32_t id = ix->gramIds[p];
+        bool all = true;
+        for (int k = 0; k < nl && all; ++k) {
+            if (k == driver) continue;
+            uint32_t end = ix->gramStart[lists[k] + 1], c = cursor[k], step = 1;
+            while (c + step < end && ix->gramIds[c + step] < id) { c += step; step *= 2; }
+            if (c < end && ix->gramIds[c] < id) {
+                // The first id not below the target lies in (c, c + step]
+                uint32_t hi = (c + step < end) ? c + step : end;
+                for (c++; c < hi; ) {
+                    uint32_t mid = c + (hi - c) / 2;
+                    if (ix->gramIds[mid] < id) c = mid + 1; else hi = mid;
+                }
+            }
+            cursor[k] = c;
+            all = c < end && ix->gramIds[c] == id;
+        }
+        uint64_t key;
+        if (!all || hasPrefix(ix->symbol[id], fq, qlen) || !rankEntry(ix, t, id, fq, qlen, &key)) continue;
+        topkPush(t, key);
+        if (seen) seen[id >> 6] |= 1ULL << (id & 63);
+        matches++;
+    }
+    return matches;
+}
+
+// Entries holding the query, from the rank-ordered list of its first
+// trigram. A hit starts with that trigram, so it is listed under its own
+// rank class, and is taken there only. The list runs in key order for
+// unweighted entries, so once t is full and the next posting could not
+// enter it, none after it could either: the rest is left unverified.
+// Weighted entries are ranked up front instead. Marks hits in 'seen' (optional).
+// Returns matches, -1 if cancelled; *unvisited receives how many postings
+// were left.
+static int gramRanked(const SymbolIndex* ix, const char* fq, int qlen, TopK* t, uint64_t* seen,
+                      const SymbolCancel* cancel, uint32_t* unvisited) {
+    uint32_t key = gramKey(fq), begin = ix->rankStart[key], end = ix->rankStart[key + 1];
+    int matches = 0;
+    *unvisited = 0;
+    for (int w = 0; w < t->weightCount; ++w) {
+        uint32_t id = t->weights[w].id;
+        uint64_t k;
+        if (id >= (uint32_t)ix->count || !t->weights[w].weight || hasPrefix(ix->symbol[id], fq, qlen) ||
+            !rankEntry(ix, t, id, fq, qlen, &k)) continue;
+        topkPush(t, k);
+        if (seen) seen[id >> 6] |= 1ULL << (id & 63);
+        matches++;
+    }
+    for (uint32_t p = begin; p < end; ++p) {
+        if (cancelled(cancel, p - begin + 1)) return -1;
+        uint32_t c = ix->rankClass[p], id = ix->rankIds[p];
+        if (t->len == t->cap && (t->cap == 0 || t->keys[0] < classFloor(c, strlen(ix->symbol[id]), id))) {
+            *unvisited = end - p;
+            break;
+        }
+        uint64_t k;
+        if (hasPrefix(ix->symbol[id], fq, qlen) || !rankEntry(ix, t, id, fq, qlen, &k) || keyClass(k) != c ||
+            lightOf(t->weights, t->weightCount, id) != LIGHT_NONE) continue;
+        topkPush(t, k);
+        if (seen) seen[id >> 6] |= 1ULL << (id & 63);
+        matches++;
+    }
+    return matches;
+}
+
+// ---- fuzzy matching ----
+// Myers' bit-parallel edit distance with Hyyro's transposition term (optimal
+// string alignment), semi-global: the query may match anywhere in the text.
+// Bit i of a column vector is the distance delta at query position i; one
+// column per text character costs a dozen word operations, and FUZZY_LANES
+// texts advance in lockstep in one vector.
+#define FUZZY_LANES 4
+
+typedef uint64_t FuzzyBits __attribute__((vector_size(8 * FUZZY_LANES)));
+typedef int32_t  FuzzyInts __attribute__((vector_size(4 * FUZZY_LANES)));
+
+typedef struct {
+    uint64_t eq[256];                 // query positions holding each folded byte
+    TextSketch sketch;                // the query's own codes and pairs
+    uint8_t  charCount[64];           // query positions per character code
+    uint8_t  pairCount[64];           // adjacent position pairs per pair code
+    int      m, budget;
+} FuzzyPattern;
+
+// Edits allowed for a query of qlen characters; 0 = exact only
+static int fuzzyBudget(int qlen) {
+    return (qlen < 4) ? 0 : (qlen < 8) ? 1 : 2;
+}
+
+static void fuzzyCompile(FuzzyPattern* p, const char* fq, int qlen) {
+    memset(p->eq, 0, sizeof(p->eq));
+    for (int i = 0; i < qlen; ++i) {
+        unsigned char c = (unsigned char)fq[i];
+        p->eq[c] |= 1ULL << i;
+        if (c >= 'A' && c <= 'Z') p->eq[c + 32] |= 1ULL << i;
+    }
+    p->eq[0] = 0;
+    memset(p->charCount, 0, sizeof(p->charCount));
+    memset(p->pairCount, 0, sizeof(p->pairCount));
+    for (int i = 0; i < qlen; ++i) {
+        uint32_t c = gramCode((unsigned char)fq[i]);
+        p->charCount[c]++;
+        if (i) p->pairCount[pairCode(gramCode((unsigned char)fq[i - 1]), c)]++;
+    }
+    p->sketch = sketchOf(fq);
+    p->m = qlen;
+    p->budget = fuzzyBudget(qlen);
+}
+
+// Best distance of the pattern in each text, and where that match ends
+static void fuzzyBatch(const FuzzyPattern* p, const char* const texts[FUZZY_LANES],
+                       int64_t dist[FUZZY_LANES], int64_t end[FUZZY_LANES]) {
+    const unsigned char* t[FUZZY_LANES];
+    int len[FUZZY_LANES], maxLen = 0;
+    for (int l = 0; l < FUZZY_LANES; ++l) {
+        t[l] = (const unsigned char*)(texts[l] ? texts[l] : "");
+        len[l] = (int)strlen((const char*)t[l]);
+        if (len[l] > maxLen) maxLen = len[l];
+    }
+    // Past its end a lane sees unmatched columns, which never lower its best
+    const int shift = p->m - 1;
+    FuzzyBits pv = ~(FuzzyBits){0}, mv = {0}, d0Prev = {0}, eqPrev = {0};
+    FuzzyInts score = (FuzzyInts){0} + p->m, best = score, at = (FuzzyInts){0} - 1;
+    for (int j = 0; j < maxLen; ++j) {
+        FuzzyBits eq;
+        for (int l = 0; l < FUZZY_LANES; ++l) eq[l] = (j < len[l]) ? p->eq[t[l][j]] : 0;
+        FuzzyBits d0 = ((((~d0Prev) & eq) << 1) & eqPrev) | (((eq & pv) + pv) ^ pv) | eq | mv;
+        FuzzyBits ph = mv | ~(d0 | pv);
+        FuzzyBits mh = d0 & pv;
+        score += __builtin_convertvector((ph >> shift) & 1, FuzzyInts) - __builtin_convertvector((mh >> shift) & 1, FuzzyInts);
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(d0 | ph);
+        mv = ph & d0;
+        d0Prev = d0;
+        eqPrev = eq;
+
+        FuzzyInts better = score < best;
+        best = (best & ~better) | (score & better);
+        at = (at & ~better) | (((FuzzyInts){0} + j) & better);
+    }
+    for (int l = 0; l < FUZZY_LANES; ++l) { dist[l] = best[l]; end[l] = at[l]; }
+}
+
+// Fuzzy tier: edits, then prefix hits, symbol before name, start, heavier
+// entries, shorter symbols
+static inline uint64_t fuzzyKey(int64_t dist, bool prefix, int field, int64_t pos, uint64_t light, size_t symLen,
+                                uint32_t id) {
+    if (pos < 0) pos = 0;
+    if (pos > 0xFFF) pos = 0xFFF;
+    if (symLen > 0xFF) symLen = 0xFF;
+    return 6ULL << 60 | (uint64_t)dist << 56 | (uint64_t)!prefix << 55 | (uint64_t)field << 54 |
+           (uint64_t)pos << 42 | light << 36 | (uint64_t)symLen << 28 | id;
+}
+
+// Cheap rejection before the distance is run. An edit loses at most one
+// query character, and at most three of its adjacent pairs (a swap), so a
+// text missing more of either cannot match.
+static bool fuzzyMayMatch(const FuzzyPattern* p, const TextSketch* k) {
+    int lost = 0, kept = 0;
+    for (uint64_t missing = p->sketch.chars & ~k->chars; missing; missing &= missing - 1)
+        if ((lost += p->charCount[__builtin_ctzll(missing)]) > p->budget) return false;
+    for (uint64_t have = p->sketch.pairs & k->pairs; have; have &= have - 1)
+        kept += p->pairCount[__builtin_ctzll(have)];
+    return kept >= p->m - 1 - 3 * p->budget;
+}
+
+// Whether entry id is worth a lane at all
+static inline bool fuzzyCandidate(const SymbolIndex* ix, const FuzzyPattern* p, uint32_t id) {
+    return fuzzyMayMatch(p, &ix->sketch[2 * id]) || fuzzyMayMatch(p, &ix->sketch[2 * id + 1]);
+}
+
+// Rank up to FUZZY_LANES non-exact entries; pushes those within the budget.
+// Returns how many matched.
+static int fuzzyRank(const SymbolIndex* ix, const FuzzyPattern* p, const uint32_t* ids, int n, TopK* t) {
+    const char* sym[FUZZY_LANES] = {0};
+    const char* name[FUZZY_LANES] = {0};
+    bool anySym = false, anyName = false;
+    for (int l = 0; l < n; ++l) {
+        if (fuzzyMayMatch(p, &ix->sketch[2 * ids[l]]))     { sym[l] = ix->symbol[ids[l]]; anySym = true; }
+        if (fuzzyMayMatch(p, &ix->sketch[2 * ids[l] + 1])) { name[l] = ix->name[ids[l]]; anyName = true; }
+    }
+    int64_t ds[FUZZY_LANES], es[FUZZY_LANES], dn[FUZZY_LANES], en[FUZZY_LANES];
+    for (int l = 0; l < FUZZY_LANES; ++l) { ds[l] = dn[l] = p->m; es[l] = en[l] = -1; }
+    if (anySym)  fuzzyBatch(p, sym, ds, es);
+    if (anyName) fuzzyBatch(p, name, dn, en);
+
+    int matches = 0;
+    for (int l = 0; l < n; ++l) {
+        int64_t dist = ds[l], end = es[l];
+        int field = 0;
+        if (dn[l] < ds[l]) { dist = dn[l]; end = en[l]; field = 1; }
+        if (dist > p->budget || end < 0) continue;
+        int64_t start = end + 1 - p->m;
+        topkPush(t, fuzzyKey(dist, start <= 0, field, start, lightOf(t->weights, t->weightCount, ids[l]),
+                             strlen(ix->symbol[ids[l]]), ids[l]));
+        matches++;
+    }
+    return matches;
+}
+
+// Fold a query into fq; its length, 0 if empty or too long
+static int foldQuery(const char* query, char fq[QUERY_MAX]) {
+    int qlen = 0;
+    for (; query[qlen]; ++qlen) {
+        if (qlen == QUERY_MAX - 1) return 0;
+        fq[qlen] = (char)fold((unsigned char)query[qlen]);
+    }
+    fq[qlen] = '\0';
+    return qlen;
+}
+
+static bool topkInit(TopK* t, int cap, const SymbolWeight* weights, int weightCount) {
+    *t = (TopK){ NULL, 0, cap > 0 ? cap : 0, weights, weightCount };
+    if (t->cap > 0 && !(t->keys = (uint64_t*)malloc((size_t)t->cap * sizeof(uint64_t)))) {
+        t->cap = 0;
+        return false;
+    }
+    return true;
+}
+
+// Ranked ids of t into out, best first; returns how many
+static int topkDrain(TopK* t, uint32_t* out) {
+    if (t->len > 1) qsort(t->keys, (size_t)t->len, sizeof(uint64_t), cmpU64);
+    for (int k = 0; k < t->len; ++k) out[k] = (uint32_t)(t->keys[k] & (SYMBOL_INDEX_MAX - 1));
+    int n = t->len;
+    free(t->keys);
+    *t = (TopK){ 0 };
+    return n;
+}
+
+int symbolIndexQuery(const SymbolIndex* ix, const char* query, const SymbolWeight* weights, int weightCount,
+                     uint32_t* out, int cap, int* total, const SymbolCancel* cancel) {
+    if (total) *total = 0;
+    if (!ix || !query || cap < 0) return 0;
+    char fq[QUERY_MAX];
+    int qlen = foldQuery(query, fq);
+    if (qlen == 0) return 0;
+    if (!weights || weightCount < 0) weightCount = 0;
+
+    // Symbol prefixes come first: the exact symbol, which sorts first in the
+    // trie range, weighted ones, then the rest already in order
+    uint32_t lo, hi, k;
+    triePrefix(ix, fq, qlen, &lo, &hi);
+    TopK t;
+    topkInit(&t, cap, weights, weightCount);
+    for (k = lo; k < hi && k - lo < (uint32_t)cap && ix->symbol[ix->bySymbol[k]][qlen] == '\0'; ++k)
+        topkPush(&t, prefixKey(ix, &t, ix->bySymbol[k], true));
+    for (int w = 0; w < weightCount; ++w) {
+        uint32_t id = weights[w].id;
+        if (id < (uint32_t)ix->count && weights[w].weight && ix->symRank[id] >= k && ix->symRank[id] < hi)
+            topkPush(&t, prefixKey(ix, &t, id, ix->symbol[id][qlen] == '\0'));
+    }
+    int n = topkDrain(&t, out);
+    for (; k < hi && n < cap; ++k)
+        if (lightOf(weights, weightCount, ix->bySymbol[k]) == LIGHT_NONE) out[n++] = ix->bySymbol[k];
+    int matches = (int)(hi - lo);
+
+    // Then the best of everything else
+    topkInit(&t, cap - n, weights, weightCount);
+    if (qlen < 3) {
+        int hits = shortMatches(ix, fq, qlen, lo, hi, &t, cancel);
+        if (hits < 0) { free(t.keys); return -1; }
+        matches += hits;
+        n += topkDrain(&t, out + n);
+        if (total) *total = matches;
+        return n;
+    }
+
+    // 3+ characters: substrings, then entries within the edit budget when
+    // the exact hits leave room for them. Hits are walked best class first,
+    // which stops after about cap hits, unless another trigram of the query
+    // narrows them so far that intersecting the lists costs less.
+    uint32_t first = gramKey(fq), shortest = UINT32_MAX;
+    for (int i = 0; i + 3 <= qlen; ++i) {
+        uint32_t key = gramKey(fq + i), len = ix->gramStart[key + 1] - ix->gramStart[key];
+        if (len < shortest) shortest = len;
+    }
+    uint64_t firstLen = ix->rankStart[first + 1] - ix->rankStart[first];
+    bool ranked = firstLen <= 8 * (uint64_t)shortest || (uint64_t)cap * firstLen <= 4 * (uint64_t)shortest * shortest;
+    FuzzyPattern fp;
+    fuzzyCompile(&fp, fq, qlen);
+    uint64_t* seen = NULL;
+    if (fp.budget > 0 && matches <= cap) {
+        seen = (uint64_t*)calloc((size_t)ix->count / 64 + 1, sizeof(uint64_t));
+        if (seen)
+            for (uint32_t k = lo; k < hi; ++k) seen[ix->bySymbol[k] >> 6] |= 1ULL << (ix->bySymbol[k] & 63);
+    }
+    uint32_t unvisited = 0;
+    int hits = ranked ? gramRanked(ix, fq, qlen, &t, seen, cancel, &unvisited)
+                      : gramMatches(ix, fq, qlen, &t, seen, cancel);
+    if (hits < 0) { free(seen); free(t.keys); return -1; }
+    matches += hits;
+    if (unvisited) {
+        // Settled early. A three-character exact query is one trigram, whose
+        // list of ids holds exactly its matches; otherwise count the rest as
+        // if every posting left were another hit, but no more than hold
+        // every trigram.
+        matches = (qlen == 3 && codesExact(fq, qlen)) ? (int)(ix->gramStart[first + 1] - ix->gramStart[first])
+                  : (matches + (int64_t)unvisited < shortest) ? matches + (int)unvisited : (int)shortest;
+    } else if (seen && matches <= cap) {
+        uint32_t batch[FUZZY_LANES];
+        int nb = 0;
+        for (uint32_t id = 0; id < (uint32_t)ix->count; ++id) {
+            if (cancelled(cancel, id + 1)) { free(seen); free(t.keys); return -1; }
+            if ((seen[id >> 6] & (1ULL << (id & 63))) || !fuzzyCandidate(ix, &fp, id)) continue;
+            batch[nb++] = id;
+            if (nb == FUZZY_LANES) { matches += fuzzyRank(ix, &fp, batch, nb, &t); nb = 0; }
+        }
+        if (nb) matches += fuzzyRank(ix, &fp, batch, nb, &t);
+    }
+    free(seen);
+    n += topkDrain(&t, out + n);
+
+    if (total) *total = matches;
+    return n;
+}
+
+int symbolIndexRefine(const SymbolIndex* ix, const char* query, const SymbolWeight* weights, int weightCount,
+                      const uint32_t* candidates, int count, uint32_t* out, int cap, int* total,
+                      const SymbolCancel* cancel) {
+    if (total) *total = 0;
+    if (!ix || !query || cap < 0) return 0;
+    char fq[QUERY_MAX];
+    int qlen = foldQuery(query, fq);
+    if (qlen == 0) return 0;
+
+    if (!weights || weightCount < 0) weightCount = 0;
+
+    // Symbol prefixes rank as in the query, ahead of every other tier;
+    // entries that miss exactly are tried fuzzily, a batch at a time
+    FuzzyPattern fp;
+    fuzzyCompile(&fp, fq, qlen);
+    TopK t;
+    topkInit(&t, cap, weights, weightCount);
+    uint32_t batch[FUZZY_LANES];
+    int matches = 0, nb = 0;
+    for (int k = 0; k < count; ++k) {
+        if (cancelled(cancel, (uint32_t)k + 1)) { free(t.keys); return -1; }
+        uint32_t id = candidates[k];
+        uint64_t key;
+        if (id >= (uint32_t)ix->count) continue;
+        if (hasPrefix(ix->symbol[id], fq, qlen)) key = prefixKey(ix, &t, id, ix->symbol[id][qlen] == '\0');
+        else if (!rankEntry(ix, &t, id, fq, qlen, &key)) {
+            if (fp.budget > 0 && fuzzyCandidate(ix, &fp, id)) batch[nb++] = id;
+            if (nb == FUZZY_LANES) { matches += fuzzyRank(ix, &fp, batch, nb, &t); nb = 0; }
+            continue;
+        }
+        topkPush(&t, key);
+        matches++;
+    }
+    if (nb) matches += fuzzyRank(ix, &fp, batch, nb, &t);
+    if (total) *total = matches;
+    return topkDrain(&t, out);
+}
+
+bool symbolIndexNarrows(const char* from, const char* to) {
+    int a = 0;
+    for (; from[a]; ++a)
+        if (fold((unsigned char)from[a]) != fold((unsigned char)to[a])) return false;
+    int b = a + (int)strlen(to + a);
+    if (a == 0 || b < a || b >= QUERY_MAX) return false;
+    return fuzzyBudget(a) == fuzzyBudget(b);                // a bigger budget admits more
+}
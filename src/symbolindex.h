@@ -0,0 +1,82 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Case-insensitive search over a universe of symbols and company names.
+// - A trie over the symbols answers prefix queries: each node covers a
+//   contiguous range of the symbols in sorted order, so the first k prefix
+//   matches come straight out of the range.
+// - Names are also kept sorted, for name prefixes.
+// - A trigram index (posting list of entry ids per 3-character window of
+//   symbol and name) narrows substring queries of 3+ characters to the
+//   entries holding every trigram of the query; those are then verified.
+//   Each trigram also has its postings in rank order (by where a query
+//   starting there would rank, then symbol length): walking the query's
+//   first trigram that way, a top-k query stops verifying as soon as no
+//   later posting could enter the results.
+// - Shorter queries are substring searches too. How many entries hold each
+//   one- and two-character window is counted at build time, so when prefixes
+//   fill the results the total needs no scan; otherwise every entry is
+//   checked against per-entry character sketches and verified.
+// Strings are referenced, not copied: they must outlive the index.
+//
+// - Queries of 4+ characters also find entries within a small edit budget
+//   (1 edit, 2 from 8 characters; a swap of neighbours is one edit), so
+//   "MSTF" finds MSFT and "nvdia" NVDA. These are scored by a bit-parallel
+//   edit distance run over several texts at once, only when the exact hits
+//   do not already fill the results.
+//
+// Ranking, best first: exact symbol, symbol prefix (weighted first, then
+// alphabetical), name prefix, then substring hits by where they start
+// (symbol before name, word starts before mid-word), then fuzzy hits by
+// edits, prefix hits first, symbol before name, by where they start. Ties go
+// to the heavier entry, then the shorter symbol.
+
+typedef struct SymbolIndex SymbolIndex;
+
+#define SYMBOL_INDEX_MAX (1 << 22)            // ids and trie places fit the rank keys
+
+// Lets another thread abandon a long query: polled every few thousand
+// entries; once it returns true the query stops and returns -1.
+typedef struct {
+    bool (*fn)(void* user);
+    void* user;
+} SymbolCancel;
+
+// Weight of one entry, e.g. the size of a held position: among hits that
+// otherwise tie, heavier entries rank first. Weights compare by bit length
+// (1, 2-3, 4-7, ...); 0 means none. Queries take a few of these, each id once.
+typedef struct {
+    uint32_t id;
+    uint32_t weight;
+} SymbolWeight;
+
+// Index 'count' entries, at most SYMBOL_INDEX_MAX; names (or single names)
+// may be NULL. NULL if out of memory or too many.
+SymbolIndex* symbolIndexBuild(const char* const* symbols, const char* const* names, int count);
+void symbolIndexFree(SymbolIndex* ix);
+
+int symbolIndexCount(const SymbolIndex* ix);
+
+// Best matches of 'query', ranked with 'weights' (may be NULL), at most 'cap'
+// entry ids into out; returns how many, -1 if cancelled (cancel may be NULL). *total (optional) receives the number
+// of entries that match at all; when the results settle before every hit is
+// verified it is an estimate from above, and always more than returned
+// unless the results are complete.
+int symbolIndexQuery(const SymbolIndex* ix, const char* query, const SymbolWeight* weights, int weightCount,
+                     uint32_t* out, int cap, int* total, const SymbolCancel* cancel);
+
+// Same ranking, over 'candidates' only: they must hold every match of 'query',
+// e.g. the complete results of a query it extends (see symbolIndexNarrows).
+// Costs O(count) and never touches the index proper; out may be candidates.
+int symbolIndexRefine(const SymbolIndex* ix, const char* query, const SymbolWeight* weights, int weightCount,
+                      const uint32_t* candidates, int count, uint32_t* out, int cap, int* total,
+                      const SymbolCancel* cancel);
+
+// Whether the complete results of 'from' hold every match of 'to', so 'to'
+// can be answered by symbolIndexRefine over them.
+bool symbolIndexNarrows(const char* from, const char* to);
+
+#endif // SYMBOLINDEX_H
@@ -0,0 +1,212 @@
+#include "symbolmaster.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char MASTER_MAGIC[8] = { 'P','F','S','Y','M','0','0','1' };
+#define MASTER_VERSION      1
+#define MASTER_HEADER_BYTES 32
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t stringsOffset;     // from the start of the file
+    uint64_t stringsBytes;
+} MasterHeader;
+
+_Static_assert(sizeof(MasterHeader) == MASTER_HEADER_BYTES, "MasterHeader is part of the file format");
+_Static_assert(sizeof(SymbolRecord) == 24, "SymbolRecord is part of the file format");
+
+struct SymbolMaster {
+    const void*         data;
+    size_t              size;
+    const SymbolRecord* records;
+    const char*         strings;
+    uint32_t            count;
+    uint64_t            stringsBytes;
+};
+
+// ---- writing ----
+// String table under construction, deduplicated through an open-addressing set
+typedef struct {
+    char*     bytes;
+    uint64_t  len, cap;
+    uint32_t* slots;            // offset + 1, 0 = empty
+    uint32_t  slotCount, used;
+} Interner;
+
+static uint32_t hashStr(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) { h ^= (unsigned char)*s; h *= 16777619u; }
+    return h;
+}
+
+static bool internerGrow(Interner* in) {
+    uint32_t n = in->slotCount ? in->slotCount * 2 : 1024;
+    uint32_t* slots = (uint32_t*)calloc(n, sizeof(uint32_t));
+    if (!slots) return false;
+    for (uint32_t i = 0; i < in->slotCount; ++i) {
+        if (!in->slots[i]) continue;
+        uint32_t k = hashStr(in->bytes + in->slots[i] - 1) & (n - 1);
+        while (slots[k]) k = (k + 1) & (n - 1);
+        slots[k] = in->slots[i];
+    }
+    free(in->slots);
+    in->slots = slots;
+    in->slotCount = n;
+    return true;
+}
+
+// Offset of s in the table, appending it the first time. UINT32_MAX if out of memory.
+static uint32_t intern(Interner* in, const char* s) {
+    if (!s) s = "";
+    if ((in->used + 1) * 4 > in->slotCount * 3 && !internerGrow(in)) return UINT32_MAX;
+    uint32_t k = hashStr(s) & (in->slotCount - 1);
+    for (; in->slots[k]; k = (k + 1) & (in->slotCount - 1))
+        if (strcmp(in->bytes + in->slots[k] - 1, s) == 0) return in->slots[k] - 1;
+
+    size_t n = strlen(s) + 1;
+    if (in->len + n >= UINT32_MAX) return UINT32_MAX;
+    if (in->len + n > in->cap) {
+        uint64_t cap = in->cap ? in->cap * 2 : 65536;
+        while (cap < in->len + n) cap *= 2;
+        char* b = (char*)realloc(in->bytes, (size_t)cap);
+        if (!b) return UINT32_MAX;
+        in->bytes = b;
+        in->cap = cap;
+    }
+    uint32_t off = (uint32_t)in->len;
+    memcpy(in->bytes + off, s, n);
+    in->len += n;
+    in->slots[k] = off + 1;
+    in->used++;
+    return off;
+}
+
+static const SymbolInfo* sortInfos;     // symbolMasterWrite is not reentrant
+static int cmpBySymbol(const void* a, const void* b) {
+    const char* x = sortInfos[*(const int*)a].symbol;
+    const char* y = sortInfos[*(const int*)b].symbol;
+    return strcmp(x ? x : "", y ? y : "");
+}
+
+bool symbolMasterWrite(const char* path, const SymbolInfo* infos, int count) {
+    if (count < 0) return false;
+    int* order = (int*)malloc(((size_t)count + 1) * sizeof(int));
+    SymbolRecord* recs = (SymbolRecord*)calloc((size_t)count + 1, sizeof(SymbolRecord));
+    Interner in = {0};
+    bool ok = order && recs;
+    if (ok) {
+        for (int i = 0; i < count; ++i) order[i] = i;
+        sortInfos = infos;
+        qsort(order, (size_t)count, sizeof(int), cmpBySymbol);
+        for (int i = 0; i < count && ok; ++i) {
+            const SymbolInfo* s = &infos[order[i]];
+            SymbolRecord* r = &recs[i];
+            r->symbol   = intern(&in, s->symbol);
+            r->name     = intern(&in, s->name);
+            r->sector   = intern(&in, s->sector);
+            r->exchange = intern(&in, s->exchange);
+            r->lotSize  = s->lotSize;
+            ok = r->symbol != UINT32_MAX && r->name != UINT32_MAX &&
+                 r->sector != UINT32_MAX && r->exchange != UINT32_MAX;
+        }
+    }
+
+    char* tmpPath = NULL;
+    if (ok) {
+        size_t plen = strlen(path);
+        tmpPath = (char*)malloc(plen + 5);
+        ok = tmpPath != NULL;
+        if (ok) { memcpy(tmpPath, path, plen); memcpy(tmpPath + plen, ".tmp", 5); }
+    }
+    if (ok) {
+        MasterHeader h;
+        memcpy(h.magic, MASTER_MAGIC, 8);
+        h.version = MASTER_VERSION;
+        h.count = (uint32_t)count;
+        h.stringsOffset = MASTER_HEADER_BYTES + (uint64_t)count * sizeof(SymbolRecord);
+        h.stringsBytes = in.len;
+        FILE* f = fopen(tmpPath, "wb");
+        ok = f != NULL;
+        if (ok) {
+            ok = fwrite(&h, sizeof(h), 1, f) == 1
+              && fwrite(recs, sizeof(SymbolRecord), (size_t)count, f) == (size_t)count
+              && fwrite(in.bytes, 1, (size_t)in.len, f) == (size_t)in.len
+              && platformFileSync(f);
+            ok = (fclose(f) == 0) && ok;
+        }
+        if (ok) ok = platformReplaceFile(tmpPath, path);
+        if (!ok) remove(tmpPath);
+    }
+    free(tmpPath);
+    free(in.bytes);
+    free(in.slots);
+    free(recs);
+    free(order);
+    return ok;
+}
+
+// ---- reading ----
+SymbolMaster* symbolMasterOpen(const char* path) {
+    size_t size = 0;
+    const void* data = platformMapFile(path, &size);
+    if (!data) return NULL;
+
+    MasterHeader h;
+    bool ok = size >= MASTER_HEADER_BYTES;
+    if (ok) {
+        memcpy(&h, data, sizeof(h));
+        uint64_t recBytes = (uint64_t)h.count * sizeof(SymbolRecord);
+        ok = memcmp(h.magic, MASTER_MAGIC, 8) == 0 && h.version == MASTER_VERSION
+          && h.stringsOffset == MASTER_HEADER_BYTES + recBytes
+          && h.stringsBytes > 0 && h.stringsBytes <= UINT32_MAX
+          && h.stringsOffset + h.stringsBytes <= size
+          && ((const char*)data)[h.stringsOffset + h.stringsBytes - 1] == '\0';
+    }
+    SymbolMaster* m = ok ? (SymbolMaster*)calloc(1, sizeof(SymbolMaster)) : NULL;
+    if (!m) {
+        if (!ok) fprintf(stderr, "Symbol master: %s is not a valid master file\n", path);
+        platformUnmapFile(data, size);
+        return NULL;
+    }
+    m->data = data;
+    m->size = size;
+    m->count = h.count;
+    m->records = (const SymbolRecord*)((const char*)data + MASTER_HEADER_BYTES);
+    m->strings = (const char*)data + h.stringsOffset;
+    m->stringsBytes = h.stringsBytes;
+    return m;
+}
+
+void symbolMasterClose(SymbolMaster* m) {
+    if (!m) return;
+    platformUnmapFile(m->data, m->size);
+    free(m);
+}
+
+int symbolMasterCount(const SymbolMaster* m) {
+    return m ? (int)m->count : 0;
+}
+
+const SymbolRecord* symbolMasterRecord(const SymbolMaster* m, int i) {
+    return &m->records[i];
+}
+
+const char* symbolMasterString(const SymbolMaster* m, uint32_t offset) {
+    return (offset < m->stringsBytes) ? m->strings + offset : "";
+}
+
+int symbolMasterFind(const SymbolMaster* m, const char* symbol) {
+    if (!m) return -1;
+    int lo = 0, hi = (int)m->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int c = strcmp(symbolMasterString(m, m->records[mid].symbol), symbol);
+        if (c == 0) return mid;
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return -1;
+}
@@ -0,0 +1,57 @@
+#ifndef SYMBOLMASTER_H
+#define SYMBOLMASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Instrument master: every tradable symbol with its name, sector, exchange
+// and lot size, in one binary file that is memory-mapped, never parsed.
+//
+// On disk: a 32-byte header (magic, version, record count, string table
+// offset and size), 'count' fixed-size records sorted by symbol, then the
+// string table. Records hold byte offsets into the table, whose strings are
+// NUL-terminated and interned: a sector or exchange named by 50k records is
+// stored once. Opening maps the file and checks the header and the table's
+// bounds, which is all the loading there is; strings are handed out as
+// pointers into the mapping.
+
+typedef struct {
+    uint32_t symbol, name, sector, exchange;   // offsets into the string table
+    int32_t  lotSize;
+    uint32_t reserved;
+} SymbolRecord;
+
+// One instrument for symbolMasterWrite
+typedef struct {
+    const char* symbol;
+    const char* name;
+    const char* sector;
+    const char* exchange;
+    int         lotSize;
+} SymbolInfo;
+
+typedef struct SymbolMaster SymbolMaster;
+
+// Write 'count' instruments to 'path' (via '<path>.tmp', synced, then renamed
+// over it), sorted by symbol with strings interned. NULL fields are stored as "".
+bool symbolMasterWrite(const char* path, const SymbolInfo* infos, int count);
+
+// Map and check the file. NULL if missing or malformed.
+SymbolMaster* symbolMasterOpen(const char* path);
+void symbolMasterClose(SymbolMaster* m);
+
+int symbolMasterCount(const SymbolMaster* m);
+const SymbolRecord* symbolMasterRecord(const SymbolMaster* m, int i);
+
+// String at a table offset; "" if the offset is out of range
+const char* symbolMasterString(const SymbolMaster* m, uint32_t offset);
+
+static inline const char* symbolMasterSymbol(const SymbolMaster* m, int i) { return symbolMasterString(m, symbolMasterRecord(m, i)->symbol); }
+static inline const char* symbolMasterName(const SymbolMaster* m, int i)   { return symbolMasterString(m, symbolMasterRecord(m, i)->name); }
+static inline const char* symbolMasterSector(const SymbolMaster* m, int i) { return symbolMasterString(m, symbolMasterRecord(m, i)->sector); }
+static inline const char* symbolMasterExchange(const SymbolMaster* m, int i) { return symbolMasterString(m, symbolMasterRecord(m, i)->exchange); }
+
+// Record index of an exact symbol (binary search), -1 if absent
+int symbolMasterFind(const SymbolMaster* m, const char* symbol);
+
+#endif // SYMBOLMASTER_H
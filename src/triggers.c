@@ -0,0 +1,177 @@
+#include "triggers.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NIL 0u     // slot 0 is never used
+
+typedef struct {
+    Money    threshold;
+    uint32_t pos;      // index in its heap while pending; next free slot otherwise
+    uint32_t gen;
+    uint32_t seq;      // insertion order, breaks threshold ties
+    uint32_t tag;
+    int32_t  arg;
+    uint8_t  dir;
+    uint8_t  live;
+} Trigger;
+
+struct TriggerSet {
+    Trigger*  nodes;
+    uint32_t  cap;
+    uint32_t  freeHead;
+    uint32_t* heap[2];     // slots, heap-ordered per TriggerDir
+    uint32_t  len[2];
+    uint32_t  nextSeq;
+    TriggerFireFn onFire;
+    void*     user;
+};
+
+// True if slot a must fire before slot b in heap 'dir'.
+static inline bool firesFirst(const TriggerSet* ts, int dir, uint32_t a, uint32_t b) {
+    const Trigger* x = &ts->nodes[a];
+    const Trigger* y = &ts->nodes[b];
+    if (x->threshold != y->threshold)
+        return (dir == TRIGGER_ABOVE) ? x->threshold < y->threshold : x->threshold > y->threshold;
+    return (int32_t)(x->seq - y->seq) < 0;
+}
+
+static inline void heapPlace(TriggerSet* ts, int dir, uint32_t i, uint32_t slot) {
+    ts->heap[dir][i] = slot;
+    ts->nodes[slot].pos = i;
+}
+
+static void siftUp(TriggerSet* ts, int dir, uint32_t i) {
+    uint32_t slot = ts->heap[dir][i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!firesFirst(ts, dir, slot, ts->heap[dir][parent])) break;
+        heapPlace(ts, dir, i, ts->heap[dir][parent]);
+        i = parent;
+    }
+    heapPlace(ts, dir, i, slot);
+}
+
+static void siftDown(TriggerSet* ts, int dir, uint32_t i) {
+    uint32_t n = ts->len[dir];
+    uint32_t slot = ts->heap[dir][i];
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && firesFirst(ts, dir, ts->heap[dir][c + 1], ts->heap[dir][c])) c++;
+        if (!firesFirst(ts, dir, ts->heap[dir][c], slot)) break;
+        heapPlace(ts, dir, i, ts->heap[dir][c]);
+        i = c;
+    }
+    heapPlace(ts, dir, i, slot);
+}
+
+// Take slot out of its heap and put it on the free list.
+static void removeSlot(TriggerSet* ts, uint32_t slot) {
+    Trigger* t = &ts->nodes[slot];
+    int dir = t->dir;
+    uint32_t i = t->pos;
+    uint32_t last = ts->heap[dir][--ts->len[dir]];
+    if (last != slot) {
+        heapPlace(ts, dir, i, last);
+        siftDown(ts, dir, i);
+        siftUp(ts, dir, ts->nodes[last].pos);
+    }
+    t->live = 0;
+    t->gen++;
+    t->pos = ts->freeHead;
+    ts->freeHead = slot;
+}
+
+static bool growTo(TriggerSet* ts, uint32_t cap) {
+    Trigger* nodes = (Trigger*)realloc(ts->nodes, (size_t)cap * sizeof(Trigger));
+    if (!nodes) return false;
+    ts->nodes = nodes;
+    for (int d = 0; d < 2; ++d) {
+        uint32_t* h = (uint32_t*)realloc(ts->heap[d], (size_t)cap * sizeof(uint32_t));
+        if (!h) return false;
+        ts->heap[d] = h;
+    }
+    // New slots join the free list in order
+    for (uint32_t i = ts->cap; i < cap; ++i) {
+        memset(&nodes[i], 0, sizeof(Trigger));
+        nodes[i].gen = 1;
+        nodes[i].pos = (i + 1 < cap) ? i + 1 : ts->freeHead;
+    }
+    ts->freeHead = (ts->cap == 0) ? 1 : ts->cap;   // slot 0 stays unused
+    ts->cap = cap;
+    return true;
+}
+
+TriggerSet* triggerSetCreate(int initialCapacity) {
+    TriggerSet* ts = (TriggerSet*)calloc(1, sizeof(TriggerSet));
+    if (!ts) return NULL;
+    uint32_t cap = (initialCapacity > 16) ? (uint32_t)initialCapacity + 1 : 17;
+    if (!growTo(ts, cap)) { triggerSetFree(ts); return NULL; }
+    return ts;
+}
+
+void triggerSetFree(TriggerSet* ts) {
+    if (!ts) return;
+    free(ts->nodes);
+    free(ts->heap[0]);
+    free(ts->heap[1]);
+    free(ts);
+}
+
+void triggerSetHandler(TriggerSet* ts, TriggerFireFn fn, void* user) {
+    ts->onFire = fn;
+    ts->user   = user;
+}
+
+TriggerId triggerAdd(TriggerSet* ts, TriggerDir dir, Money threshold, uint32_t tag, int32_t arg) {
+    if (ts->freeHead == NIL && !growTo(ts, ts->cap * 2)) return 0;
+    uint32_t slot = ts->freeHead;
+    Trigger* t = &ts->nodes[slot];
+    ts->freeHead = t->pos;
+    t->threshold = threshold;
+    t->seq  = ts->nextSeq++;
+    t->tag  = tag;
+    t->arg  = arg;
+    t->dir  = (uint8_t)dir;
+    t->live = 1;
+    heapPlace(ts, dir, ts->len[dir]++, slot);
+    siftUp(ts, dir, t->pos);
+    return ((uint64_t)t->gen << 32) | slot;
+}
+
+bool triggerCancel(TriggerSet* ts, TriggerId id) {
+    uint32_t slot = (uint32_t)id;
+    if (slot == NIL || slot >= ts->cap) return false;
+    Trigger* t = &ts->nodes[slot];
+    if (!t->live || t->gen != (uint32_t)(id >> 32)) return false;
+    removeSlot(ts, slot);
+    return true;
+}
+
+int triggerSetTick(TriggerSet* ts, Money price) {
+    int fired = 0;
+    for (int dir = 0; dir < 2; ++dir) {
+        while (ts->len[dir] > 0) {
+            uint32_t slot = ts->heap[dir][0];
+            const Trigger* t = &ts->nodes[slot];
+            bool reached = (dir == TRIGGER_ABOVE) ? price >= t->threshold : price <= t->threshold;
+            if (!reached) break;             // the nearest one is not reached, so none are
+
+            TriggerFire f = { ((uint64_t)t->gen << 32) | slot, (TriggerDir)dir, t->threshold, price, t->tag, t->arg };
+            removeSlot(ts, slot);
+            fired++;
+            if (ts->onFire) ts->onFire(&f, ts->user);
+        }
+    }
+    return fired;
+}
+
+bool triggerNearest(const TriggerSet* ts, TriggerDir dir, Money* threshold) {
+    if (ts->len[dir] == 0) return false;
+    *threshold = ts->nodes[ts->heap[dir][0]].threshold;
+    return true;
+}
+
+int triggerSetCount(const TriggerSet* ts) {
+    return (int)(ts->len[0] + ts->len[1]);
+}
@@ -0,0 +1,56 @@
+#ifndef TRIGGERS_H
+#define TRIGGERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "money.h"
+
+// Price triggers for one symbol (stop-loss, take-profit, alerts).
+// Pending triggers sit in two binary heaps keyed by threshold: a min-heap of
+// "fire at or above" and a max-heap of "fire at or below". A tick only looks
+// at the two heap tops, the nearest pending threshold on each side, so it is
+// O(1) unless something fires (O(log n) per fired trigger), however many are
+// pending. Each trigger records its heap position, so cancel is O(log n).
+// Triggers with equal thresholds fire in the order they were added.
+// The pool grows in triggerAdd only; ticks never allocate.
+
+typedef enum { TRIGGER_ABOVE = 0, TRIGGER_BELOW = 1 } TriggerDir;
+
+// Slot + generation, like order ids; 0 = none.
+typedef uint64_t TriggerId;
+
+typedef struct {
+    TriggerId  id;
+    TriggerDir dir;
+    Money      threshold;
+    Money      price;      // the tick that fired it
+    uint32_t   tag;        // caller's data, as passed to triggerAdd
+    int32_t    arg;
+} TriggerFire;
+
+// Called once per fired trigger, after it has been removed. May add or cancel triggers.
+typedef void (*TriggerFireFn)(const TriggerFire* f, void* user);
+
+typedef struct TriggerSet TriggerSet;
+
+TriggerSet* triggerSetCreate(int initialCapacity);
+void triggerSetFree(TriggerSet* ts);
+void triggerSetHandler(TriggerSet* ts, TriggerFireFn fn, void* user);
+
+// Arm a trigger that fires on the first tick at or beyond 'threshold' in 'dir'
+// (including the next tick, if the price is already there). 0 if out of memory.
+TriggerId triggerAdd(TriggerSet* ts, TriggerDir dir, Money threshold, uint32_t tag, int32_t arg);
+
+// Disarm a pending trigger. False if it already fired or was cancelled.
+bool triggerCancel(TriggerSet* ts, TriggerId id);
+
+// Feed a price; fires every trigger it reaches. Returns the number fired.
+int triggerSetTick(TriggerSet* ts, Money price);
+
+// Nearest pending threshold in 'dir', O(1). False if none.
+bool triggerNearest(const TriggerSet* ts, TriggerDir dir, Money* threshold);
+
+// Pending triggers.
+int triggerSetCount(const TriggerSet* ts);
+
+#endif // TRIGGERS_H
@@ -0,0 +1,153 @@
+#include "widgets.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GRID_CELLS (WIDGET_GRID * WIDGET_GRID)
+
+struct WidgetTree {
+    Widget* nodes;
+    int     count, cap;
+    int     firstRoot;
+    bool    dirty;
+
+    int* order;                 // shown nodes in paint order
+    int  orderCount;
+    int  cellStart[GRID_CELLS + 1];
+    int* cellIds;               // per cell, hittable nodes in paint order
+    int  cellIdsCap;
+};
+
+WidgetTree* widgetTreeCreate(void) {
+    WidgetTree* t = (WidgetTree*)calloc(1, sizeof(WidgetTree));
+    if (!t) return NULL;
+    t->firstRoot = WIDGET_NONE;
+    t->dirty = true;
+    return t;
+}
+
+void widgetTreeFree(WidgetTree* t) {
+    if (!t) return;
+    free(t->nodes);
+    free(t->order);
+    free(t->cellIds);
+    free(t);
+}
+
+int widgetAdd(WidgetTree* t, int parent, int tag, int arg, float x, float y, float w, float h, int z, unsigned flags) {
+    if (t->count == t->cap) {
+        int cap = t->cap ? t->cap * 2 : 64;
+        Widget* n = (Widget*)realloc(t->nodes, (size_t)cap * sizeof(Widget));
+        int* o = (int*)realloc(t->order, (size_t)cap * sizeof(int));
+        if (n) t->nodes = n;
+        if (o) t->order = o;
+        if (!n || !o) return WIDGET_NONE;
+        t->cap = cap;
+    }
+    int id = t->count++;
+    t->nodes[id] = (Widget){ x, y, w, h, tag, arg, z, flags, parent, WIDGET_NONE, WIDGET_NONE };
+
+    // Link after the last sibling with z <= ours
+    int* link = (parent == WIDGET_NONE) ? &t->firstRoot : &t->nodes[parent].firstChild;
+    while (*link != WIDGET_NONE && t->nodes[*link].z <= z) link = &t->nodes[*link].next;
+    t->nodes[id].next = *link;
+    *link = id;
+    t->dirty = true;
+    return id;
+}
+
+const Widget* widgetGet(const WidgetTree* t, int id) {
+    return &t->nodes[id];
+}
+
+void widgetSetVisible(WidgetTree* t, int id, bool visible) {
+    unsigned flags = visible ? (t->nodes[id].flags & ~(unsigned)WIDGET_HIDDEN)
+                             : (t->nodes[id].flags | WIDGET_HIDDEN);
+    if (flags == t->nodes[id].flags) return;
+    t->nodes[id].flags = flags;
+    t->dirty = true;
+}
+
+void widgetSetRect(WidgetTree* t, int id, float x, float y, float w, float h) {
+    Widget* n = &t->nodes[id];
+    if (n->x == x && n->y == y && n->w == w && n->h == h) return;
+    n->x = x; n->y = y; n->w = w; n->h = h;
+    t->dirty = true;
+}
+
+// Grid column / row span of a node, clamped to the window
+static int cellOf(float v) {
+    int c = (int)((v + 1.0f) * 0.5f * WIDGET_GRID);
+    return (c < 0) ? 0 : (c >= WIDGET_GRID) ? WIDGET_GRID - 1 : c;
+}
+static bool nodeCells(const Widget* n, int* c0, int* c1, int* r0, int* r1) {
+    if (n->x > 1.0f || n->x + n->w < -1.0f || n->y < -1.0f || n->y - n->h > 1.0f) return false;
+    *c0 = cellOf(n->x);  *c1 = cellOf(n->x + n->w);
+    *r0 = cellOf(-n->y); *r1 = cellOf(-(n->y - n->h));    // rows count down from the top
+    return true;
+}
+
+static void rebuild(WidgetTree* t) {
+    // Paint order: depth first, skipping hidden subtrees. The tree is shallow,
+    // but walk it with the parent links rather than recursion anyway.
+    t->orderCount = 0;
+    int id = t->firstRoot;
+    while (id != WIDGET_NONE) {
+        const Widget* n = &t->nodes[id];
+        if (!(n->flags & WIDGET_HIDDEN)) {
+            t->order[t->orderCount++] = id;
+            if (n->firstChild != WIDGET_NONE) { id = n->firstChild; continue; }
+        }
+        while (id != WIDGET_NONE && t->nodes[id].next == WIDGET_NONE) id = t->nodes[id].parent;
+        if (id != WIDGET_NONE) id = t->nodes[id].next;
+    }
+
+    // Grid: count per cell, prefix sums, then fill in paint order
+    memset(t->cellStart, 0, sizeof(t->cellStart));
+    for (int k = 0; k < t->orderCount; ++k) {
+        const Widget* n = &t->nodes[t->order[k]];
+        int c0, c1, r0, r1;
+        if (!(n->flags & WIDGET_HITTABLE) || !nodeCells(n, &c0, &c1, &r0, &r1)) continue;
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) t->cellStart[r * WIDGET_GRID + c + 1]++;
+    }
+    for (int c = 0; c < GRID_CELLS; ++c) t->cellStart[c + 1] += t->cellStart[c];
+    int total = t->cellStart[GRID_CELLS];
+    if (total > t->cellIdsCap) {
+        int* ids = (int*)realloc(t->cellIds, (size_t)total * sizeof(int));
+        if (!ids) { memset(t->cellStart, 0, sizeof(t->cellStart)); return; }     // no hits, retried next call
+        t->cellIds = ids;
+        t->cellIdsCap = total;
+    }
+    int fill[GRID_CELLS];
+    memcpy(fill, t->cellStart, sizeof(fill));
+    for (int k = 0; k < t->orderCount; ++k) {
+        const Widget* n = &t->nodes[t->order[k]];
+        int c0, c1, r0, r1;
+        if (!(n->flags & WIDGET_HITTABLE) || !nodeCells(n, &c0, &c1, &r0, &r1)) continue;
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) t->cellIds[fill[r * WIDGET_GRID + c]++] = t->order[k];
+    }
+    t->dirty = false;
+}
+
+int widgetPaintOrder(WidgetTree* t, const int** ids) {
+    if (t->dirty) rebuild(t);
+    *ids = t->order;
+    return t->orderCount;
+}
+
+int widgetHitTest(WidgetTree* t, float x, float y) {
+    if (x < -1.0f || x > 1.0f || y < -1.0f || y > 1.0f) return WIDGET_NONE;
+    if (t->dirty) rebuild(t);
+    int cell = cellOf(-y) * WIDGET_GRID + cellOf(x);
+    for (int k = t->cellStart[cell + 1] - 1; k >= t->cellStart[cell]; --k) {
+        const Widget* n = &t->nodes[t->cellIds[k]];
+        if (x >= n->x && x <= n->x + n->w && y <= n->y && y >= n->y - n->h) return t->cellIds[k];
+    }
+    return WIDGET_NONE;
+}
+
+int widgetTagAt(WidgetTree* t, float x, float y, int none) {
+    int id = widgetHitTest(t, x, y);
+    return (id == WIDGET_NONE) ? none : t->nodes[id].tag;
+}
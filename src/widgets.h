@@ -0,0 +1,59 @@
+#ifndef WIDGETS_H
+#define WIDGETS_H
+
+#include <stdbool.h>
+
+// Retained widget tree.
+// Each piece of the UI is a node with an NDC rect (top-left origin, like
+// createRectangle), a z among its siblings and the caller's tag. Siblings
+// paint in ascending z (insertion order within one z) and children paint
+// after their parent, so one depth-first walk gives the paint order and its
+// reverse the hit order. Hiding a node hides its whole subtree.
+// Hit testing goes through a uniform grid over the window: every cell lists
+// the hittable nodes overlapping it in paint order, so a point scans one short
+// list from the top whatever the widget count. The order and the grid are
+// rebuilt lazily after the tree changes (tab switches, a modal opening), not
+// per frame.
+
+#define WIDGET_NONE (-1)
+#define WIDGET_GRID 16          // hit grid cells per axis over [-1,1]
+
+enum {
+    WIDGET_HITTABLE = 1,        // receives clicks; otherwise clicks pass through
+    WIDGET_HIDDEN   = 2,
+};
+
+typedef struct {
+    float    x, y, w, h;        // NDC rect, top-left origin
+    int      tag, arg;          // caller's kind and index
+    int      z;
+    unsigned flags;
+    int      parent, firstChild, next;
+} Widget;
+
+typedef struct WidgetTree WidgetTree;
+
+WidgetTree* widgetTreeCreate(void);
+void widgetTreeFree(WidgetTree* t);
+
+// Add a node under 'parent' (WIDGET_NONE: a root). Returns its id, or
+// WIDGET_NONE if out of memory.
+int widgetAdd(WidgetTree* t, int parent, int tag, int arg, float x, float y, float w, float h, int z, unsigned flags);
+
+// Node by id. The pointer is valid until the next widgetAdd.
+const Widget* widgetGet(const WidgetTree* t, int id);
+
+// Show or hide a node and its subtree; a no-op when nothing changes.
+void widgetSetVisible(WidgetTree* t, int id, bool visible);
+void widgetSetRect(WidgetTree* t, int id, float x, float y, float w, float h);
+
+// Shown nodes back to front. The array is valid until the tree next changes.
+int widgetPaintOrder(WidgetTree* t, const int** ids);
+
+// Topmost shown, hittable node containing the point, WIDGET_NONE if none.
+int widgetHitTest(WidgetTree* t, float x, float y);
+
+// Tag of the node at a point, 'none' if there is none.
+int widgetTagAt(WidgetTree* t, float x, float y, int none);
+
+#endif // WIDGETS_H